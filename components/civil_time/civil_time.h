@@ -0,0 +1,73 @@
+#pragma once
+
+// Allocation free conversions between civil (proleptic Gregorian) dates and Unix time, without newlib's
+// TZ handling and locking. Days from civil after H. Hinnant, "chrono-Compatible Low-Level Date Algorithms".
+// All functions are pure and inline, so they can be used in the hot paths and built on any host.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#define CIVIL_SECONDS_PER_DAY 86400
+
+static inline bool civil_is_leap(int32_t year) { return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0; }
+
+// days since 1970-01-01 of year-month-day, month 1..12, day 1..31
+static inline int32_t civil_days_from_civil(int32_t year, uint32_t month, uint32_t day) {
+    year -= month <= 2;
+    const int32_t era = (year >= 0 ? year : year - 399) / 400;
+    const uint32_t yoe = (uint32_t)(year - era * 400);                                 // [0, 399]
+    const uint32_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;  // [0, 365]
+    const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;                         // [0, 146096]
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+// inverse of civil_days_from_civil
+static inline void civil_from_days(int32_t days, int32_t *year, uint32_t *month, uint32_t *day) {
+    days += 719468;
+    const int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const uint32_t doe = (uint32_t)(days - era * 146097);                          // [0, 146096]
+    const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;  // [0, 399]
+    const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);                 // [0, 365]
+    const uint32_t mp = (5 * doy + 2) / 153;                                      // [0, 11]
+    *day = doy - (153 * mp + 2) / 5 + 1;
+    *month = mp < 10 ? mp + 3 : mp - 9;
+    *year = (int32_t)yoe + era * 400 + (*month <= 2);
+}
+
+// 0 = Sunday .. 6 = Saturday
+static inline uint32_t civil_weekday(int32_t days) {
+    return (uint32_t)(days >= -4 ? (days + 4) % 7 : (days + 5) % 7 + 6);
+}
+
+// Unix time of a civil date and time, all fields in the same time zone
+static inline int64_t civil_to_unix(int32_t year, uint32_t month, uint32_t day, uint32_t hour, uint32_t minute,
+                                    uint32_t second) {
+    return (int64_t)civil_days_from_civil(year, month, day) * CIVIL_SECONDS_PER_DAY + hour * 3600 + minute * 60 +
+           second;
+}
+
+// day of year 1..366 to Unix time
+static inline int64_t civil_yday_to_unix(int32_t year, uint32_t yday, uint32_t hour, uint32_t minute,
+                                         uint32_t second) {
+    return (int64_t)(civil_days_from_civil(year, 1, 1) + (int32_t)yday - 1) * CIVIL_SECONDS_PER_DAY + hour * 3600 +
+           minute * 60 + second;
+}
+
+// UTC broken down time of a Unix time, replacement for gmtime_r()
+static inline void civil_from_unix(int64_t t, struct tm *tm_out) {
+    int32_t days = (int32_t)((t >= 0 ? t : t - CIVIL_SECONDS_PER_DAY + 1) / CIVIL_SECONDS_PER_DAY);
+    uint32_t secs = (uint32_t)(t - (int64_t)days * CIVIL_SECONDS_PER_DAY);
+    int32_t year;
+    uint32_t month, day;
+    civil_from_days(days, &year, &month, &day);
+    tm_out->tm_year = year - 1900;
+    tm_out->tm_mon = (int)month - 1;
+    tm_out->tm_mday = (int)day;
+    tm_out->tm_hour = (int)(secs / 3600);
+    tm_out->tm_min = (int)(secs / 60 % 60);
+    tm_out->tm_sec = (int)(secs % 60);
+    tm_out->tm_wday = (int)civil_weekday(days);
+    tm_out->tm_yday = days - civil_days_from_civil(year, 1, 1);
+    tm_out->tm_isdst = 0;
+}
@@ -0,0 +1,194 @@
+#include "clock_select.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#define CLOCK_MAX_SOURCES 8
+
+typedef struct {
+    int index;
+    int64_t offset_us;
+    int64_t delay_us;
+    int64_t dispersion_us;
+    int64_t jitter_us;
+    int64_t root_distance_us;
+    int64_t metric;  // lower is better, stratum first
+} clock_candidate_t;
+
+typedef struct {
+    int64_t value;
+    int type;  // -1 lower end, 0 midpoint, +1 upper end
+} clock_endpoint_t;
+
+void clock_source_add_sample(clock_source_t *source, const clock_sample_t *sample) {
+    source->samples[source->next_sample] = *sample;
+    source->next_sample = (source->next_sample + 1) % CLOCK_FILTER_SIZE;
+    if (source->sample_count < CLOCK_FILTER_SIZE) {
+        source->sample_count++;
+    }
+    source->fresh = true;
+}
+
+void clock_source_correct(clock_source_t *source, int64_t correction_us) {
+    for (int i = 0; i < source->sample_count; i++) {
+        source->samples[i].offset_us -= correction_us;
+    }
+}
+
+// clock filter: the sample with the lowest delay has the smallest error, the newest one of equal delays (a
+// reference clock always reports 0), the jitter is the RMS difference of the other samples to it
+static bool clock_filter(const clock_source_t *source, int64_t now_us, clock_candidate_t *candidate) {
+    if (source->sample_count == 0 || source->stratum >= CLOCK_STRATUM_UNSYNC) {
+        return false;
+    }
+    const clock_sample_t *best = NULL;
+    int64_t newest = INT64_MIN;
+    for (int i = 0; i < source->sample_count; i++) {
+        const clock_sample_t *s = &source->samples[i];
+        if (best == NULL || s->delay_us < best->delay_us ||
+            (s->delay_us == best->delay_us && s->time_us > best->time_us)) {
+            best = s;
+        }
+        if (s->time_us > newest) {
+            newest = s->time_us;
+        }
+    }
+    if (now_us - newest > source->timeout_us) {
+        return false;
+    }
+    double sum = 0;
+    for (int i = 0; i < source->sample_count; i++) {
+        double d = (double)(source->samples[i].offset_us - best->offset_us);
+        sum += d * d;
+    }
+    candidate->offset_us = best->offset_us;
+    candidate->delay_us = best->delay_us;
+    candidate->dispersion_us = best->dispersion_us + (now_us - best->time_us) * CLOCK_PHI_PPM / 1000000;
+    candidate->jitter_us = source->sample_count > 1 ? (int64_t)sqrt(sum / (source->sample_count - 1)) : 0;
+    candidate->root_distance_us = (source->root_delay_us + candidate->delay_us) / 2 + source->root_dispersion_us +
+                                  candidate->dispersion_us + candidate->jitter_us;
+    candidate->metric = source->stratum * (int64_t)CLOCK_MAXDIST_US + candidate->root_distance_us;
+    return candidate->root_distance_us < CLOCK_MAXDIST_US;
+}
+
+static int compare_endpoints(const void *a, const void *b) {
+    const clock_endpoint_t *x = a, *y = b;
+    if (x->value != y->value) {
+        return x->value < y->value ? -1 : 1;
+    }
+    return x->type - y->type;
+}
+
+static int compare_metric(const void *a, const void *b) {
+    const clock_candidate_t *x = a, *y = b;
+    return x->metric < y->metric ? -1 : x->metric > y->metric;
+}
+
+// intersection algorithm: the smallest interval containing the midpoints of a majority of the
+// correctness intervals [offset - root distance, offset + root distance], falsetickers are removed
+static int clock_intersect(clock_candidate_t *candidates, int n) {
+    clock_endpoint_t endpoints[3 * CLOCK_MAX_SOURCES];
+    for (int i = 0; i < n; i++) {
+        endpoints[3 * i] = (clock_endpoint_t){candidates[i].offset_us - candidates[i].root_distance_us, -1};
+        endpoints[3 * i + 1] = (clock_endpoint_t){candidates[i].offset_us, 0};
+        endpoints[3 * i + 2] = (clock_endpoint_t){candidates[i].offset_us + candidates[i].root_distance_us, 1};
+    }
+    qsort(endpoints, 3 * n, sizeof(endpoints[0]), compare_endpoints);
+
+    for (int allow = 0; 2 * allow < n; allow++) {
+        int64_t low = INT64_MAX, high = INT64_MIN;
+        int found = 0, chime = 0;
+        for (int i = 0; i < 3 * n; i++) {
+            chime -= endpoints[i].type;
+            if (chime >= n - allow) {
+                low = endpoints[i].value;
+                break;
+            }
+            found += endpoints[i].type == 0;
+        }
+        chime = 0;
+        for (int i = 3 * n - 1; i >= 0; i--) {
+            chime += endpoints[i].type;
+            if (chime >= n - allow) {
+                high = endpoints[i].value;
+                break;
+            }
+            found += endpoints[i].type == 0;
+        }
+        if (found > allow || low > high) {
+            continue;
+        }
+        int survivors = 0;
+        for (int i = 0; i < n; i++) {
+            if (candidates[i].offset_us >= low && candidates[i].offset_us <= high) {
+                candidates[survivors++] = candidates[i];
+            }
+        }
+        return survivors;
+    }
+    return 0;
+}
+
+// cluster algorithm: drop the survivor with the largest selection jitter as long as it is larger than
+// the smallest source jitter, i.e. removing it still improves the result
+static int clock_cluster(clock_candidate_t *candidates, int n, int64_t *jitter_us) {
+    while (1) {
+        double max_jitter = -1;
+        int64_t min_source_jitter = INT64_MAX;
+        int worst = 0;
+        for (int i = 0; i < n; i++) {
+            double sum = 0;
+            for (int j = 0; j < n; j++) {
+                double d = (double)(candidates[i].offset_us - candidates[j].offset_us);
+                sum += d * d;
+            }
+            double jitter = n > 1 ? sqrt(sum / (n - 1)) : 0;
+            if (jitter > max_jitter) {
+                max_jitter = jitter;
+                worst = i;
+            }
+            if (candidates[i].jitter_us < min_source_jitter) {
+                min_source_jitter = candidates[i].jitter_us;
+            }
+        }
+        *jitter_us = (int64_t)max_jitter;
+        if (n <= CLOCK_MIN_CLUSTER || max_jitter <= min_source_jitter) {
+            return n;
+        }
+        for (int i = worst; i < n - 1; i++) {
+            candidates[i] = candidates[i + 1];
+        }
+        n--;
+    }
+}
+
+bool clock_select(const clock_source_t *sources, int source_count, int64_t now_us, clock_selection_t *selection) {
+    clock_candidate_t candidates[CLOCK_MAX_SOURCES];
+    int n = 0;
+    for (int i = 0; i < source_count && n < CLOCK_MAX_SOURCES; i++) {
+        if (clock_filter(&sources[i], now_us, &candidates[n])) {
+            candidates[n++].index = i;
+        }
+    }
+    n = n > 0 ? clock_intersect(candidates, n) : 0;
+    if (n == 0) {
+        return false;
+    }
+    qsort(candidates, n, sizeof(candidates[0]), compare_metric);
+    n = clock_cluster(candidates, n, &selection->jitter_us);
+
+    // combine, weighted with the inverse root distance
+    double weight_sum = 0, offset_sum = 0;
+    for (int i = 0; i < n; i++) {
+        double weight = 1.0 / (double)(candidates[i].root_distance_us + 1);
+        weight_sum += weight;
+        offset_sum += weight * (double)candidates[i].offset_us;
+    }
+    // the order of the survivors is kept by clustering, the first one has the best metric
+    selection->peer = candidates[0].index;
+    selection->survivors = n;
+    selection->offset_us = (int64_t)(offset_sum / weight_sum);
+    selection->delay_us = candidates[0].delay_us;
+    selection->dispersion_us = candidates[0].dispersion_us + candidates[0].jitter_us;
+    return true;
+}
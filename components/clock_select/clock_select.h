@@ -0,0 +1,52 @@
+#pragma once
+
+// Source selection in the spirit of RFC 5905 section 11.2: clock filter per source, intersection algorithm
+// to drop falsetickers, clustering to drop outliers and a weighted combine of the survivors.
+// Plain C without OS calls, so the algorithm can be fed with recorded samples on a Linux host.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CLOCK_FILTER_SIZE 8
+#define CLOCK_STRATUM_UNSYNC 16
+#define CLOCK_MAXDIST_US 1500000  // sources with a larger root distance are not selectable
+#define CLOCK_PHI_PPM 15          // assumed frequency tolerance, dispersion grows with the sample age
+#define CLOCK_MIN_CLUSTER 3       // clustering stops at this number of survivors
+
+// one measurement, offset = source time - local time
+typedef struct {
+    int64_t offset_us;
+    int64_t delay_us;       // round trip delay, 0 for a reference clock
+    int64_t dispersion_us;  // error bound of the measurement itself
+    int64_t time_us;        // local monotonic time of the measurement
+} clock_sample_t;
+
+typedef struct {
+    uint32_t refid;  // reference id the server announces when this source is selected
+    uint8_t stratum;  // 0 for a reference clock
+    int64_t root_delay_us;
+    int64_t root_dispersion_us;
+    int64_t timeout_us;  // the source is unreachable without a sample for this long
+    clock_sample_t samples[CLOCK_FILTER_SIZE];
+    uint8_t sample_count;
+    uint8_t next_sample;
+    bool fresh;  // a sample arrived since the last correction of the local clock was started
+} clock_source_t;
+
+typedef struct {
+    int peer;  // system peer, index into the sources
+    int survivors;
+    int64_t offset_us;  // combined offset of the survivors
+    int64_t jitter_us;  // selection jitter of the survivors
+    int64_t delay_us;   // filtered delay and dispersion of the system peer
+    int64_t dispersion_us;
+} clock_selection_t;
+
+void clock_source_add_sample(clock_source_t *source, const clock_sample_t *sample);
+
+// the local clock was corrected by correction_us, all stored offsets are relative to the old clock. Call it once the
+// correction is complete, for a slew only when it has been applied in full.
+void clock_source_correct(clock_source_t *source, int64_t correction_us);
+
+// returns false if no majority of the reachable sources agrees
+bool clock_select(const clock_source_t *sources, int source_count, int64_t now_us, clock_selection_t *selection);
@@ -0,0 +1,159 @@
+#include <string.h>
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/netdb.h"
+#include "lwip/sockets.h"
+#include "mem_budget.h"
+#include "ntp_packet.h"
+#include "sdkconfig.h"
+#include "time_source.h"
+#include "timebase.h"
+#include "timebase_hires.h"
+
+#if CONFIG_CLOCK_SELECT
+
+static const char *TAG = "ntp_upstream";
+
+#define NTP_PORT "123"
+#define NTP_RESPONSE_TIMEOUT_MS 1000
+// an upstream server is unreachable after this many polls without an answer
+#define NTP_UPSTREAM_REACH_POLLS 8
+// read error of the two clocks involved, both have about 1 ms resolution
+#define NTP_UPSTREAM_DISPERSION_US 1000
+
+typedef struct {
+    char host[64];
+    struct sockaddr_in addr;
+    bool resolved;
+} ntp_upstream_t;
+
+static uint64_t ntp_read_timestamp(const uint8_t *src) {
+    uint64_t t = 0;
+    for (int i = 0; i < 8; i++) {
+        t = (t << 8) | src[i];
+    }
+    return t;
+}
+
+static uint32_t ntp_read_u32(const uint8_t *src) {
+    return ((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 8) | src[3];
+}
+
+// difference of two NTP timestamps in microseconds, correct across the era rollover
+static int64_t ntp_diff_us(uint64_t a, uint64_t b) {
+    int64_t d = (int64_t)(a - b);
+    return (d >> 32) * 1000000 + (int64_t)(((uint64_t)d & 0xFFFFFFFF) * 1000000 >> 32);
+}
+
+// NTP short format (16.16 seconds) to microseconds
+static int64_t ntp_short_us(uint32_t v) { return ((int64_t)v * 1000000) >> 16; }
+
+static bool ntp_upstream_resolve(ntp_upstream_t *server) {
+    struct addrinfo hints = {.ai_family = AF_INET, .ai_socktype = SOCK_DGRAM};
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(server->host, NTP_PORT, &hints, &res) != 0 || res == NULL) {
+        ESP_LOGW(TAG, "Unable to resolve %s", server->host);
+        return false;
+    }
+    memcpy(&server->addr, res->ai_addr, sizeof(server->addr));
+    freeaddrinfo(res);
+    server->resolved = true;
+    return true;
+}
+
+// one client/server exchange, RFC 5905 on-wire protocol
+static bool ntp_upstream_poll(int sock, const ntp_upstream_t *server, time_source_report_t *report) {
+    uint8_t packet[NTP_PACKET_SIZE] = {0};
+    packet[0] = 0b00100011;  // LI 0, VN 4, mode 3 (client)
+    packet[2] = CONFIG_CLOCK_SELECT_UPSTREAM_POLL;
+    uint64_t t1 = ntp_timestamp_from_ns(timebase_hires_realtime_ns());
+    ntp_write_timestamp((char *)&packet[40], t1);
+    if (sendto(sock, packet, sizeof(packet), 0, (const struct sockaddr *)&server->addr, sizeof(server->addr)) < 0) {
+        return false;
+    }
+
+    while (1) {
+        struct sockaddr_in from;
+        socklen_t fromlen = sizeof(from);
+        int len = recvfrom(sock, packet, sizeof(packet), 0, (struct sockaddr *)&from, &fromlen);
+        uint64_t t4 = ntp_timestamp_from_ns(timebase_hires_realtime_ns());
+        if (len < 0) {
+            return false;  // timeout
+        }
+        // ignore stray and late answers of other servers
+        if (len != NTP_PACKET_SIZE || from.sin_addr.s_addr != server->addr.sin_addr.s_addr ||
+            ntp_read_timestamp(&packet[24]) != t1) {
+            continue;
+        }
+        uint8_t li = packet[0] >> 6;
+        uint8_t mode = packet[0] & 0x07;
+        uint8_t stratum = packet[1];
+        if (mode != 4 || li == 3 || stratum == 0 || stratum >= CLOCK_STRATUM_UNSYNC) {
+            ESP_LOGW(TAG, "%s is not synchronized", server->host);
+            return false;
+        }
+        uint64_t t2 = ntp_read_timestamp(&packet[32]);
+        uint64_t t3 = ntp_read_timestamp(&packet[40]);
+        int64_t delay = ntp_diff_us(t4, t1) - ntp_diff_us(t3, t2);
+        report->stratum = stratum;
+        report->root_delay_us = ntp_short_us(ntp_read_u32(&packet[4]));
+        report->root_dispersion_us = ntp_short_us(ntp_read_u32(&packet[8]));
+        report->sample.offset_us = (ntp_diff_us(t2, t1) + ntp_diff_us(t3, t4)) / 2;
+        report->sample.delay_us = delay > 0 ? delay : 0;
+        report->sample.dispersion_us = NTP_UPSTREAM_DISPERSION_US;
+        report->sample.time_us = timebase_monotonic_us();
+        return true;
+    }
+}
+
+void ntp_upstream_task(void *pvParameters) {
+    static ntp_upstream_t servers[TIME_SOURCE_MAX_UPSTREAM];
+    mem_budget_add_static("clock_select", sizeof(servers));
+    int server_count = 0;
+    char list[] = CONFIG_CLOCK_SELECT_UPSTREAM_SERVERS;
+    char *save = NULL;
+    for (char *host = strtok_r(list, ", ", &save); host != NULL && server_count < TIME_SOURCE_MAX_UPSTREAM;
+         host = strtok_r(NULL, ", ", &save)) {
+        strlcpy(servers[server_count++].host, host, sizeof(servers[0].host));
+    }
+    if (server_count == 0) {
+        ESP_LOGI(TAG, "No upstream servers configured");
+        mem_budget_task_exit();
+        return;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        mem_budget_task_exit();
+        return;
+    }
+    struct timeval timeout = {.tv_sec = 0, .tv_usec = NTP_RESPONSE_TIMEOUT_MS * 1000};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    const TickType_t interval = pdMS_TO_TICKS(1000 << CONFIG_CLOCK_SELECT_UPSTREAM_POLL);
+    TickType_t last_wake = xTaskGetTickCount();
+    while (1) {
+        for (int i = 0; i < server_count; i++) {
+            if (!servers[i].resolved && !ntp_upstream_resolve(&servers[i])) {
+                continue;
+            }
+            time_source_report_t report = {
+                .source = TIME_SOURCE_UPSTREAM + i,
+                .refid = ntohl(servers[i].addr.sin_addr.s_addr),  // IPv4 address of the server
+                .timeout_us = (int64_t)NTP_UPSTREAM_REACH_POLLS * 1000000 << CONFIG_CLOCK_SELECT_UPSTREAM_POLL,
+            };
+            if (ntp_upstream_poll(sock, &servers[i], &report)) {
+                time_source_report(&report);
+            } else {
+                // the address may have changed
+                servers[i].resolved = false;
+            }
+        }
+        vTaskDelayUntil(&last_wake, interval);
+    }
+}
+
+#endif  // CONFIG_CLOCK_SELECT
@@ -0,0 +1,156 @@
+#include "time_source.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "mem_budget.h"
+#include "sdkconfig.h"
+#include "timebase.h"
+
+#if CONFIG_CLOCK_SELECT
+
+static const char *TAG = "time_source";
+
+#define REPORT_QUEUE_LEN 8
+// re-evaluate the sources at least this often, so lost sources are noticed without new reports
+#define SELECT_INTERVAL_MS 10000
+
+static QueueHandle_t report_queue = NULL;
+static clock_source_t sources[TIME_SOURCE_COUNT];
+static int last_peer = -1;
+static portMUX_TYPE status_lock = portMUX_INITIALIZER_UNLOCKED;
+static time_source_status_t status = {.stratum = CLOCK_STRATUM_UNSYNC, .refid = 0x494E4954};  // "INIT"
+static int64_t status_time_us = 0;
+static int64_t slew_pending_us = 0;  // slew in progress, not yet applied to the stored offsets
+
+void time_source_report(const time_source_report_t *report) {
+    if (report_queue == NULL || report->source >= TIME_SOURCE_COUNT) {
+        return;
+    }
+    if (xQueueSend(report_queue, report, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Report of source %u dropped", report->source);
+    }
+}
+
+void time_source_status(time_source_status_t *out) {
+    portENTER_CRITICAL(&status_lock);
+    *out = status;
+    int64_t age = timebase_monotonic_us() - status_time_us;
+    portEXIT_CRITICAL(&status_lock);
+    if (out->synchronized) {
+        out->root_dispersion_us += age * CLOCK_PHI_PPM / 1000000;
+    }
+}
+
+// small offsets are slewed so the timescale stays continuous for the clients, large ones are stepped. The stored
+// offsets are moved to the corrected clock once the correction is complete, for a slew that is when
+// timebase_slew_remaining_us() reaches 0.
+static void time_source_correct(int64_t offset_us) {
+    for (int i = 0; i < TIME_SOURCE_COUNT; i++) {
+        sources[i].fresh = false;
+    }
+    if (llabs(offset_us) > CONFIG_CLOCK_SELECT_STEP_THRESHOLD_MS * 1000LL) {
+        timebase_step(offset_us);
+        ESP_LOGW(TAG, "Clock stepped by %lld us", (long long)offset_us);
+        for (int i = 0; i < TIME_SOURCE_COUNT; i++) {
+            clock_source_correct(&sources[i], offset_us);
+        }
+    } else {
+        timebase_slew(offset_us);
+        slew_pending_us = offset_us;
+    }
+}
+
+void time_source_process(const time_source_report_t *report) {
+    if (report != NULL) {
+        clock_source_t *source = &sources[report->source];
+        source->refid = report->refid;
+        source->stratum = report->stratum;
+        source->root_delay_us = report->root_delay_us;
+        source->root_dispersion_us = report->root_dispersion_us;
+        source->timeout_us = report->timeout_us;
+        clock_sample_t sample = report->sample;
+        // measured against the partly slewed clock, relative to the clock before the slew like the stored ones
+        if (slew_pending_us != 0) {
+            sample.offset_us += slew_pending_us - timebase_slew_remaining_us();
+        }
+        clock_source_add_sample(source, &sample);
+        ESP_LOGD(TAG, "source %u offset %lld us delay %lld us", report->source, (long long)report->sample.offset_us,
+                 (long long)report->sample.delay_us);
+    }
+
+    if (slew_pending_us != 0 && timebase_slew_remaining_us() == 0) {
+        for (int i = 0; i < TIME_SOURCE_COUNT; i++) {
+            clock_source_correct(&sources[i], slew_pending_us);
+        }
+        slew_pending_us = 0;
+    }
+
+    int64_t now = timebase_monotonic_us();
+    clock_selection_t sel;
+    if (!clock_select(sources, TIME_SOURCE_COUNT, now, &sel)) {
+        if (last_peer >= 0) {
+            ESP_LOGW(TAG, "No selectable source, holdover");
+            last_peer = -1;
+            portENTER_CRITICAL(&status_lock);
+            status.holdover = true;
+            portEXIT_CRITICAL(&status_lock);
+        }
+        return;
+    }
+    if (sel.peer != last_peer) {
+        ESP_LOGI(TAG, "System peer %d (stratum %u), %d survivor(s), offset %lld us", sel.peer,
+                 sources[sel.peer].stratum, sel.survivors, (long long)sel.offset_us);
+        last_peer = sel.peer;
+    }
+
+    // only new measurements correct the clock, old ones were already applied. A slew in progress is not replaced,
+    // the samples that arrive meanwhile are used once it is complete.
+    if (sources[sel.peer].fresh && slew_pending_us == 0) {
+        time_source_correct(sel.offset_us);
+    }
+
+    const clock_source_t *peer = &sources[sel.peer];
+    portENTER_CRITICAL(&status_lock);
+    status.synchronized = true;
+    status.holdover = false;
+    status.stratum = peer->stratum + 1;
+    status.refid = peer->refid;
+    status.root_delay_us = peer->root_delay_us + sel.delay_us;
+    status.root_dispersion_us = peer->root_dispersion_us + sel.dispersion_us + sel.jitter_us;
+    status_time_us = now;
+    portEXIT_CRITICAL(&status_lock);
+}
+
+void time_source_reset(void) {
+    memset(sources, 0, sizeof(sources));
+    last_peer = -1;
+    slew_pending_us = 0;
+    portENTER_CRITICAL(&status_lock);
+    status = (time_source_status_t){.stratum = CLOCK_STRATUM_UNSYNC, .refid = 0x494E4954};
+    status_time_us = 0;
+    portEXIT_CRITICAL(&status_lock);
+}
+
+void time_source_task(void *pvParameters) {
+    mem_budget_add_static("clock_select", sizeof(sources));
+#if CONFIG_MEM_BUDGET_STATIC
+    static StaticQueue_t report_queue_buffer;
+    static uint8_t report_queue_storage[REPORT_QUEUE_LEN * sizeof(time_source_report_t)];
+    report_queue = xQueueCreateStatic(REPORT_QUEUE_LEN, sizeof(time_source_report_t), report_queue_storage,
+                                      &report_queue_buffer);
+    mem_budget_add_static("clock_select", sizeof(report_queue_storage) + sizeof(report_queue_buffer));
+#else
+    report_queue = xQueueCreate(REPORT_QUEUE_LEN, sizeof(time_source_report_t));
+#endif
+    while (1) {
+        time_source_report_t report;
+        bool received = xQueueReceive(report_queue, &report, pdMS_TO_TICKS(SELECT_INTERVAL_MS)) == pdTRUE;
+        time_source_process(received ? &report : NULL);
+    }
+}
+
+#endif  // CONFIG_CLOCK_SELECT
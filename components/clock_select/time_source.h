@@ -0,0 +1,51 @@
+#pragma once
+
+// Runtime around clock_select: the time sources (time code receiver, upstream NTP servers) report
+// measurements, the selection task picks the system peer and corrects the system clock, the NTP server
+// announces stratum and reference id of the system peer.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "clock_select.h"
+
+#define TIME_SOURCE_RADIO 0     // time code receiver
+#define TIME_SOURCE_UPSTREAM 1  // first upstream NTP server, the others follow
+#define TIME_SOURCE_MAX_UPSTREAM 4
+#define TIME_SOURCE_COUNT (TIME_SOURCE_UPSTREAM + TIME_SOURCE_MAX_UPSTREAM)
+
+typedef struct {
+    uint8_t source;
+    uint8_t stratum;
+    uint32_t refid;
+    int64_t root_delay_us;
+    int64_t root_dispersion_us;
+    int64_t timeout_us;
+    clock_sample_t sample;
+} time_source_report_t;
+
+typedef struct {
+    bool synchronized;  // false before the first selection, the NTP server then sets LI to alarm
+    bool holdover;      // synchronized before, but no source is selectable right now
+    uint8_t stratum;
+    uint32_t refid;
+    int64_t root_delay_us;
+    int64_t root_dispersion_us;  // grows with the time since the last update
+} time_source_status_t;
+
+// thread safe, drops the report if the selection task is busy
+void time_source_report(const time_source_report_t *report);
+
+void time_source_status(time_source_status_t *status);
+
+// one selection round with an optional new report, called by time_source_task for every report and at least
+// every 10 s. Time and clock corrections go through timebase, so it can also be driven by a virtual clock.
+void time_source_process(const time_source_report_t *report);
+
+// forgets the sources and the status as a restart does, for simulations of reboots on a host
+void time_source_reset(void);
+
+void time_source_task(void *pvParameters);
+
+// polls the CONFIG_CLOCK_SELECT_UPSTREAM_SERVERS and reports them as TIME_SOURCE_UPSTREAM + n
+void ntp_upstream_task(void *pvParameters);
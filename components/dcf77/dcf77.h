@@ -1,3 +1,13 @@
 #pragma once
 
+#include <time.h>
+
+#include "timecode_rx.h"
+
 void dcf77(void *pvParameters);
+
+// time of the last valid DCF77 frame written to the system clock, 0 if never synchronized
+time_t dcf77_last_sync(void);
+
+// decode yield of the receiver since start, see timecode_rx_stats_t
+void dcf77_stats(timecode_rx_stats_t *stats);
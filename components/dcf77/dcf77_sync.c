@@ -0,0 +1,41 @@
+#include "dcf77_sync.h"
+
+#include "timebase.h"
+
+int64_t dcf77_sync_offset_us(const timecode_format_t *fmt, const timecode_time_t *time, uint64_t elapsed_us) {
+    time_t t = timecode_utc(fmt, time);
+    struct timeval sys;
+    timebase_realtime(&sys);
+    return ((int64_t)t * 1000000 + elapsed_us) - ((int64_t)sys.tv_sec * 1000000 + sys.tv_usec);
+}
+
+#if CONFIG_CLOCK_SELECT
+// without a valid frame for this long the receiver is not selectable
+#define RADIO_TIMEOUT_US (10 * 60 * 1000000LL)
+
+// reference id as 32 bit value, the string is padded with zeros
+static uint32_t dcf77_refid(const timecode_format_t *fmt) {
+    uint32_t refid = 0;
+    bool end = false;
+    for (int i = 0; i < 4; i++) {
+        end = end || fmt->refid[i] == 0;
+        refid = (refid << 8) | (end ? 0 : (uint8_t)fmt->refid[i]);
+    }
+    return refid;
+}
+
+void dcf77_sync_report(const timecode_format_t *fmt, int64_t offset_us, time_source_report_t *report) {
+    *report = (time_source_report_t){
+        .source = TIME_SOURCE_RADIO,
+        .stratum = 0,
+        .refid = dcf77_refid(fmt),
+        .timeout_us = RADIO_TIMEOUT_US,
+        .sample =
+            {
+                .offset_us = offset_us,
+                .dispersion_us = CONFIG_CLOCK_SELECT_RADIO_DISPERSION_US,
+                .time_us = timebase_monotonic_us(),
+            },
+    };
+}
+#endif
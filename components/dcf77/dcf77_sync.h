@@ -0,0 +1,19 @@
+#pragma once
+
+// The measurement of a decoded frame against the system clock, shared by the dcf77 task and the host simulation.
+
+#include <stdint.h>
+
+#include "sdkconfig.h"
+#include "timecode.h"
+#if CONFIG_CLOCK_SELECT
+#include "time_source.h"
+#endif
+
+// offset of the system clock to the decoded minute, which started elapsed_us ago with the marker pulse
+int64_t dcf77_sync_offset_us(const timecode_format_t *fmt, const timecode_time_t *time, uint64_t elapsed_us);
+
+#if CONFIG_CLOCK_SELECT
+// the report of that offset for the source selection
+void dcf77_sync_report(const timecode_format_t *fmt, int64_t offset_us, time_source_report_t *report);
+#endif
@@ -0,0 +1,83 @@
+#include "timecode.h"
+
+#include <string.h>
+
+#include "civil_time.h"
+
+bool timecode_decode(const timecode_format_t *fmt, const timecode_frame_t *frame, timecode_time_t *time) {
+    memset(time, 0, sizeof(*time));
+
+    // field values, no branches per bit
+    for (int i = 0; i < fmt->bit_count; i++) {
+        const timecode_bit_t *bit = &fmt->bits[i];
+        uint64_t channel = bit->channel ? frame->b : frame->a;
+        time->field[bit->field] += ((channel >> bit->bit) & 1) * bit->weight;
+    }
+
+    for (int i = 0; i < fmt->parity_count; i++) {
+        const timecode_parity_t *parity = &fmt->parities[i];
+        uint64_t mask = (2ULL << parity->last) - (1ULL << parity->first);
+        uint64_t parity_channel = parity->parity_channel ? frame->b : frame->a;
+        int ones = __builtin_popcountll(frame->a & mask) + ((parity_channel >> parity->parity_bit) & 1);
+        if ((ones & 1) != parity->odd) {
+            return false;
+        }
+    }
+
+    if (frame->markers != fmt->marker_mask || (frame->a & fmt->one_mask) != fmt->one_mask) {
+        return false;
+    }
+    if ((fmt->flags & TC_FLAG_DST_PAIR) && (time->field[TC_DST] ^ time->field[TC_STD]) != 1) {
+        return false;
+    }
+    if (time->field[TC_MINUTE] > 59 || time->field[TC_HOUR] > 23) {
+        return false;
+    }
+    if (fmt->flags & TC_FLAG_YDAY) {
+        if (time->field[TC_YDAY] < 1 || time->field[TC_YDAY] > 366) {
+            return false;
+        }
+    } else if (time->field[TC_MONTH] < 1 || time->field[TC_MONTH] > 12 || time->field[TC_MDAY] < 1 ||
+               time->field[TC_MDAY] > 31) {
+        return false;
+    }
+
+    // the date must exist in the transmitted year and fall on the transmitted weekday
+    time->field[TC_YEAR] += fmt->century;
+    int32_t year = time->field[TC_YEAR];
+    int32_t days;
+    if (fmt->flags & TC_FLAG_YDAY) {
+        if (time->field[TC_YDAY] > 365 + civil_is_leap(year)) {
+            return false;
+        }
+        days = civil_days_from_civil(year, 1, 1) + time->field[TC_YDAY] - 1;
+    } else {
+        uint32_t month = time->field[TC_MONTH];
+        days = civil_days_from_civil(year, month, time->field[TC_MDAY]);
+        // past the end of the month it would already count into the next one
+        if (month != 12 && days >= civil_days_from_civil(year, month + 1, 1)) {
+            return false;
+        }
+    }
+    if (fmt->flags & TC_FLAG_WDAY) {
+        int wday = (int)civil_weekday(days);
+        if (time->field[TC_WDAY] != (wday == 0 ? fmt->wday_sunday : wday)) {
+            return false;
+        }
+    }
+    time->utc_offset_min = time->field[TC_DST] ? fmt->dst_offset_min : fmt->std_offset_min;
+    return true;
+}
+
+time_t timecode_utc(const timecode_format_t *fmt, const timecode_time_t *time) {
+    int64_t local;
+    if (fmt->flags & TC_FLAG_YDAY) {
+        local = civil_yday_to_unix(time->field[TC_YEAR], time->field[TC_YDAY], time->field[TC_HOUR],
+                                   time->field[TC_MINUTE], 0);
+    } else {
+        local = civil_to_unix(time->field[TC_YEAR], time->field[TC_MONTH], time->field[TC_MDAY], time->field[TC_HOUR],
+                              time->field[TC_MINUTE], 0);
+    }
+    // explicit offset of the station time zone, e.g. CET/CEST from DCF77 bits 17/18, TZ of the system is not used
+    return (time_t)(local - time->utc_offset_min * 60 + fmt->minute_offset * 60);
+}
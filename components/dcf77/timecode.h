@@ -0,0 +1,119 @@
+#pragma once
+
+// Generic decoder core for LF time code stations (DCF77, MSF, WWVB, JJY).
+// A station is described by a constant timecode_format_t: pulse classes, minute marker, field table,
+// parity groups and time zone rule. The front end (timecode_rx.c) measures pulses and collects the symbols of
+// one frame, this module classifies pulses and decodes complete frames.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+// symbol bits of a classified pulse
+#define TC_SYM_A 0x01       // data bit (A channel)
+#define TC_SYM_B 0x02       // second data bit in the same second (MSF B channel)
+#define TC_SYM_MARKER 0x04  // position or minute marker
+
+// format flags
+#define TC_FLAG_DST_PAIR 0x01  // DST and STD bits must be complementary (DCF77 bits 17/18)
+#define TC_FLAG_YDAY 0x02      // date is transmitted as day of year instead of month and day
+#define TC_FLAG_SPLIT_B 0x04   // a second short pulse within the same second sets the B bit (MSF "01")
+#define TC_FLAG_WDAY 0x08      // the weekday is transmitted and must match the date
+
+typedef enum {
+    TC_MINUTE,
+    TC_HOUR,
+    TC_MDAY,
+    TC_MONTH,
+    TC_YDAY,
+    TC_YEAR,
+    TC_WDAY,
+    TC_DST,
+    TC_STD,
+    TC_FIELD_COUNT,
+} timecode_field_t;
+
+typedef struct {
+    uint32_t min_us;
+    uint32_t max_us;
+    uint8_t symbol;
+} timecode_pulse_class_t;
+
+// one bit of a field: field += weight if the bit is set
+typedef struct {
+    uint8_t bit;
+    uint8_t channel;  // 0: A, 1: B
+    uint8_t field;
+    uint8_t weight;
+} timecode_bit_t;
+
+// parity over the data bits first..last (A channel) and the parity bit, the XOR of all must equal odd
+typedef struct {
+    uint8_t first;
+    uint8_t last;
+    uint8_t parity_bit;
+    uint8_t parity_channel;  // 0: A, 1: B
+    uint8_t odd;
+} timecode_parity_t;
+
+typedef struct {
+    const char *name;
+    const char *refid;  // NTP reference id, up to 4 characters
+    uint8_t active_level;  // receiver output level during a pulse
+    uint8_t flags;
+    const timecode_pulse_class_t *pulse_classes;
+    uint8_t pulse_class_count;
+    // minute marker: either a pulse following a gap in this range (start to start) ...
+    uint32_t marker_gap_min_us;
+    uint32_t marker_gap_max_us;
+    // ... or marker_run consecutive marker symbols, the last one starts the minute
+    uint8_t marker_run;
+    uint8_t frame_seconds;      // number of pulses in a regular frame
+    uint8_t leap_announce_bit;  // A channel bit announcing a leap second (one more pulse), 0 if not supported
+    uint64_t marker_mask;       // positions that must carry a marker symbol
+    uint64_t one_mask;          // A channel positions that are always 1
+    const timecode_bit_t *bits;
+    uint8_t bit_count;
+    const timecode_parity_t *parities;
+    uint8_t parity_count;
+    uint16_t century;        // added to a two digit year
+    int16_t std_offset_min;  // local standard time - UTC
+    int16_t dst_offset_min;  // local summer time - UTC
+    uint8_t minute_offset;   // 1 if the frame encodes the minute it is sent in, 0 if the following minute
+    uint8_t wday_sunday;     // weekday value of Sunday (0 or 7), Monday to Saturday are 1 to 6
+} timecode_format_t;
+
+// symbols of one frame, bit n is the symbol of second n
+typedef struct {
+    uint64_t a;
+    uint64_t b;
+    uint64_t markers;
+} timecode_frame_t;
+
+typedef struct {
+    int16_t field[TC_FIELD_COUNT];
+    int16_t utc_offset_min;
+} timecode_time_t;
+
+// returns the symbol of a pulse of the given width or -1 if it matches no pulse class
+static inline int timecode_classify(const timecode_format_t *fmt, uint32_t width_us) {
+    for (int i = 0; i < fmt->pulse_class_count; i++) {
+        if (width_us > fmt->pulse_classes[i].min_us && width_us < fmt->pulse_classes[i].max_us) {
+            return fmt->pulse_classes[i].symbol;
+        }
+    }
+    return -1;
+}
+
+static inline void timecode_frame_set(timecode_frame_t *frame, uint8_t second, uint8_t symbol) {
+    uint64_t mask = 1ULL << second;
+    frame->a |= (uint64_t)(symbol & TC_SYM_A) << second;
+    frame->b |= (uint64_t)((symbol & TC_SYM_B) >> 1) << second;
+    frame->markers |= (symbol & TC_SYM_MARKER) ? mask : 0;
+}
+
+// decodes and validates a complete frame
+bool timecode_decode(const timecode_format_t *fmt, const timecode_frame_t *frame, timecode_time_t *time);
+
+// UTC of the minute marker which ended the frame, without newlib's mktime()/TZ handling
+time_t timecode_utc(const timecode_format_t *fmt, const timecode_time_t *time);
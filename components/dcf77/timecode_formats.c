@@ -0,0 +1,194 @@
+#include "timecode_formats.h"
+
+#define A 0
+#define B 1
+#define BIT(n) (1ULL << (n))
+
+// DCF77 (Mainflingen, 77.5 kHz): carrier reduced for 100 ms ('0') or 200 ms ('1') at the start of
+// each second, no reduction in second 59. BCD fields LSB first, CET/CEST from bits 17/18.
+static const timecode_pulse_class_t dcf77_pulses[] = {
+    {25000, 150000, 0},
+    {150000, 300000, TC_SYM_A},
+};
+
+static const timecode_bit_t dcf77_bits[] = {
+    {17, A, TC_DST, 1},     {18, A, TC_STD, 1},     {21, A, TC_MINUTE, 1},  {22, A, TC_MINUTE, 2},
+    {23, A, TC_MINUTE, 4},  {24, A, TC_MINUTE, 8},  {25, A, TC_MINUTE, 10}, {26, A, TC_MINUTE, 20},
+    {27, A, TC_MINUTE, 40}, {29, A, TC_HOUR, 1},    {30, A, TC_HOUR, 2},    {31, A, TC_HOUR, 4},
+    {32, A, TC_HOUR, 8},    {33, A, TC_HOUR, 10},   {34, A, TC_HOUR, 20},   {36, A, TC_MDAY, 1},
+    {37, A, TC_MDAY, 2},    {38, A, TC_MDAY, 4},    {39, A, TC_MDAY, 8},    {40, A, TC_MDAY, 10},
+    {41, A, TC_MDAY, 20},   {42, A, TC_WDAY, 1},    {43, A, TC_WDAY, 2},    {44, A, TC_WDAY, 4},
+    {45, A, TC_MONTH, 1},   {46, A, TC_MONTH, 2},   {47, A, TC_MONTH, 4},   {48, A, TC_MONTH, 8},
+    {49, A, TC_MONTH, 10},  {50, A, TC_YEAR, 1},    {51, A, TC_YEAR, 2},    {52, A, TC_YEAR, 4},
+    {53, A, TC_YEAR, 8},    {54, A, TC_YEAR, 10},   {55, A, TC_YEAR, 20},   {56, A, TC_YEAR, 40},
+    {57, A, TC_YEAR, 80},
+};
+
+static const timecode_parity_t dcf77_parities[] = {
+    {21, 27, 28, A, 0},
+    {29, 34, 35, A, 0},
+    {36, 57, 58, A, 0},
+};
+
+const timecode_format_t timecode_format_dcf77 = {
+    .name = "DCF77",
+    .refid = "DCF",
+    .active_level = 1,
+    .flags = TC_FLAG_DST_PAIR | TC_FLAG_WDAY,
+    .pulse_classes = dcf77_pulses,
+    .pulse_class_count = sizeof(dcf77_pulses) / sizeof(dcf77_pulses[0]),
+    .marker_gap_min_us = 1700000,
+    .marker_gap_max_us = 2300000,
+    .frame_seconds = 59,
+    .leap_announce_bit = 19,
+    .marker_mask = 0,
+    .one_mask = BIT(20),  // start of encoded time
+    .bits = dcf77_bits,
+    .bit_count = sizeof(dcf77_bits) / sizeof(dcf77_bits[0]),
+    .parities = dcf77_parities,
+    .parity_count = sizeof(dcf77_parities) / sizeof(dcf77_parities[0]),
+    .century = 2000,
+    .std_offset_min = 60,
+    .dst_offset_min = 120,
+    .minute_offset = 0,
+    .wday_sunday = 7,  // Monday = 1
+};
+
+// MSF (Anthorn, 60 kHz): carrier off for 100 ms (A0 B0), 200 ms (A1 B0), 300 ms (A1 B1) or twice 100 ms
+// (A0 B1), 500 ms minute marker at second 0. BCD fields MSB first, odd parity in B bits 54-57, BST in 58B.
+static const timecode_pulse_class_t msf_pulses[] = {
+    {50000, 150000, 0},
+    {150000, 250000, TC_SYM_A},
+    {250000, 350000, TC_SYM_A | TC_SYM_B},
+    {400000, 600000, TC_SYM_MARKER},
+};
+
+static const timecode_bit_t msf_bits[] = {
+    {17, A, TC_YEAR, 80},   {18, A, TC_YEAR, 40},   {19, A, TC_YEAR, 20},   {20, A, TC_YEAR, 10},
+    {21, A, TC_YEAR, 8},    {22, A, TC_YEAR, 4},    {23, A, TC_YEAR, 2},    {24, A, TC_YEAR, 1},
+    {25, A, TC_MONTH, 10},  {26, A, TC_MONTH, 8},   {27, A, TC_MONTH, 4},   {28, A, TC_MONTH, 2},
+    {29, A, TC_MONTH, 1},   {30, A, TC_MDAY, 20},   {31, A, TC_MDAY, 10},   {32, A, TC_MDAY, 8},
+    {33, A, TC_MDAY, 4},    {34, A, TC_MDAY, 2},    {35, A, TC_MDAY, 1},    {36, A, TC_WDAY, 4},
+    {37, A, TC_WDAY, 2},    {38, A, TC_WDAY, 1},    {39, A, TC_HOUR, 20},   {40, A, TC_HOUR, 10},
+    {41, A, TC_HOUR, 8},    {42, A, TC_HOUR, 4},    {43, A, TC_HOUR, 2},    {44, A, TC_HOUR, 1},
+    {45, A, TC_MINUTE, 40}, {46, A, TC_MINUTE, 20}, {47, A, TC_MINUTE, 10}, {48, A, TC_MINUTE, 8},
+    {49, A, TC_MINUTE, 4},  {50, A, TC_MINUTE, 2},  {51, A, TC_MINUTE, 1},  {58, B, TC_DST, 1},
+};
+
+static const timecode_parity_t msf_parities[] = {
+    {17, 24, 54, B, 1},
+    {25, 35, 55, B, 1},
+    {36, 38, 56, B, 1},
+    {39, 51, 57, B, 1},
+};
+
+const timecode_format_t timecode_format_msf = {
+    .name = "MSF",
+    .refid = "MSF",
+    .active_level = 1,
+    .flags = TC_FLAG_SPLIT_B | TC_FLAG_WDAY,
+    .pulse_classes = msf_pulses,
+    .pulse_class_count = sizeof(msf_pulses) / sizeof(msf_pulses[0]),
+    .marker_run = 1,
+    .frame_seconds = 60,
+    .marker_mask = BIT(0),
+    .one_mask = BIT(53) | BIT(54) | BIT(55) | BIT(56) | BIT(57) | BIT(58),  // 01111110 end of minute identifier
+    .bits = msf_bits,
+    .bit_count = sizeof(msf_bits) / sizeof(msf_bits[0]),
+    .parities = msf_parities,
+    .parity_count = sizeof(msf_parities) / sizeof(msf_parities[0]),
+    .century = 2000,
+    .std_offset_min = 0,
+    .dst_offset_min = 60,
+    .minute_offset = 0,
+    .wday_sunday = 0,
+};
+
+// position markers of WWVB and JJY
+#define WWVB_JJY_MARKERS (BIT(0) | BIT(9) | BIT(19) | BIT(29) | BIT(39) | BIT(49) | BIT(59))
+
+// WWVB (Fort Collins, 60 kHz): power reduced for 200 ms ('0'), 500 ms ('1') or 800 ms (marker).
+// UTC, BCD fields MSB first, day of year, the frame encodes the minute it is sent in.
+static const timecode_pulse_class_t wwvb_pulses[] = {
+    {100000, 350000, 0},
+    {350000, 650000, TC_SYM_A},
+    {650000, 950000, TC_SYM_MARKER},
+};
+
+static const timecode_bit_t wwvb_bits[] = {
+    {1, A, TC_MINUTE, 40}, {2, A, TC_MINUTE, 20}, {3, A, TC_MINUTE, 10}, {5, A, TC_MINUTE, 8},
+    {6, A, TC_MINUTE, 4},  {7, A, TC_MINUTE, 2},  {8, A, TC_MINUTE, 1},  {12, A, TC_HOUR, 20},
+    {13, A, TC_HOUR, 10},  {15, A, TC_HOUR, 8},   {16, A, TC_HOUR, 4},   {17, A, TC_HOUR, 2},
+    {18, A, TC_HOUR, 1},   {22, A, TC_YDAY, 200}, {23, A, TC_YDAY, 100}, {25, A, TC_YDAY, 80},
+    {26, A, TC_YDAY, 40},  {27, A, TC_YDAY, 20},  {28, A, TC_YDAY, 10},  {30, A, TC_YDAY, 8},
+    {31, A, TC_YDAY, 4},   {32, A, TC_YDAY, 2},   {33, A, TC_YDAY, 1},   {45, A, TC_YEAR, 80},
+    {46, A, TC_YEAR, 40},  {47, A, TC_YEAR, 20},  {48, A, TC_YEAR, 10},  {50, A, TC_YEAR, 8},
+    {51, A, TC_YEAR, 4},   {52, A, TC_YEAR, 2},   {53, A, TC_YEAR, 1},   {57, A, TC_DST, 1},
+};
+
+const timecode_format_t timecode_format_wwvb = {
+    .name = "WWVB",
+    .refid = "WWVB",
+    .active_level = 1,
+    .flags = TC_FLAG_YDAY,
+    .pulse_classes = wwvb_pulses,
+    .pulse_class_count = sizeof(wwvb_pulses) / sizeof(wwvb_pulses[0]),
+    .marker_run = 2,
+    .frame_seconds = 60,
+    .marker_mask = WWVB_JJY_MARKERS,
+    .one_mask = 0,
+    .bits = wwvb_bits,
+    .bit_count = sizeof(wwvb_bits) / sizeof(wwvb_bits[0]),
+    .century = 2000,
+    // WWVB transmits UTC, the DST bits are only an announcement for US local time
+    .std_offset_min = 0,
+    .dst_offset_min = 0,
+    .minute_offset = 1,
+};
+
+// JJY (Japan, 40/60 kHz): full carrier for 800 ms ('0'), 500 ms ('1') or 200 ms (marker) at the start
+// of each second. JST (UTC+9), BCD fields MSB first, day of year, even parity bits PA1/PA2.
+static const timecode_pulse_class_t jjy_pulses[] = {
+    {100000, 350000, TC_SYM_MARKER},
+    {350000, 650000, TC_SYM_A},
+    {650000, 950000, 0},
+};
+
+static const timecode_bit_t jjy_bits[] = {
+    {1, A, TC_MINUTE, 40}, {2, A, TC_MINUTE, 20}, {3, A, TC_MINUTE, 10}, {5, A, TC_MINUTE, 8},
+    {6, A, TC_MINUTE, 4},  {7, A, TC_MINUTE, 2},  {8, A, TC_MINUTE, 1},  {12, A, TC_HOUR, 20},
+    {13, A, TC_HOUR, 10},  {15, A, TC_HOUR, 8},   {16, A, TC_HOUR, 4},   {17, A, TC_HOUR, 2},
+    {18, A, TC_HOUR, 1},   {22, A, TC_YDAY, 200}, {23, A, TC_YDAY, 100}, {25, A, TC_YDAY, 80},
+    {26, A, TC_YDAY, 40},  {27, A, TC_YDAY, 20},  {28, A, TC_YDAY, 10},  {30, A, TC_YDAY, 8},
+    {31, A, TC_YDAY, 4},   {32, A, TC_YDAY, 2},   {33, A, TC_YDAY, 1},   {41, A, TC_YEAR, 80},
+    {42, A, TC_YEAR, 40},  {43, A, TC_YEAR, 20},  {44, A, TC_YEAR, 10},  {45, A, TC_YEAR, 8},
+    {46, A, TC_YEAR, 4},   {47, A, TC_YEAR, 2},   {48, A, TC_YEAR, 1},   {50, A, TC_WDAY, 4},
+    {51, A, TC_WDAY, 2},   {52, A, TC_WDAY, 1},
+};
+
+static const timecode_parity_t jjy_parities[] = {
+    {12, 18, 36, A, 0},  // PA1, hour
+    {1, 8, 37, A, 0},    // PA2, minute
+};
+
+const timecode_format_t timecode_format_jjy = {
+    .name = "JJY",
+    .refid = "JJY",
+    .active_level = 1,
+    .flags = TC_FLAG_YDAY | TC_FLAG_WDAY,
+    .pulse_classes = jjy_pulses,
+    .pulse_class_count = sizeof(jjy_pulses) / sizeof(jjy_pulses[0]),
+    .marker_run = 2,
+    .frame_seconds = 60,
+    .marker_mask = WWVB_JJY_MARKERS,
+    .one_mask = 0,
+    .bits = jjy_bits,
+    .bit_count = sizeof(jjy_bits) / sizeof(jjy_bits[0]),
+    .parities = jjy_parities,
+    .parity_count = sizeof(jjy_parities) / sizeof(jjy_parities[0]),
+    .century = 2000,
+    .std_offset_min = 540,
+    .dst_offset_min = 540,
+    .minute_offset = 1,
+    .wday_sunday = 0,
+};
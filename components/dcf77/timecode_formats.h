@@ -0,0 +1,20 @@
+#pragma once
+
+#include "sdkconfig.h"
+#include "timecode.h"
+
+extern const timecode_format_t timecode_format_dcf77;
+extern const timecode_format_t timecode_format_msf;
+extern const timecode_format_t timecode_format_wwvb;
+extern const timecode_format_t timecode_format_jjy;
+
+// station format selected at build time
+#if CONFIG_TIMECODE_FORMAT_MSF
+#define TIMECODE_FORMAT (&timecode_format_msf)
+#elif CONFIG_TIMECODE_FORMAT_WWVB
+#define TIMECODE_FORMAT (&timecode_format_wwvb)
+#elif CONFIG_TIMECODE_FORMAT_JJY
+#define TIMECODE_FORMAT (&timecode_format_jjy)
+#else
+#define TIMECODE_FORMAT (&timecode_format_dcf77)
+#endif
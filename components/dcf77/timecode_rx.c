@@ -0,0 +1,97 @@
+#include "timecode_rx.h"
+
+// a second pulse starting earlier than this belongs to the same second (MSF "01")
+#define SPLIT_PULSE_US 500000
+// pulses further apart than this (and not a minute gap) mean the signal was lost
+#define MAX_PULSE_INTERVAL_US 1500000
+// the pulse after a minute marker confirms it when it starts this close to a second after the marker
+#define SECOND_US 1000000
+#define CONFIRM_TOLERANCE_US 200000
+
+void timecode_rx_init(timecode_rx_t *rx, const timecode_format_t *fmt) {
+    *rx = (timecode_rx_t){.fmt = fmt, .second = -1};
+}
+
+// checks whether a pulse starts a new minute
+static bool timecode_rx_minute_start(const timecode_rx_t *rx, uint64_t interval, uint8_t symbol) {
+    const timecode_format_t *fmt = rx->fmt;
+    if (fmt->marker_run == 0) {
+        return interval > fmt->marker_gap_min_us && interval < fmt->marker_gap_max_us;
+    }
+    return (symbol & TC_SYM_MARKER) && rx->marker_run >= fmt->marker_run;
+}
+
+// a frame is complete with the regular number of seconds, or one more if a leap second was announced
+static bool timecode_rx_frame_complete(const timecode_rx_t *rx) {
+    const timecode_format_t *fmt = rx->fmt;
+    if (rx->second == fmt->frame_seconds - 1) {
+        return true;
+    }
+    return fmt->leap_announce_bit != 0 && rx->second == fmt->frame_seconds &&
+           ((rx->frame.a >> fmt->leap_announce_bit) & 1);
+}
+
+timecode_rx_result_t timecode_rx_edge(timecode_rx_t *rx, uint64_t time_us, bool active, timecode_time_t *time,
+                                      uint64_t *marker_us) {
+    const timecode_format_t *fmt = rx->fmt;
+    if (active) {
+        rx->pulse_start = time_us;
+        return TC_RX_NONE;
+    }
+
+    // end of a pulse
+    int symbol = timecode_classify(fmt, (uint32_t)(time_us - rx->pulse_start));
+    if (symbol < 0) {
+        // not valid pulse, ignore
+        rx->stats.invalid_pulses++;
+        return TC_RX_NONE;
+    }
+    rx->stats.pulses++;
+    uint64_t interval = rx->pulse_start - rx->last_pulse_start;
+    timecode_rx_result_t result = TC_RX_NONE;
+    if (rx->pending) {
+        rx->pending = false;
+        if (interval + CONFIRM_TOLERANCE_US >= SECOND_US && interval <= SECOND_US + CONFIRM_TOLERANCE_US) {
+            rx->stats.frames_valid++;
+            *time = rx->pending_time;
+            *marker_us = rx->last_pulse_start;
+            result = TC_RX_TIME;
+        } else {
+            // e.g. the real second 0 pulse after a glitch in the minute gap
+            rx->stats.frames_invalid++;
+            rx->second = -1;
+            result = TC_RX_INVALID;
+        }
+    }
+    if ((fmt->flags & TC_FLAG_SPLIT_B) && interval < SPLIT_PULSE_US && rx->second >= 0) {
+        rx->frame.b |= 1ULL << rx->second;
+        return result;
+    }
+    rx->last_pulse_start = rx->pulse_start;
+    rx->marker_run = (symbol & TC_SYM_MARKER) ? rx->marker_run + 1 : 0;
+
+    if (timecode_rx_minute_start(rx, interval, symbol)) {
+        if (timecode_rx_frame_complete(rx)) {
+            if (timecode_decode(fmt, &rx->frame, &rx->pending_time)) {
+                rx->pending = true;
+            } else {
+                rx->stats.frames_invalid++;
+                result = TC_RX_INVALID;
+            }
+        } else if (rx->second >= 0) {
+            rx->stats.sync_losses++;
+        }
+        rx->second = 0;
+        rx->frame = (timecode_frame_t){0};
+    } else if (rx->second >= 0 && interval < MAX_PULSE_INTERVAL_US && rx->second < 63) {
+        rx->second++;
+    } else {
+        if (rx->second >= 0) {
+            rx->stats.sync_losses++;
+        }
+        rx->second = -1;
+        return result;
+    }
+    timecode_frame_set(&rx->frame, rx->second, symbol);
+    return result;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// Receiver front end: turns TCO edges into decoded frames. No OS calls, so the same state machine runs in
+// the dcf77 task and, fed with recorded or synthesized edges, on a Linux host.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "timecode.h"
+
+typedef enum {
+    TC_RX_NONE,     // nothing to report
+    TC_RX_TIME,     // a valid frame ended, time holds the decoded time
+    TC_RX_INVALID,  // a complete frame ended but failed to decode, or its minute marker was not confirmed
+} timecode_rx_result_t;
+
+// decode yield, counted since timecode_rx_init()
+typedef struct {
+    uint32_t pulses;          // pulses that matched a pulse class
+    uint32_t invalid_pulses;  // pulses of no known width (noise, fading)
+    uint32_t sync_losses;     // frames abandoned because of a missing or extra pulse
+    uint32_t frames_valid;
+    uint32_t frames_invalid;  // complete frames with parity or range errors or an unconfirmed marker
+} timecode_rx_stats_t;
+
+typedef struct {
+    const timecode_format_t *fmt;
+    uint64_t pulse_start;
+    uint64_t last_pulse_start;
+    timecode_frame_t frame;
+    int second;  // position in the current frame, -1 while not synchronized to the minute
+    uint8_t marker_run;
+    bool pending;                // a frame decoded at the last marker waits for the next pulse
+    timecode_time_t pending_time;
+    timecode_rx_stats_t stats;
+} timecode_rx_t;
+
+void timecode_rx_init(timecode_rx_t *rx, const timecode_format_t *fmt);
+
+// one edge, active is true if the pulse starts with it (level already corrected for the receiver polarity).
+// On TC_RX_TIME, marker_us is the time of the minute marker pulse start, i.e. the start of the decoded minute.
+// A frame is reported with the next pulse about a second after the marker: a glitch in the minute gap would
+// otherwise pass as an early marker. It is dropped if that pulse comes earlier or later.
+timecode_rx_result_t timecode_rx_edge(timecode_rx_t *rx, uint64_t time_us, bool active, timecode_time_t *time,
+                                      uint64_t *marker_us);
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// offsets in an untagged Ethernet II frame carrying IPv4 without options
+#define ETH_NTP_FRAME_ETHERTYPE 12
+#define ETH_NTP_FRAME_IP 14
+#define ETH_NTP_FRAME_UDP (ETH_NTP_FRAME_IP + 20)
+#define ETH_NTP_FRAME_NTP (ETH_NTP_FRAME_UDP + 8)
+#define ETH_NTP_FRAME_XMT (ETH_NTP_FRAME_NTP + 40)
+#define ETH_NTP_FRAME_MIN_LEN (ETH_NTP_FRAME_NTP + 48)
+
+/**
+ * @brief Identifies an NTP request between the driver hook and the server socket
+ */
+typedef struct {
+    uint32_t src_addr;  /*!< IPv4 source address, network byte order */
+    uint16_t src_port;  /*!< UDP source port, network byte order */
+    uint8_t xmt[8];     /*!< transmit timestamp of the request */
+} eth_ntp_frame_key_t;
+
+/**
+ * @brief Check whether a received frame is an NTP request (IPv4, UDP destination port 123)
+ * @note Fixed offsets only: VLAN tags, IP options and fragments are not matched, such requests get the
+ *       timestamp taken by the server. Plain C, runs for every received frame in the driver RX task.
+ *
+ * @param[in] frame Ethernet frame starting at the destination MAC
+ * @param[in] length frame length
+ * @param[out] key source and transmit timestamp of the request, written only on a match
+ * @return true if the frame is an NTP request
+ */
+static inline bool eth_ntp_frame_match(const uint8_t *frame, uint32_t length, eth_ntp_frame_key_t *key)
+{
+    const uint8_t *ip = &frame[ETH_NTP_FRAME_IP];
+    const uint8_t *udp = &frame[ETH_NTP_FRAME_UDP];
+    // EtherType IPv4, version 4 with IHL 5, protocol UDP, no fragment offset or MF, destination port 123
+    if (length < ETH_NTP_FRAME_MIN_LEN || frame[ETH_NTP_FRAME_ETHERTYPE] != 0x08 ||
+        frame[ETH_NTP_FRAME_ETHERTYPE + 1] != 0x00 || ip[0] != 0x45 || ip[9] != 17 ||
+        ((ip[6] & 0x3F) | ip[7]) != 0 || udp[2] != 0 || udp[3] != 123) {
+        return false;
+    }
+    memcpy(&key->src_addr, &ip[12], 4);
+    memcpy(&key->src_port, &udp[0], 2);
+    memcpy(key->xmt, &frame[ETH_NTP_FRAME_XMT], 8);
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,261 @@
+#include "eth_rx_timestamp.h"
+
+#include <string.h>
+
+#include "driver/gptimer.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "mem_budget.h"
+#include "sdkconfig.h"
+#include "soc/soc_caps.h"
+#include "timebase_hires.h"
+#if CONFIG_EXAMPLE_ETH_SPI_LOW_LATENCY && SOC_ETM_SUPPORTED && SOC_GPIO_SUPPORT_ETM
+#include "driver/gpio_etm.h"
+#include "driver/gptimer_etm.h"
+#include "esp_etm.h"
+#define ETH_RX_HW_CAPTURE 1
+#else
+#define ETH_RX_HW_CAPTURE 0
+#endif
+
+#if CONFIG_EXAMPLE_ETH_RX_TIMESTAMP
+
+#define ETH_RX_MAX_PORTS 3
+#define ETH_RX_NTP_RING_LEN CONFIG_EXAMPLE_ETH_RX_NTP_RING_LEN
+#define ETH_RX_REPORT_INTERVAL_US (600 * 1000000ULL)
+
+typedef struct {
+    esp_eth_handle_t eth_handle;
+    esp_netif_t *netif;
+    gptimer_handle_t timer;  // free running at 1 MHz, latches its count at the INT edge, NULL without latch
+    uint64_t last_capture;
+    eth_rx_latency_t latency;
+} eth_rx_port_t;
+
+typedef struct {
+    eth_ntp_frame_key_t key;
+    uint64_t time_ns;  // timebase_hires_realtime_ns(), the clock of the server's own timestamps
+    bool pending;      // not read by the server yet
+} eth_rx_ntp_entry_t;
+
+static const char *TAG = "eth_rx_timestamp";
+static eth_rx_port_t s_ports[ETH_RX_MAX_PORTS];
+static int s_port_cnt = 0;
+static eth_rx_ntp_entry_t s_ntp_ring[ETH_RX_NTP_RING_LEN];
+static int s_ntp_next = 0;
+static eth_rx_ntp_stats_t s_ntp_stats;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#if ETH_RX_HW_CAPTURE
+static void eth_rx_latency_add(eth_rx_latency_t *latency, uint32_t us)
+{
+    int bucket = us == 0 ? 0 : 32 - __builtin_clz(us);
+    if (bucket >= ETH_RX_LATENCY_BUCKETS) {
+        bucket = ETH_RX_LATENCY_BUCKETS - 1;
+    }
+    portENTER_CRITICAL(&s_lock);
+    if (latency->captured == 0 || us < latency->min_us) {
+        latency->min_us = us;
+    }
+    if (us > latency->max_us) {
+        latency->max_us = us;
+    }
+    latency->captured++;
+    latency->sum_us += us;
+    latency->histogram[bucket]++;
+    portEXIT_CRITICAL(&s_lock);
+}
+#endif
+
+// remembers the arrival time of NTP requests
+static void eth_rx_ntp_record(const uint8_t *frame, uint32_t length, uint64_t time_ns)
+{
+    eth_rx_ntp_entry_t entry = { .time_ns = time_ns, .pending = true };
+    if (!eth_ntp_frame_match(frame, length, &entry.key)) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    if (s_ntp_ring[s_ntp_next].pending) {
+        s_ntp_stats.overwritten++;
+    }
+    s_ntp_ring[s_ntp_next] = entry;
+    s_ntp_next = (s_ntp_next + 1) % ETH_RX_NTP_RING_LEN;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+// replaces the netif glue input: timestamp, then hand the frame to the stack exactly as the glue does
+static esp_err_t eth_rx_input(esp_eth_handle_t eth_handle, uint8_t *buffer, uint32_t length, void *priv)
+{
+    // first thing on arrival, before any classification
+    uint64_t time_ns = timebase_hires_realtime_ns();
+    eth_rx_port_t *port = (eth_rx_port_t *)priv;
+    port->latency.frames++;
+
+#if ETH_RX_HW_CAPTURE
+    // only the first frame after an INT edge arrived at the edge, later frames of the same burst keep the
+    // stack input time
+    uint64_t now;
+    uint64_t captured;
+    if (port->timer != NULL && gptimer_get_raw_count(port->timer, &now) == ESP_OK &&
+        gptimer_get_captured_count(port->timer, &captured) == ESP_OK && captured != port->last_capture) {
+        port->last_capture = captured;
+        uint32_t latency_us = (uint32_t)(now - captured);
+        eth_rx_latency_add(&port->latency, latency_us);
+        time_ns -= latency_us * 1000ULL;
+    }
+#endif
+    eth_rx_ntp_record(buffer, length, time_ns);
+    return esp_netif_receive(port->netif, buffer, length, NULL);
+}
+
+static void eth_rx_latency_report(void *arg)
+{
+    for (int i = 0; i < s_port_cnt; i++) {
+        eth_rx_latency_t l;
+        eth_rx_latency_get(i, &l);
+        if (l.captured == 0) {
+            ESP_LOGI(TAG, "port %d: %lu frames, no INT edges latched", i, (unsigned long)l.frames);
+            continue;
+        }
+        ESP_LOGI(TAG, "port %d: %lu frames, INT to stack input min %lu us avg %lu us max %lu us", i,
+                 (unsigned long)l.frames, (unsigned long)l.min_us, (unsigned long)(l.sum_us / l.captured),
+                 (unsigned long)l.max_us);
+    }
+    eth_rx_ntp_stats_t n;
+    eth_rx_ntp_stats_get(&n);
+    if (n.matched > 0) {
+        ESP_LOGI(TAG, "NTP: %lu requests timestamped at input, %lu missed, earlier by min %lu avg %lu max %lu us",
+                 (unsigned long)n.matched, (unsigned long)n.missed, (unsigned long)n.gain_min_us,
+                 (unsigned long)(n.gain_sum_us / n.matched), (unsigned long)n.gain_max_us);
+    }
+    if (n.overwritten > 0) {
+        ESP_LOGW(TAG, "NTP: %lu timestamps overwritten before the server read them, increase the ring length",
+                 (unsigned long)n.overwritten);
+    }
+}
+
+esp_err_t eth_rx_timestamp_register(esp_eth_handle_t eth_handle, int int_gpio)
+{
+    esp_err_t ret = ESP_OK;
+    ESP_RETURN_ON_FALSE(s_port_cnt < ETH_RX_MAX_PORTS, ESP_ERR_NO_MEM, TAG, "too many ports");
+    if (s_port_cnt == 0) {
+        mem_budget_add_static("ethernet_init", sizeof(s_ports) + sizeof(s_ntp_ring));
+    }
+    eth_rx_port_t *port = &s_ports[s_port_cnt];
+    port->eth_handle = eth_handle;
+
+#if ETH_RX_HW_CAPTURE
+    if (int_gpio >= 0) {
+        gptimer_config_t timer_config = {
+            .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+            .direction = GPTIMER_COUNT_UP,
+            .resolution_hz = 1 * 1000 * 1000,  // 1 MHz
+        };
+        ESP_GOTO_ON_ERROR(gptimer_new_timer(&timer_config, &port->timer), err, TAG, "GPTimer create failed");
+        ESP_GOTO_ON_ERROR(gptimer_enable(port->timer), err, TAG, "GPTimer enable failed");
+        ESP_GOTO_ON_ERROR(gptimer_start(port->timer), err, TAG, "GPTimer start failed");
+
+        // the INT lines of DM9051, W5500 and KSZ8851 are active low
+        gpio_etm_event_config_t event_config = {
+            .edge = GPIO_ETM_EVENT_EDGE_NEG,
+        };
+        esp_etm_event_handle_t gpio_event = NULL;
+        ESP_GOTO_ON_ERROR(gpio_new_etm_event(&event_config, &gpio_event), err, TAG, "GPIO ETM event failed");
+        ESP_GOTO_ON_ERROR(gpio_etm_event_bind_gpio(gpio_event, int_gpio), err, TAG, "GPIO ETM bind failed");
+        gptimer_etm_task_config_t task_config = {
+            .task_type = GPTIMER_ETM_TASK_CAPTURE,
+        };
+        esp_etm_task_handle_t capture_task = NULL;
+        ESP_GOTO_ON_ERROR(gptimer_new_etm_task(port->timer, &task_config, &capture_task), err, TAG,
+                          "GPTimer ETM task failed");
+        esp_etm_channel_config_t channel_config = {};
+        esp_etm_channel_handle_t channel = NULL;
+        ESP_GOTO_ON_ERROR(esp_etm_new_channel(&channel_config, &channel), err, TAG, "ETM channel failed");
+        ESP_GOTO_ON_ERROR(esp_etm_channel_connect(channel, gpio_event, capture_task), err, TAG,
+                          "ETM connect failed");
+        ESP_GOTO_ON_ERROR(esp_etm_channel_enable(channel), err, TAG, "ETM enable failed");
+    }
+#elif CONFIG_EXAMPLE_ETH_SPI_LOW_LATENCY
+    if (int_gpio >= 0) {
+        ESP_LOGW(TAG, "No ETM on this target, frames are timestamped at stack input");
+    }
+#endif
+
+    if (s_port_cnt == 0) {
+        const esp_timer_create_args_t args = {
+            .callback = eth_rx_latency_report,
+            .name = "eth_rx_latency",
+        };
+        esp_timer_handle_t timer;
+        ESP_GOTO_ON_ERROR(esp_timer_create(&args, &timer), err, TAG, "report timer create failed");
+        ESP_GOTO_ON_ERROR(esp_timer_start_periodic(timer, ETH_RX_REPORT_INTERVAL_US), err, TAG,
+                          "report timer start failed");
+    }
+    s_port_cnt++;
+err:
+    return ret;
+}
+
+esp_err_t eth_rx_timestamp_attach(esp_eth_handle_t eth_handle, esp_netif_t *netif)
+{
+    for (int i = 0; i < s_port_cnt; i++) {
+        if (s_ports[i].eth_handle == eth_handle) {
+            s_ports[i].netif = netif;
+            return esp_eth_update_input_path(eth_handle, eth_rx_input, &s_ports[i]);
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+bool eth_rx_ntp_timestamp(const eth_ntp_frame_key_t *key, uint64_t *time_ns)
+{
+    bool found = false;
+    portENTER_CRITICAL(&s_lock);
+    // newest first, the request the server just read is usually the last one recorded
+    for (int n = 1; n <= ETH_RX_NTP_RING_LEN && !found; n++) {
+        eth_rx_ntp_entry_t *entry = &s_ntp_ring[(s_ntp_next + ETH_RX_NTP_RING_LEN - n) % ETH_RX_NTP_RING_LEN];
+        found = entry->pending && entry->key.src_addr == key->src_addr && entry->key.src_port == key->src_port &&
+                memcmp(entry->key.xmt, key->xmt, sizeof(key->xmt)) == 0;
+        if (found) {
+            int64_t gain = ((int64_t)*time_ns - (int64_t)entry->time_ns) / 1000;
+            uint32_t gain_us = gain > 0 ? (uint32_t)gain : 0;
+            if (s_ntp_stats.matched == 0 || gain_us < s_ntp_stats.gain_min_us) {
+                s_ntp_stats.gain_min_us = gain_us;
+            }
+            if (gain_us > s_ntp_stats.gain_max_us) {
+                s_ntp_stats.gain_max_us = gain_us;
+            }
+            s_ntp_stats.matched++;
+            s_ntp_stats.gain_sum_us += gain_us;
+            entry->pending = false;
+            *time_ns = entry->time_ns;
+        }
+    }
+    if (!found) {
+        s_ntp_stats.missed++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return found;
+}
+
+void eth_rx_ntp_stats_get(eth_rx_ntp_stats_t *stats)
+{
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_ntp_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+bool eth_rx_latency_get(int index, eth_rx_latency_t *latency)
+{
+    if (index < 0 || index >= s_port_cnt) {
+        return false;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *latency = s_ports[index].latency;
+    portEXIT_CRITICAL(&s_lock);
+    return true;
+}
+
+#endif // CONFIG_EXAMPLE_ETH_RX_TIMESTAMP
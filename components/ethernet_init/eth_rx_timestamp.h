@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_eth_driver.h"
+#include "esp_netif.h"
+#include "eth_ntp_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ETH_RX_LATENCY_BUCKETS 16  // log2 microseconds, last bucket collects everything above 16 ms
+
+/**
+ * @brief INT edge to stack input latency of one SPI Ethernet module in low-latency mode
+ */
+typedef struct {
+    uint32_t frames;    /*!< frames passed to the stack */
+    uint32_t captured;  /*!< frames with a latched INT edge, only these are in the statistics below */
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t histogram[ETH_RX_LATENCY_BUCKETS];
+} eth_rx_latency_t;
+
+/**
+ * @brief Statistics of the NTP receive timestamps taken by the hook
+ */
+typedef struct {
+    uint32_t matched;      /*!< requests the server found in the hook's ring */
+    uint32_t missed;       /*!< requests the hook did not see (VLAN, IP options, ring overrun) */
+    uint32_t overwritten;  /*!< requests in the ring replaced before the server read them, the ring is too short */
+    uint32_t gain_min_us;  /*!< gain: server timestamp after recvfrom() minus hook timestamp */
+    uint32_t gain_max_us;
+    uint64_t gain_sum_us;
+} eth_rx_ntp_stats_t;
+
+/**
+ * @brief Timestamp the frames of an Ethernet port when the driver hands them to the stack
+ * @note Called by the Ethernet init for each port. For SPI modules in low-latency mode the time of the INT
+ *       edge is latched in hardware (ETM: GPIO edge -> GPTimer capture) and used instead.
+ *
+ * @param[in] eth_handle driver handle of the port
+ * @param[in] int_gpio INT line of an SPI module in low-latency mode, -1 otherwise
+ * @return
+ *          - ESP_OK on success, also if the target has no ETM (frames are then timestamped at stack input)
+ *          - ESP_ERR_NO_MEM when all ports are used
+ */
+esp_err_t eth_rx_timestamp_register(esp_eth_handle_t eth_handle, int int_gpio);
+
+/**
+ * @brief Insert the timestamping hook between the driver and the TCP/IP stack
+ * @note Must be called after esp_netif_attach(), it replaces the input path installed by the netif glue
+ *
+ * @param[in] eth_handle driver handle registered with eth_rx_timestamp_register()
+ * @param[in] netif network interface the frames are passed on to
+ * @return
+ *          - ESP_OK on success
+ *          - ESP_ERR_NOT_FOUND if the handle was not registered
+ */
+esp_err_t eth_rx_timestamp_attach(esp_eth_handle_t eth_handle, esp_netif_t *netif);
+
+/**
+ * @brief Replace the receive timestamp of an NTP request by its arrival time
+ * @note Both are timebase_hires_realtime_ns(), the difference is added to the statistics
+ *
+ * @param[in] key source and transmit timestamp of the request
+ * @param[inout] time_ns time the server read the request, replaced by the arrival time if the hook saw it
+ * @return true if the request was seen by the hook
+ */
+bool eth_rx_ntp_timestamp(const eth_ntp_frame_key_t *key, uint64_t *time_ns);
+
+/**
+ * @brief Copy the NTP receive timestamp statistics
+ *
+ * @param[out] stats statistics since startup
+ */
+void eth_rx_ntp_stats_get(eth_rx_ntp_stats_t *stats);
+
+/**
+ * @brief Copy the latency statistics of a module
+ *
+ * @param[in] index module in the order of registration
+ * @param[out] latency statistics
+ * @return false if there is no such module
+ */
+bool eth_rx_latency_get(int index, eth_rx_latency_t *latency);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,7 +3,9 @@
  *
  * SPDX-License-Identifier: Unlicense OR CC0-1.0
  */
+#include <inttypes.h>
 #include "ethernet_init.h"
+#include "eth_rx_timestamp.h"
 #include "esp_log.h"
 #include "esp_check.h"
 #include "esp_mac.h"
@@ -99,6 +101,10 @@ static esp_eth_handle_t eth_init_internal(esp_eth_mac_t **mac_out, esp_eth_phy_t
     esp_eth_config_t config = ETH_DEFAULT_CONFIG(mac, phy);
     ESP_GOTO_ON_FALSE(esp_eth_driver_install(&config, &eth_handle) == ESP_OK, NULL,
                         err, TAG, "Ethernet driver install failed");
+#if CONFIG_EXAMPLE_ETH_RX_TIMESTAMP
+    ESP_GOTO_ON_FALSE(eth_rx_timestamp_register(eth_handle, -1) == ESP_OK, NULL, err, TAG,
+                      "Ethernet RX timestamp setup failed");
+#endif // CONFIG_EXAMPLE_ETH_RX_TIMESTAMP
 
     if (mac_out != NULL) {
         *mac_out = mac;
@@ -179,6 +185,17 @@ static esp_eth_handle_t eth_init_spi(spi_eth_module_config_t *spi_eth_module_con
     eth_mac_config_t mac_config = ETH_MAC_DEFAULT_CONFIG();
     eth_phy_config_t phy_config = ETH_PHY_DEFAULT_CONFIG();
 
+#if CONFIG_EXAMPLE_ETH_SPI_LOW_LATENCY
+    // Read frames right after the INT edge: RX task above the application tasks and pinned to the core
+    // installing the driver, so it is not migrated while it waits for the SPI transfer
+    mac_config.rx_task_prio = CONFIG_EXAMPLE_ETH_SPI_RX_TASK_PRIO;
+    mac_config.flags |= ETH_MAC_FLAG_PIN_TO_CORE;
+    if (spi_eth_module_config->int_gpio < 0) {
+        ESP_LOGW(TAG, "Low-latency mode needs the INT GPIO, module is polled every %" PRIu32 " ms",
+                 spi_eth_module_config->polling_ms);
+    }
+#endif // CONFIG_EXAMPLE_ETH_SPI_LOW_LATENCY
+
     // Update PHY config based on board specific configuration
     phy_config.phy_addr = spi_eth_module_config->phy_addr;
     phy_config.reset_gpio_num = spi_eth_module_config->phy_reset_gpio;
@@ -221,6 +238,13 @@ static esp_eth_handle_t eth_init_spi(spi_eth_module_config_t *spi_eth_module_con
         ESP_GOTO_ON_FALSE(esp_eth_ioctl(eth_handle, ETH_CMD_S_MAC_ADDR, spi_eth_module_config->mac_addr) == ESP_OK,
                                         NULL, err, TAG, "SPI Ethernet MAC address config failed");
     }
+#if CONFIG_EXAMPLE_ETH_SPI_LOW_LATENCY
+    ESP_GOTO_ON_FALSE(eth_rx_timestamp_register(eth_handle, spi_eth_module_config->int_gpio) == ESP_OK,
+                                    NULL, err, TAG, "SPI Ethernet RX timestamp setup failed");
+#elif CONFIG_EXAMPLE_ETH_RX_TIMESTAMP
+    ESP_GOTO_ON_FALSE(eth_rx_timestamp_register(eth_handle, -1) == ESP_OK,
+                                    NULL, err, TAG, "SPI Ethernet RX timestamp setup failed");
+#endif // CONFIG_EXAMPLE_ETH_SPI_LOW_LATENCY
 
     if (mac_out != NULL) {
         *mac_out = mac;
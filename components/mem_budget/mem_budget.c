@@ -0,0 +1,178 @@
+#include "mem_budget.h"
+
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "mem_budget";
+
+typedef struct {
+    TaskHandle_t handle;  // NULL once the task has ended
+    uint32_t stack_size;
+    bool reading;  // a report reads the stack, the task waits with its exit
+    volatile uint32_t heap_allocs;
+    volatile uint32_t heap_bytes;
+} mem_budget_entry_t;
+
+static mem_budget_entry_t tasks[MEM_BUDGET_MAX_TASKS];
+static int task_count = 0;
+// tasks that ended before they were registered, a task of higher priority than app_main can fail at once
+static TaskHandle_t exited_early[MEM_BUDGET_MAX_TASKS];
+static int exited_early_count = 0;
+static mem_budget_static_t components[MEM_BUDGET_MAX_COMPONENTS];
+static int component_count = 0;
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool started = false;
+
+void mem_budget_register_task(TaskHandle_t task, uint32_t stack_size) {
+    if (task == NULL) {
+        ESP_LOGE(TAG, "Task creation failed");
+        return;
+    }
+    portENTER_CRITICAL(&lock);
+    for (int i = 0; i < exited_early_count; i++) {
+        if (exited_early[i] == task) {
+            exited_early[i] = exited_early[--exited_early_count];
+            portEXIT_CRITICAL(&lock);
+            return;
+        }
+    }
+    if (task_count < MEM_BUDGET_MAX_TASKS) {
+        tasks[task_count++] = (mem_budget_entry_t){.handle = task, .stack_size = stack_size};
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void mem_budget_task_exit(void) {
+    TaskHandle_t current = xTaskGetCurrentTaskHandle();
+    portENTER_CRITICAL(&lock);
+    int index = -1;
+    for (int i = 0; i < task_count; i++) {
+        if (tasks[i].handle == current) {
+            index = i;
+        }
+    }
+    if (index < 0 && exited_early_count < MEM_BUDGET_MAX_TASKS) {
+        exited_early[exited_early_count++] = current;
+    }
+    portEXIT_CRITICAL(&lock);
+    // waits for a report that is reading the stack of this task
+    while (index >= 0) {
+        portENTER_CRITICAL(&lock);
+        bool reading = tasks[index].reading;
+        if (!reading) {
+            tasks[index].handle = NULL;  // the slot is not reused, the heap hook may be reading it
+        }
+        portEXIT_CRITICAL(&lock);
+        if (!reading) {
+            break;
+        }
+        vTaskDelay(1);
+    }
+    vTaskDelete(NULL);
+}
+
+void mem_budget_add_static(const char *component, size_t bytes) {
+    portENTER_CRITICAL(&lock);
+    int i = 0;
+    while (i < component_count && strcmp(components[i].component, component) != 0) {
+        i++;
+    }
+    if (i < MEM_BUDGET_MAX_COMPONENTS) {
+        if (i == component_count) {
+            components[component_count++] = (mem_budget_static_t){.component = component};
+        }
+        components[i].bytes += bytes;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+#if CONFIG_MEM_BUDGET_FLAG_HEAP
+// called by the heap for every successful allocation (CONFIG_HEAP_USE_HOOKS), must not allocate or log
+void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps) {
+    if (!started || xPortInIsrContext()) {
+        return;
+    }
+    TaskHandle_t current = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < task_count; i++) {
+        if (tasks[i].handle == current) {
+            tasks[i].heap_allocs++;
+            tasks[i].heap_bytes += size;
+            return;
+        }
+    }
+}
+#endif
+
+int mem_budget_read(mem_budget_task_t *out, int max_tasks) {
+    int n = 0;
+    for (int i = 0; i < task_count && n < max_tasks; i++) {
+        portENTER_CRITICAL(&lock);
+        TaskHandle_t handle = tasks[i].handle;
+        tasks[i].reading = handle != NULL;
+        portEXIT_CRITICAL(&lock);
+        if (handle == NULL) {
+            continue;  // ended with mem_budget_task_exit()
+        }
+        out[n++] = (mem_budget_task_t){
+            .name = pcTaskGetName(handle),
+            .stack_size = tasks[i].stack_size,
+            .stack_free_min = uxTaskGetStackHighWaterMark(handle),  // bytes on ESP-IDF
+            .heap_allocs = tasks[i].heap_allocs,
+            .heap_bytes = tasks[i].heap_bytes,
+        };
+        portENTER_CRITICAL(&lock);
+        tasks[i].reading = false;
+        portEXIT_CRITICAL(&lock);
+    }
+    return n;
+}
+
+int mem_budget_read_static(mem_budget_static_t *out, int max_components) {
+    portENTER_CRITICAL(&lock);
+    int n = component_count < max_components ? component_count : max_components;
+    memcpy(out, components, n * sizeof(out[0]));
+    portEXIT_CRITICAL(&lock);
+    return n;
+}
+
+static void mem_budget_report(void *arg) {
+    mem_budget_task_t report[MEM_BUDGET_MAX_TASKS];
+    int n = mem_budget_read(report, MEM_BUDGET_MAX_TASKS);
+    for (int i = 0; i < n; i++) {
+        ESP_LOGI(TAG, "%-14s stack %5lu used %5lu heap allocs %lu (%lu bytes)", report[i].name,
+                 (unsigned long)report[i].stack_size, (unsigned long)(report[i].stack_size - report[i].stack_free_min),
+                 (unsigned long)report[i].heap_allocs, (unsigned long)report[i].heap_bytes);
+    }
+    mem_budget_static_t pools[MEM_BUDGET_MAX_COMPONENTS];
+    int pool_count = mem_budget_read_static(pools, MEM_BUDGET_MAX_COMPONENTS);
+    uint32_t total = 0;
+    for (int i = 0; i < pool_count; i++) {
+        ESP_LOGI(TAG, "%-14s static %5lu", pools[i].component, (unsigned long)pools[i].bytes);
+        total += pools[i].bytes;
+    }
+    ESP_LOGI(TAG, "static total %lu", (unsigned long)total);
+    ESP_LOGI(TAG, "internal RAM free %u (min %u), PSRAM free %u (min %u)",
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+             (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+             (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM));
+}
+
+void mem_budget_startup_done(void) {
+    started = true;
+    if (CONFIG_MEM_BUDGET_REPORT_INTERVAL_S == 0) {
+        return;
+    }
+    const esp_timer_create_args_t args = {
+        .callback = mem_budget_report,
+        .name = "mem_budget",
+    };
+    esp_timer_handle_t timer;
+    ESP_ERROR_CHECK(esp_timer_create(&args, &timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(timer, CONFIG_MEM_BUDGET_REPORT_INTERVAL_S * 1000000ULL));
+}
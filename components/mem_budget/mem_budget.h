@@ -0,0 +1,64 @@
+#pragma once
+
+// Memory budget of the application tasks: optional static allocation, stack high-water marks, heap allocations
+// made after startup and the static RAM of each component, reported periodically.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#define MEM_BUDGET_MAX_TASKS 8
+#define MEM_BUDGET_MAX_COMPONENTS 12
+
+#if CONFIG_MEM_BUDGET_STATIC
+// stack and TCB are static variables of the calling function, one per task
+#define MEM_BUDGET_CREATE_TASK(fn, name, stack_size, prio, core)                                          \
+    do {                                                                                                  \
+        static StackType_t fn##_stack[stack_size];                                                        \
+        static StaticTask_t fn##_tcb;                                                                     \
+        mem_budget_register_task(                                                                         \
+            xTaskCreateStaticPinnedToCore(fn, name, stack_size, NULL, prio, fn##_stack, &fn##_tcb, core), \
+            stack_size);                                                                                  \
+        mem_budget_add_static(name, sizeof(fn##_stack) + sizeof(fn##_tcb));                               \
+    } while (0)
+#else
+#define MEM_BUDGET_CREATE_TASK(fn, name, stack_size, prio, core)                       \
+    do {                                                                               \
+        TaskHandle_t fn##_handle = NULL;                                               \
+        xTaskCreatePinnedToCore(fn, name, stack_size, NULL, prio, &fn##_handle, core); \
+        mem_budget_register_task(fn##_handle, stack_size);                             \
+    } while (0)
+#endif
+
+typedef struct {
+    const char *name;
+    uint32_t stack_size;
+    uint32_t stack_free_min;  // high-water mark, bytes never used
+    uint32_t heap_allocs;     // allocations after mem_budget_startup_done()
+    uint32_t heap_bytes;
+} mem_budget_task_t;
+
+typedef struct {
+    const char *component;
+    uint32_t bytes;
+} mem_budget_static_t;
+
+void mem_budget_register_task(TaskHandle_t task, uint32_t stack_size);
+
+// deregisters and deletes the calling task, for tasks that end: a deleted task must not be reported
+void mem_budget_task_exit(void);
+
+// counts static pools (sizeof) of a component, in static mode also the task stacks, TCBs and queue storage
+void mem_budget_add_static(const char *component, size_t bytes);
+
+// ends the startup phase, later heap allocations of registered tasks are counted
+void mem_budget_startup_done(void);
+
+// returns the number of running tasks written to tasks
+int mem_budget_read(mem_budget_task_t *tasks, int max_tasks);
+
+// returns the number of components written to components
+int mem_budget_read_static(mem_budget_static_t *components, int max_components);
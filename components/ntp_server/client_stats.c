@@ -0,0 +1,236 @@
+#include "client_stats.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "mem_budget.h"
+
+#if CONFIG_NTP_SERVER_CLIENT_STATS
+
+static const char *TAG = "client_stats";
+
+#define TOP_K CONFIG_NTP_SERVER_CLIENT_STATS_TOP_K
+// open addressing index address -> talker, at most a quarter full for TOP_K <= 64
+#define INDEX_BITS 8
+#define INDEX_SIZE (1 << INDEX_BITS)
+// HyperLogLog with 2^10 one byte registers, standard error 1.04 / sqrt(1024) = 3.3 %
+#define HLL_BITS 10
+#define HLL_REGISTERS (1 << HLL_BITS)
+
+typedef struct {
+    uint32_t requests;
+    uint32_t poll_histogram[CLIENT_STATS_POLL_BUCKETS];
+    client_stats_talker_t top[TOP_K];
+    uint8_t top_used;
+    // min-heap of the talkers by count, heap_pos is the inverse, so the entry to replace is always heap[0]
+    uint8_t heap[TOP_K];
+    uint8_t heap_pos[TOP_K];
+    uint8_t index[INDEX_SIZE];  // talker + 1, 0 is empty
+    uint8_t hll[HLL_REGISTERS];
+    // sum of 2^-register in 32.32 fixed point and number of empty registers, kept up to date so
+    // reading the estimate needs no pass over the registers
+    uint64_t hll_sum;
+    uint16_t hll_zeros;
+} client_stats_t;
+
+static client_stats_t stats = {.hll_sum = (uint64_t)HLL_REGISTERS << 32, .hll_zeros = HLL_REGISTERS};
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// 32 bit finalizer of MurmurHash3, spreads the mostly constant network prefix over all bits
+static inline uint32_t hash32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x85ebca6b;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35;
+    x ^= x >> 16;
+    return x;
+}
+
+static inline uint32_t index_home(uint32_t h) { return h & (INDEX_SIZE - 1); }
+
+static inline int index_find(uint32_t addr, uint32_t h) {
+    for (uint32_t slot = index_home(h); stats.index[slot] != 0; slot = (slot + 1) & (INDEX_SIZE - 1)) {
+        if (stats.top[stats.index[slot] - 1].addr == addr) {
+            return stats.index[slot] - 1;
+        }
+    }
+    return -1;
+}
+
+static inline void index_insert(int talker, uint32_t h) {
+    uint32_t slot = index_home(h);
+    while (stats.index[slot] != 0) {
+        slot = (slot + 1) & (INDEX_SIZE - 1);
+    }
+    stats.index[slot] = talker + 1;
+}
+
+// linear probing deletion: later entries of the probe sequence move back into the gap
+static inline void index_remove(uint32_t addr) {
+    uint32_t gap = index_home(hash32(addr));
+    while (stats.top[stats.index[gap] - 1].addr != addr) {
+        gap = (gap + 1) & (INDEX_SIZE - 1);
+    }
+    for (uint32_t slot = (gap + 1) & (INDEX_SIZE - 1); stats.index[slot] != 0; slot = (slot + 1) & (INDEX_SIZE - 1)) {
+        uint32_t home = index_home(hash32(stats.top[stats.index[slot] - 1].addr));
+        // the entry may move if the gap lies on its probe path from home to slot
+        if (((slot - home) & (INDEX_SIZE - 1)) >= ((slot - gap) & (INDEX_SIZE - 1))) {
+            stats.index[gap] = stats.index[slot];
+            gap = slot;
+        }
+    }
+    stats.index[gap] = 0;
+}
+
+static inline void heap_swap(int a, int b) {
+    uint8_t t = stats.heap[a];
+    stats.heap[a] = stats.heap[b];
+    stats.heap[b] = t;
+    stats.heap_pos[stats.heap[a]] = a;
+    stats.heap_pos[stats.heap[b]] = b;
+}
+
+static inline void heap_sift_up(int pos) {
+    while (pos > 0 && stats.top[stats.heap[pos]].count < stats.top[stats.heap[(pos - 1) / 2]].count) {
+        heap_swap(pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+}
+
+static inline void heap_sift_down(int pos) {
+    while (1) {
+        int smallest = pos;
+        for (int child = 2 * pos + 1; child <= 2 * pos + 2 && child < stats.top_used; child++) {
+            if (stats.top[stats.heap[child]].count < stats.top[stats.heap[smallest]].count) {
+                smallest = child;
+            }
+        }
+        if (smallest == pos) {
+            return;
+        }
+        heap_swap(pos, smallest);
+        pos = smallest;
+    }
+}
+
+// space-saving: a new address replaces the entry with the smallest count and inherits it as error.
+// The hashed index finds the address and the heap the minimum, O(log K) per request instead of a pass over all K.
+static inline void top_update(uint32_t addr, uint32_t h) {
+    int talker = index_find(addr, h);
+    if (talker >= 0) {
+        stats.top[talker].count++;
+        heap_sift_down(stats.heap_pos[talker]);
+        return;
+    }
+    if (stats.top_used < TOP_K) {
+        talker = stats.top_used++;
+        stats.top[talker] = (client_stats_talker_t){.addr = addr, .count = 1, .error = 0};
+        stats.heap[talker] = talker;
+        stats.heap_pos[talker] = talker;
+        heap_sift_up(talker);
+        index_insert(talker, h);
+        return;
+    }
+    talker = stats.heap[0];
+    index_remove(stats.top[talker].addr);
+    stats.top[talker].addr = addr;
+    stats.top[talker].error = stats.top[talker].count;
+    stats.top[talker].count++;
+    index_insert(talker, h);
+    heap_sift_down(0);
+}
+
+void client_stats_update(uint32_t addr, int8_t poll) {
+    uint32_t h = hash32(addr);
+    uint32_t index = h >> (32 - HLL_BITS);
+    // rank = position of the first 1 bit in the remaining bits, an all zero rest counts as one more
+    uint32_t rest = h << HLL_BITS;
+    uint8_t rank = rest ? __builtin_clz(rest) + 1 : 32 - HLL_BITS + 1;
+    uint8_t bucket = poll < 0 ? 0 : (poll >= CLIENT_STATS_POLL_BUCKETS ? CLIENT_STATS_POLL_BUCKETS - 1 : poll);
+
+    portENTER_CRITICAL(&stats_lock);
+    stats.requests++;
+    stats.poll_histogram[bucket]++;
+    uint8_t old = stats.hll[index];
+    if (rank > old) {
+        stats.hll_sum += (1ULL << (32 - rank)) - (1ULL << (32 - old));
+        stats.hll_zeros -= old == 0;
+        stats.hll[index] = rank;
+    }
+    top_update(addr, h);
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+static uint32_t hll_estimate(uint64_t sum, uint16_t zeros) {
+    const double m = HLL_REGISTERS;
+    double estimate = (0.7213 / (1 + 1.079 / m)) * m * m / ldexp((double)sum, -32);
+    // linear counting for small cardinalities
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * log(m / zeros);
+    }
+    return (uint32_t)(estimate + 0.5);
+}
+
+void client_stats_read(client_stats_report_t *report, bool reset) {
+    memset(report, 0, sizeof(*report));
+    portENTER_CRITICAL(&stats_lock);
+    report->requests = stats.requests;
+    memcpy(report->poll_histogram, stats.poll_histogram, sizeof(report->poll_histogram));
+    memcpy(report->top, stats.top, stats.top_used * sizeof(client_stats_talker_t));
+    uint64_t hll_sum = stats.hll_sum;
+    uint16_t hll_zeros = stats.hll_zeros;
+    if (reset) {
+        memset(&stats, 0, sizeof(stats));
+        stats.hll_sum = (uint64_t)HLL_REGISTERS << 32;
+        stats.hll_zeros = HLL_REGISTERS;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+    report->distinct_clients = hll_estimate(hll_sum, hll_zeros);
+
+    // insertion sort by count, unused entries have count 0 and stay at the end
+    for (int i = 1; i < TOP_K; i++) {
+        client_stats_talker_t t = report->top[i];
+        int j = i - 1;
+        for (; j >= 0 && report->top[j].count < t.count; j--) {
+            report->top[j + 1] = report->top[j];
+        }
+        report->top[j + 1] = t;
+    }
+}
+
+static void client_stats_report(void *arg) {
+    client_stats_report_t report;
+    client_stats_read(&report, true);
+    ESP_LOGI(TAG, "%lu requests from ~%lu clients", (unsigned long)report.requests,
+             (unsigned long)report.distinct_clients);
+    for (int i = 0; i < TOP_K && report.top[i].count > 0; i++) {
+        const uint8_t *ip = (const uint8_t *)&report.top[i].addr;
+        ESP_LOGI(TAG, "  %u.%u.%u.%u: %lu..%lu requests", ip[0], ip[1], ip[2], ip[3],
+                 (unsigned long)(report.top[i].count - report.top[i].error), (unsigned long)report.top[i].count);
+    }
+    for (int i = 0; i < CLIENT_STATS_POLL_BUCKETS; i++) {
+        if (report.poll_histogram[i] > 0) {
+            ESP_LOGI(TAG, "  poll 2^%d s: %lu requests", i, (unsigned long)report.poll_histogram[i]);
+        }
+    }
+}
+
+void client_stats_start_reporting(void) {
+    mem_budget_add_static("ntp_server", sizeof(stats));
+    if (CONFIG_NTP_SERVER_CLIENT_STATS_WINDOW_S == 0) {
+        return;
+    }
+    const esp_timer_create_args_t args = {
+        .callback = client_stats_report,
+        .name = "client_stats",
+    };
+    esp_timer_handle_t timer;
+    ESP_ERROR_CHECK(esp_timer_create(&args, &timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(timer, CONFIG_NTP_SERVER_CLIENT_STATS_WINDOW_S * 1000000ULL));
+}
+
+#endif  // CONFIG_NTP_SERVER_CLIENT_STATS
@@ -0,0 +1,39 @@
+#pragma once
+
+// Bounded memory statistics about the NTP clients, updated inline for every request:
+// - top-K talkers (space-saving algorithm, count is an upper bound, count - error a lower bound)
+// - number of distinct clients (HyperLogLog, about 3 % standard error)
+// - histogram of the poll interval the clients announce in their requests
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+#define CLIENT_STATS_POLL_BUCKETS 18  // log2 poll interval 0 (1 s) .. 17 (36 h)
+
+#ifndef CONFIG_NTP_SERVER_CLIENT_STATS_TOP_K
+#define CONFIG_NTP_SERVER_CLIENT_STATS_TOP_K 16
+#endif
+
+typedef struct {
+    uint32_t addr;  // IPv4 address, network byte order
+    uint32_t count;
+    uint32_t error;
+} client_stats_talker_t;
+
+typedef struct {
+    uint32_t requests;
+    uint32_t distinct_clients;  // estimate
+    uint32_t poll_histogram[CLIENT_STATS_POLL_BUCKETS];
+    client_stats_talker_t top[CONFIG_NTP_SERVER_CLIENT_STATS_TOP_K];  // sorted by count, unused entries are 0
+} client_stats_report_t;
+
+// one request of a client, poll is the poll field of the request
+void client_stats_update(uint32_t addr, int8_t poll);
+
+// copies the statistics of the current window and optionally starts a new window
+void client_stats_read(client_stats_report_t *report, bool reset);
+
+// logs and resets the statistics every CONFIG_NTP_SERVER_CLIENT_STATS_WINDOW_S
+void client_stats_start_reporting(void);
@@ -0,0 +1,160 @@
+#include "ntp_auth.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "mbedtls/cipher.h"
+#include "mbedtls/cmac.h"
+#include "mem_budget.h"
+#include "ntp_md5.h"
+#include "nvs.h"
+#include "sdkconfig.h"
+
+#if CONFIG_NTP_SERVER_AUTH
+
+static const char *TAG = "ntp_auth";
+
+#define NTP_HEADER_SIZE 48
+#define NTP_DIGEST_SIZE 16
+#define AES_KEY_SIZE 16
+
+// AES-CMAC runs in mbedtls (the AES peripheral on the target) with a context per key, set up when the key is added.
+// Only the server task verifies and signs, so the contexts need no lock.
+typedef struct {
+    uint32_t key_id;
+    uint8_t type;
+    union {
+        struct {
+            uint8_t key[NTP_AUTH_MD5_MAX_KEY_SIZE];
+            uint8_t len;
+        } md5;
+        mbedtls_cipher_context_t cmac;
+    };
+} ntp_key_t;
+
+static ntp_key_t keys[CONFIG_NTP_SERVER_AUTH_MAX_KEYS];
+static int key_count = 0;
+
+static ntp_key_t *find_key(uint32_t key_id) {
+    for (int i = 0; i < key_count; i++) {
+        if (keys[i].key_id == key_id) {
+            return &keys[i];
+        }
+    }
+    return NULL;
+}
+
+static void compute_digest(ntp_key_t *key, const uint8_t *packet, uint8_t digest[NTP_DIGEST_SIZE]) {
+    if (key->type == NTP_AUTH_TYPE_MD5) {
+        ntp_md5(key->md5.key, key->md5.len, packet, NTP_HEADER_SIZE, digest);
+    } else {
+        mbedtls_cipher_cmac_reset(&key->cmac);
+        mbedtls_cipher_cmac_update(&key->cmac, packet, NTP_HEADER_SIZE);
+        mbedtls_cipher_cmac_finish(&key->cmac, digest);
+    }
+}
+
+bool ntp_auth_add_key(uint32_t key_id, uint8_t type, const uint8_t *secret, size_t secret_len) {
+    if (key_id == 0 || key_count >= CONFIG_NTP_SERVER_AUTH_MAX_KEYS || find_key(key_id) != NULL) {
+        return false;
+    }
+    ntp_key_t *key = &keys[key_count];
+    key->key_id = key_id;
+    key->type = type;
+    if (type == NTP_AUTH_TYPE_MD5 && secret_len >= 1 && secret_len <= NTP_AUTH_MD5_MAX_KEY_SIZE) {
+        memcpy(key->md5.key, secret, secret_len);
+        key->md5.len = secret_len;
+    } else if (type == NTP_AUTH_TYPE_AES_CMAC && secret_len == AES_KEY_SIZE) {
+        mbedtls_cipher_init(&key->cmac);
+        if (mbedtls_cipher_setup(&key->cmac, mbedtls_cipher_info_from_type(MBEDTLS_CIPHER_AES_128_ECB)) != 0 ||
+            mbedtls_cipher_cmac_starts(&key->cmac, secret, AES_KEY_SIZE * 8) != 0) {
+            mbedtls_cipher_free(&key->cmac);
+            return false;
+        }
+    } else {
+        return false;
+    }
+    key_count++;
+    return true;
+}
+
+void ntp_auth_remove_key(uint32_t key_id) {
+    for (int i = 0; i < key_count; i++) {
+        if (keys[i].key_id == key_id) {
+            if (keys[i].type == NTP_AUTH_TYPE_AES_CMAC) {
+                mbedtls_cipher_free(&keys[i].cmac);
+            }
+            keys[i] = keys[--key_count];
+            memset(&keys[key_count], 0, sizeof(keys[key_count]));
+            return;
+        }
+    }
+}
+
+esp_err_t ntp_auth_load_keys(void) {
+    mem_budget_add_static("ntp_server", sizeof(keys));
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NTP_AUTH_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "No key table in NVS (%s)", esp_err_to_name(err));
+        return err;
+    }
+
+    nvs_iterator_t it = NULL;
+    esp_err_t res = nvs_entry_find(NVS_DEFAULT_PART_NAME, NTP_AUTH_NVS_NAMESPACE, NVS_TYPE_BLOB, &it);
+    while (res == ESP_OK && key_count < CONFIG_NTP_SERVER_AUTH_MAX_KEYS) {
+        nvs_entry_info_t info;
+        nvs_entry_info(it, &info);
+        uint8_t blob[1 + NTP_AUTH_MD5_MAX_KEY_SIZE];
+        size_t len = sizeof(blob);
+        unsigned long key_id = strtoul(info.key, NULL, 10);
+        if (key_id == 0 || nvs_get_blob(handle, info.key, blob, &len) != ESP_OK || len < 2 ||
+            !ntp_auth_add_key(key_id, blob[0], &blob[1], len - 1)) {
+            ESP_LOGW(TAG, "Ignoring invalid key entry '%s'", info.key);
+        }
+        memset(blob, 0, sizeof(blob));
+        res = nvs_entry_next(&it);
+    }
+    nvs_release_iterator(it);
+    nvs_close(handle);
+    ESP_LOGI(TAG, "%d key(s) loaded", key_count);
+    return ESP_OK;
+}
+
+bool ntp_auth_verify(const uint8_t *packet, size_t len, uint32_t *key_id) {
+    if (len != NTP_HEADER_SIZE + NTP_AUTH_MAC_SIZE) {
+        return false;
+    }
+    const uint8_t *mac = &packet[NTP_HEADER_SIZE];
+    uint32_t id = ((uint32_t)mac[0] << 24) | (mac[1] << 16) | (mac[2] << 8) | mac[3];
+    *key_id = id;
+    ntp_key_t *key = find_key(id);
+    if (key == NULL) {
+        return false;
+    }
+    uint8_t digest[NTP_DIGEST_SIZE];
+    compute_digest(key, packet, digest);
+    // constant time compare
+    uint8_t diff = 0;
+    for (int i = 0; i < NTP_DIGEST_SIZE; i++) {
+        diff |= digest[i] ^ mac[4 + i];
+    }
+    return diff == 0;
+}
+
+size_t ntp_auth_sign(uint8_t *packet, uint32_t key_id) {
+    ntp_key_t *key = find_key(key_id);
+    if (key == NULL) {
+        return NTP_HEADER_SIZE;
+    }
+    uint8_t *mac = &packet[NTP_HEADER_SIZE];
+    mac[0] = key_id >> 24;
+    mac[1] = (key_id >> 16) & 0xFF;
+    mac[2] = (key_id >> 8) & 0xFF;
+    mac[3] = key_id & 0xFF;
+    compute_digest(key, packet, &mac[4]);
+    return NTP_HEADER_SIZE + NTP_AUTH_MAC_SIZE;
+}
+
+#endif  // CONFIG_NTP_SERVER_AUTH
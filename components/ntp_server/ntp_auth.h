@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// NVS namespace of the key table. Each entry is a blob named by the decimal key id ("1".."65535"),
+// the first byte is the key type, followed by the key itself.
+#define NTP_AUTH_NVS_NAMESPACE "ntp_keys"
+#define NTP_AUTH_TYPE_MD5 1       // RFC 5905 legacy MAC, MD5(key || packet), 1 to 20 byte key
+#define NTP_AUTH_TYPE_AES_CMAC 2  // RFC 8573 AES-128-CMAC, 16 byte key
+#define NTP_AUTH_MD5_MAX_KEY_SIZE 20
+
+// key id (4 byte) + 16 byte digest, the same for both MAC types
+#define NTP_AUTH_MAC_SIZE 20
+
+// Loads the key table from NVS and precomputes key schedules, called once before serving
+esp_err_t ntp_auth_load_keys(void);
+
+// Adds a key to the table and precomputes its key schedule, returns false for an invalid key, a key id already in
+// the table or a full table. Not thread safe, keys are added before serving.
+bool ntp_auth_add_key(uint32_t key_id, uint8_t type, const uint8_t *secret, size_t secret_len);
+
+// Removes a key added before, not thread safe either
+void ntp_auth_remove_key(uint32_t key_id);
+
+// Verifies the MAC trailer following the 48 byte header, returns the key id of a valid MAC in key_id
+bool ntp_auth_verify(const uint8_t *packet, size_t len, uint32_t *key_id);
+
+// Appends the MAC trailer of the 48 byte packet with the given key and returns the new packet length
+size_t ntp_auth_sign(uint8_t *packet, uint32_t key_id);
+
+typedef struct {
+    uint32_t unauthenticated_per_s;
+    uint32_t md5_per_s;
+    uint32_t aes_cmac_per_s;
+} ntp_auth_bench_t;
+
+// Requests per second of the request path (MAC check, response assembly, signature) without MAC, with MD5 and with
+// AES-CMAC, measured with two random temporary keys on the calling task. Leaves the server counters and statistics
+// alone. Returns false without running if a key id of the benchmark is in the table, then result is all zero.
+bool ntp_auth_bench(uint32_t requests, ntp_auth_bench_t *result);
@@ -0,0 +1,75 @@
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_random.h"
+#include "ntp_auth.h"
+#include "ntp_packet.h"
+#include "sdkconfig.h"
+#include "timebase.h"
+#include "udp_server_task.h"
+
+#if CONFIG_NTP_SERVER_AUTH
+
+static const char *TAG = "ntp_auth_bench";
+
+// temporary key ids, removed again after the run
+#define BENCH_MD5_KEY_ID 0xFFFFFF01
+#define BENCH_CMAC_KEY_ID 0xFFFFFF02
+
+// the work of ntp_server_respond() for one request, without the counters, statistics and tracepoints
+static uint32_t requests_per_s(uint32_t requests, uint32_t key_id) {
+    char request[NTP_PACKET_SIZE + NTP_AUTH_MAC_SIZE] = {0};
+    char packet[sizeof(request)];
+    request[0] = 0x23;  // version 4, mode 3 (client)
+    request[2] = 6;
+    size_t len = key_id != 0 ? ntp_auth_sign((uint8_t *)request, key_id) : NTP_PACKET_SIZE;
+
+    int64_t start = timebase_monotonic_us();
+    for (uint32_t i = 0; i < requests; i++) {
+        // the response overwrites the request
+        memcpy(packet, request, len);
+        uint32_t request_key_id = 0;
+        if (key_id != 0 && !ntp_auth_verify((const uint8_t *)packet, len, &request_key_id)) {
+            ESP_LOGE(TAG, "Request rejected, key %lu", (unsigned long)key_id);
+            return 0;
+        }
+        ntp_server_info_t info;
+        ntp_server_info(&info);
+        ntp_build_response(packet, 0b00011100, 4, &info, getCurrentTimeInNTP64BitFormat());
+        ntp_write_timestamp(&packet[40], getCurrentTimeInNTP64BitFormat());
+        if (key_id != 0) {
+            ntp_auth_sign((uint8_t *)packet, request_key_id);
+        }
+    }
+    int64_t elapsed = timebase_monotonic_us() - start;
+    return elapsed > 0 ? (uint32_t)(requests * 1000000LL / elapsed) : 0;
+}
+
+bool ntp_auth_bench(uint32_t requests, ntp_auth_bench_t *result) {
+    *result = (ntp_auth_bench_t){0};
+    uint8_t md5_key[16];
+    uint8_t cmac_key[16];
+    esp_fill_random(md5_key, sizeof(md5_key));
+    esp_fill_random(cmac_key, sizeof(cmac_key));
+    bool added = ntp_auth_add_key(BENCH_MD5_KEY_ID, NTP_AUTH_TYPE_MD5, md5_key, sizeof(md5_key));
+    if (!added || !ntp_auth_add_key(BENCH_CMAC_KEY_ID, NTP_AUTH_TYPE_AES_CMAC, cmac_key, sizeof(cmac_key))) {
+        if (added) {
+            ntp_auth_remove_key(BENCH_MD5_KEY_ID);
+        }
+        ESP_LOGE(TAG, "Key %lu or %lu is in use or the key table is full, not running",
+                 (unsigned long)BENCH_MD5_KEY_ID, (unsigned long)BENCH_CMAC_KEY_ID);
+        return false;
+    }
+    memset(md5_key, 0, sizeof(md5_key));
+    memset(cmac_key, 0, sizeof(cmac_key));
+    result->unauthenticated_per_s = requests_per_s(requests, 0);
+    result->md5_per_s = requests_per_s(requests, BENCH_MD5_KEY_ID);
+    result->aes_cmac_per_s = requests_per_s(requests, BENCH_CMAC_KEY_ID);
+    ntp_auth_remove_key(BENCH_MD5_KEY_ID);
+    ntp_auth_remove_key(BENCH_CMAC_KEY_ID);
+    ESP_LOGI(TAG, "Requests/s without MAC %lu, MD5 %lu, AES-CMAC %lu", (unsigned long)result->unauthenticated_per_s,
+             (unsigned long)result->md5_per_s, (unsigned long)result->aes_cmac_per_s);
+    return true;
+}
+
+#endif  // CONFIG_NTP_SERVER_AUTH
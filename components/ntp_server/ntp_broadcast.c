@@ -0,0 +1,129 @@
+#include <string.h>
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include "mem_budget.h"
+#include "sdkconfig.h"
+#include "udp_server_task.h"
+
+#if CONFIG_NTP_SERVER_BROADCAST
+
+static const char *TAG = "ntp_broadcast";
+
+#define NTP_PORT 123
+#define NTP_MAX_DESTINATIONS 3
+
+static int ntp_broadcast_socket(int addr_family) {
+    int sock = socket(addr_family, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        return -1;
+    }
+    int err = 0;
+    if (addr_family == AF_INET) {
+        int enable = 1;
+        err |= setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable));
+#if CONFIG_NTP_SERVER_MULTICAST_IPV4
+        uint8_t ttl = CONFIG_NTP_SERVER_MULTICAST_TTL;
+        err |= setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+#endif
+    }
+#if CONFIG_NTP_SERVER_MULTICAST_IPV6
+    if (addr_family == AF_INET6) {
+        int hops = CONFIG_NTP_SERVER_MULTICAST_TTL;
+        err |= setsockopt(sock, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, &hops, sizeof(hops));
+    }
+#endif
+    if (err < 0) {
+        ESP_LOGE(TAG, "Socket options failed: errno %d", errno);
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+bool ntp_broadcast_packet(char *ntp_packet) {
+    ntp_server_info_t info;
+    ntp_server_info(&info);
+    // the time source decides, without clock selection the first decoded time code frame
+    if (info.leap == 3) {
+        return false;
+    }
+    // origin and receive timestamps stay zero in broadcast mode
+    memset(ntp_packet, 0, NTP_PACKET_SIZE);
+    // LI 0, version 4, mode 5 (broadcast server)
+    ntp_write_header(ntp_packet, 0b00100101, CONFIG_NTP_SERVER_BROADCAST_POLL, &info);
+    return true;
+}
+
+void ntp_broadcast_task(void *pvParameters) {
+    char ntp_packet[NTP_PACKET_SIZE];
+    struct sockaddr_storage dest_addr[NTP_MAX_DESTINATIONS];
+    int dest_sock[NTP_MAX_DESTINATIONS];
+    int dest_cnt = 0;
+
+    memset(dest_addr, 0, sizeof(dest_addr));
+#if CONFIG_NTP_SERVER_BROADCAST_IPV4 || CONFIG_NTP_SERVER_MULTICAST_IPV4
+    int sock4 = ntp_broadcast_socket(AF_INET);
+    if (sock4 < 0) {
+        mem_budget_task_exit();
+    }
+#endif
+#if CONFIG_NTP_SERVER_BROADCAST_IPV4
+    struct sockaddr_in *bcast = (struct sockaddr_in *)&dest_addr[dest_cnt];
+    bcast->sin_family = AF_INET;
+    bcast->sin_port = htons(NTP_PORT);
+    bcast->sin_addr.s_addr = htonl(INADDR_BROADCAST);
+    dest_sock[dest_cnt++] = sock4;
+#endif
+#if CONFIG_NTP_SERVER_MULTICAST_IPV4
+    struct sockaddr_in *mcast4 = (struct sockaddr_in *)&dest_addr[dest_cnt];
+    mcast4->sin_family = AF_INET;
+    mcast4->sin_port = htons(NTP_PORT);
+    if (inet_pton(AF_INET, CONFIG_NTP_SERVER_MULTICAST_IPV4_ADDR, &mcast4->sin_addr) == 1) {
+        dest_sock[dest_cnt++] = sock4;
+    } else {
+        ESP_LOGE(TAG, "Invalid IPv4 multicast group %s", CONFIG_NTP_SERVER_MULTICAST_IPV4_ADDR);
+    }
+#endif
+#if CONFIG_NTP_SERVER_MULTICAST_IPV6
+    int sock6 = ntp_broadcast_socket(AF_INET6);
+    struct sockaddr_in6 *mcast6 = (struct sockaddr_in6 *)&dest_addr[dest_cnt];
+    mcast6->sin6_family = AF_INET6;
+    mcast6->sin6_port = htons(NTP_PORT);
+    if (sock6 >= 0 && inet_pton(AF_INET6, CONFIG_NTP_SERVER_MULTICAST_IPV6_ADDR, &mcast6->sin6_addr) == 1) {
+        dest_sock[dest_cnt++] = sock6;
+    } else {
+        ESP_LOGE(TAG, "IPv6 multicast group %s not usable", CONFIG_NTP_SERVER_MULTICAST_IPV6_ADDR);
+    }
+#endif
+    ESP_LOGI(TAG, "Broadcasting to %d destination(s) every %lu s", dest_cnt,
+             1UL << CONFIG_NTP_SERVER_BROADCAST_POLL);
+
+    const TickType_t interval = pdMS_TO_TICKS(1000UL << CONFIG_NTP_SERVER_BROADCAST_POLL);
+    TickType_t last_wake = xTaskGetTickCount();
+    while (1) {
+        // fixed period independent of the time spent sending
+        vTaskDelayUntil(&last_wake, interval);
+
+        if (!ntp_broadcast_packet(ntp_packet)) {
+            ESP_LOGW(TAG, "Not synchronized yet, skipping broadcast");
+            continue;
+        }
+
+        for (int i = 0; i < dest_cnt; i++) {
+            socklen_t addr_len = dest_addr[i].ss_family == AF_INET6 ? sizeof(struct sockaddr_in6)
+                                                                     : sizeof(struct sockaddr_in);
+            // transmit time as late as possible, right before the packet is handed to the stack
+            ntp_write_timestamp(&ntp_packet[40], getCurrentTimeInNTP64BitFormat());
+            if (sendto(dest_sock[i], ntp_packet, NTP_PACKET_SIZE, 0, (struct sockaddr *)&dest_addr[i], addr_len) <
+                0) {
+                ESP_LOGW(TAG, "sendto failed: errno %d", errno);
+            }
+        }
+    }
+}
+
+#endif  // CONFIG_NTP_SERVER_BROADCAST
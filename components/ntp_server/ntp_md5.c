@@ -0,0 +1,92 @@
+#include "ntp_md5.h"
+
+#include <string.h>
+
+// RFC 1321
+static const uint32_t md5_k[64] = {
+    0xD76AA478, 0xE8C7B756, 0x242070DB, 0xC1BDCEEE, 0xF57C0FAF, 0x4787C62A, 0xA8304613, 0xFD469501,
+    0x698098D8, 0x8B44F7AF, 0xFFFF5BB1, 0x895CD7BE, 0x6B901122, 0xFD987193, 0xA679438E, 0x49B40821,
+    0xF61E2562, 0xC040B340, 0x265E5A51, 0xE9B6C7AA, 0xD62F105D, 0x02441453, 0xD8A1E681, 0xE7D3FBC8,
+    0x21E1CDE6, 0xC33707D6, 0xF4D50D87, 0x455A14ED, 0xA9E3E905, 0xFCEFA3F8, 0x676F02D9, 0x8D2A4C8A,
+    0xFFFA3942, 0x8771F681, 0x6D9D6122, 0xFDE5380C, 0xA4BEEA44, 0x4BDECFA9, 0xF6BB4B60, 0xBEBFBC70,
+    0x289B7EC6, 0xEAA127FA, 0xD4EF3085, 0x04881D05, 0xD9D4D039, 0xE6DB99E5, 0x1FA27CF8, 0xC4AC5665,
+    0xF4292244, 0x432AFF97, 0xAB9423A7, 0xFC93A039, 0x655B59C3, 0x8F0CCC92, 0xFFEFF47D, 0x85845DD1,
+    0x6FA87E4F, 0xFE2CE6E0, 0xA3014314, 0x4E0811A1, 0xF7537E82, 0xBD3AF235, 0x2AD7D2BB, 0xEB86D391,
+};
+
+static const uint8_t md5_r[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+};
+
+static void md5_block(uint32_t h[4], const uint8_t block[64]) {
+    uint32_t m[16];
+    for (int i = 0; i < 16; i++) {
+        m[i] = (uint32_t)block[4 * i] | ((uint32_t)block[4 * i + 1] << 8) | ((uint32_t)block[4 * i + 2] << 16) |
+               ((uint32_t)block[4 * i + 3] << 24);
+    }
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3];
+    for (int i = 0; i < 64; i++) {
+        uint32_t f;
+        int g;
+        if (i < 16) {
+            f = (b & c) | (~b & d);
+            g = i;
+        } else if (i < 32) {
+            f = (d & b) | (~d & c);
+            g = (5 * i + 1) % 16;
+        } else if (i < 48) {
+            f = b ^ c ^ d;
+            g = (3 * i + 5) % 16;
+        } else {
+            f = c ^ (b | ~d);
+            g = (7 * i) % 16;
+        }
+        uint32_t t = a + f + md5_k[i] + m[g];
+        a = d;
+        d = c;
+        c = b;
+        b += (t << md5_r[i]) | (t >> (32 - md5_r[i]));
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+}
+
+void ntp_md5(const uint8_t *prefix, size_t prefix_len, const uint8_t *msg, size_t len,
+             uint8_t digest[NTP_MD5_DIGEST_SIZE]) {
+    uint32_t h[4] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476};
+    uint8_t block[64];
+    size_t fill = 0;
+    uint64_t total = prefix_len + len;
+    const uint8_t *parts[2] = {prefix, msg};
+    size_t lengths[2] = {prefix_len, len};
+    for (int p = 0; p < 2; p++) {
+        for (size_t i = 0; i < lengths[p]; i++) {
+            block[fill++] = parts[p][i];
+            if (fill == 64) {
+                md5_block(h, block);
+                fill = 0;
+            }
+        }
+    }
+    // padding: 0x80, zeros, bit length little endian
+    block[fill++] = 0x80;
+    if (fill > 56) {
+        memset(&block[fill], 0, 64 - fill);
+        md5_block(h, block);
+        fill = 0;
+    }
+    memset(&block[fill], 0, 56 - fill);
+    for (int i = 0; i < 8; i++) {
+        block[56 + i] = (uint8_t)((total * 8) >> (8 * i));
+    }
+    md5_block(h, block);
+    for (int i = 0; i < 16; i++) {
+        digest[i] = (uint8_t)(h[i / 4] >> (8 * (i % 4)));
+    }
+    memset(block, 0, sizeof(block));
+}
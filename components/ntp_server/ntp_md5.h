@@ -0,0 +1,13 @@
+#pragma once
+
+// MD5 for the RFC 5905 MAC, plain C on the caller's stack. The key is hashed together with each packet, so no
+// state is kept per key.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NTP_MD5_DIGEST_SIZE 16
+
+// MD5 of prefix || msg, the RFC 5905 MAC is MD5(key || packet)
+void ntp_md5(const uint8_t *prefix, size_t prefix_len, const uint8_t *msg, size_t len,
+             uint8_t digest[NTP_MD5_DIGEST_SIZE]);
@@ -0,0 +1,76 @@
+#include "ntp_packet.h"
+
+#include <string.h>
+
+uint64_t ntp_timestamp_from_timeval(const struct timeval *tv) {
+    // the shift keeps the seconds modulo 2^32, i.e. the NTP era rolls over in 2036 as it should
+    uint64_t seconds = NTP_UNIX_OFFSET + (uint64_t)tv->tv_sec;
+    // microseconds to 32 bit binary fraction, (usec << 32) / 10^6 without the 64 bit division (a library call
+    // on Xtensa): multiply with 2^64 / 10^6 rounded up, the result is at most one too large
+    uint64_t usec = (uint64_t)tv->tv_usec;
+    uint64_t fraction = (usec * 18446744073710ULL) >> 32;
+    if (fraction * 1000000 > usec << 32) {
+        fraction--;
+    }
+    return (seconds << 32) | fraction;
+}
+
+uint64_t ntp_timestamp_from_ns(uint64_t ns) {
+    uint64_t seconds = NTP_UNIX_OFFSET + ns / 1000000000;
+    // same as above with 2^62 / 10^9 rounded up, ns * m stays below 2^64 for ns < 10^9
+    uint64_t nsec = ns % 1000000000;
+    uint64_t fraction = (nsec * 4611686019ULL) >> 30;
+    if (fraction * 1000000000 > nsec << 32) {
+        fraction--;
+    }
+    return (seconds << 32) | fraction;
+}
+
+uint64_t ntp_timestamp_to_ns(uint64_t timestamp) {
+    // era 1 starts in 2036, its seconds are below the offset
+    uint64_t seconds = (timestamp >> 32) - NTP_UNIX_OFFSET + ((timestamp >> 32) < NTP_UNIX_OFFSET ? 1ULL << 32 : 0);
+    return seconds * 1000000000 + (((timestamp & 0xFFFFFFFF) * 1000000000) >> 32);
+}
+
+uint32_t ntp_short_format(int64_t us) {
+    if (us <= 0) {
+        return 0;
+    }
+    uint64_t v = ((uint64_t)us << 16) / 1000000;
+    return v > UINT32_MAX ? UINT32_MAX : (uint32_t)v;
+}
+
+static void ntp_write_u32(char *dst, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        dst[i] = (char)((value >> (24 - 8 * i)) & 0xFF);
+    }
+}
+
+void ntp_write_timestamp(char *dst, uint64_t timestamp) {
+    for (int i = 0; i < 8; i++) {
+        dst[i] = (char)((timestamp >> (56 - 8 * i)) & 0xFF);
+    }
+}
+
+void ntp_write_header(char *ntp_packet, uint8_t li_vn_mode, uint8_t poll, const ntp_server_info_t *info) {
+    ntp_packet[0] = li_vn_mode | (info->leap << 6);
+    // Stratum, or type of clock
+    ntp_packet[1] = info->stratum;
+    // Polling Interval
+    ntp_packet[2] = poll;
+    ntp_packet[3] = info->precision;
+    ntp_write_u32(&ntp_packet[4], info->root_delay);
+    ntp_write_u32(&ntp_packet[8], info->root_dispersion);
+    // time source (namestring or IPv4 address of the upstream server)
+    ntp_write_u32(&ntp_packet[12], info->refid);
+    ntp_write_timestamp(&ntp_packet[16], info->reference_time);
+}
+
+void ntp_build_response(char *ntp_packet, uint8_t li_vn_mode, uint8_t poll, const ntp_server_info_t *info,
+                        uint64_t receive_time) {
+    // copy transmit time from the NTP original request to bytes 24 to 31 of the response packet
+    memcpy(&ntp_packet[24], &ntp_packet[40], 8);
+    ntp_write_header(ntp_packet, li_vn_mode, poll, info);
+    // write out the receive time to bytes 32 to 39 of the response packet
+    ntp_write_timestamp(&ntp_packet[32], receive_time);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// NTP packet assembly without OS calls, so it can be built and measured on a Linux host.
+// Multi byte fields are written in network byte order, timestamps are 32.32 fixed point seconds since 1900.
+
+#include <stdint.h>
+#include <sys/time.h>
+
+#define NTP_PACKET_SIZE 48
+// seconds between the NTP era 0 (1900-01-01) and the Unix epoch
+#define NTP_UNIX_OFFSET 2208988800ULL
+
+// what the server announces about its clock
+typedef struct {
+    uint8_t leap;  // LI, 3 while the clock is not synchronized
+    uint8_t stratum;
+    int8_t precision;          // log2 seconds
+    uint32_t root_delay;       // NTP short format (16.16 seconds)
+    uint32_t root_dispersion;  // NTP short format
+    uint32_t refid;
+    uint64_t reference_time;
+} ntp_server_info_t;
+
+uint64_t ntp_timestamp_from_timeval(const struct timeval *tv);
+
+// nanoseconds since the Unix epoch, e.g. from timebase_hires_realtime_ns()
+uint64_t ntp_timestamp_from_ns(uint64_t ns);
+
+// the inverse, for timestamps from 1970 to 2106
+uint64_t ntp_timestamp_to_ns(uint64_t timestamp);
+
+// microseconds to NTP short format, saturating
+uint32_t ntp_short_format(int64_t us);
+
+// write a 64 bit NTP timestamp in network byte order to dst[0..7]
+void ntp_write_timestamp(char *dst, uint64_t timestamp);
+
+// fill bytes 0 to 23 of a server packet (header, reference id and reference time), the LI bits of li_vn_mode
+// are combined with info->leap
+void ntp_write_header(char *ntp_packet, uint8_t li_vn_mode, uint8_t poll, const ntp_server_info_t *info);
+
+// turn the client request in ntp_packet into the response, except for the transmit timestamp (bytes 40 to 47)
+// which the caller writes as late as possible
+void ntp_build_response(char *ntp_packet, uint8_t li_vn_mode, uint8_t poll, const ntp_server_info_t *info,
+                        uint64_t receive_time);
@@ -1,3 +1,27 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "lwip/sockets.h"
+#include "ntp_packet.h"
+
 void udp_server_task(void *pvParameters);
+void ntp_broadcast_task(void *pvParameters);
+
+// current UTC from the system clock, allocation free and independent of TZ
+struct tm getTimeStruct();
+unsigned long getEpoch();
+uint64_t getCurrentTimeInNTP64BitFormat();
+
+// stratum, reference id etc. of the server right now
+void ntp_server_info(ntp_server_info_t *info);
+// unicast requests answered since start
+uint32_t ntp_server_requests(void);
+// turns the request in ntp_packet (len bytes as received) into the response in place, returns its length or 0 if the
+// request is dropped. The socket loop of udp_server_task calls it for every datagram, host tests call it directly.
+size_t ntp_server_respond(char *ntp_packet, int len, const struct sockaddr_in *source_addr, uint64_t receive_time);
+// builds a broadcast packet except for the transmit timestamp, false while the clock is not synchronized
+bool ntp_broadcast_packet(char *ntp_packet);
@@ -1,80 +1,119 @@
 #include <string.h>
 #include <sys/param.h>
 
+#include "civil_time.h"
+#include "client_stats.h"
+#include "dcf77.h"
+#include "eth_rx_timestamp.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include <sys/time.h>
-#include <time.h>
-
 #include "lwip/netdb.h"
 #include "lwip/sockets.h"
+#include "mem_budget.h"
+#include "ntp_auth.h"
+#include "prof.h"
+#include "sdkconfig.h"
+#include "time_source.h"
+#include "timebase.h"
+#include "timebase_hires.h"
+#include "udp_server_task.h"
 
 static const char *TAG = "udp_server";
-// NTP port and packet buffer
+static volatile uint32_t requests_served = 0;
+// NTP port
 #define NTP_PORT 123
-#define NTP_PACKET_SIZE 48
-static bool overflow;
-long offset = 0;
-const long oneSecond_inMicroseconds_L = 1000000;  // one second in microseconds
 
 struct tm getTimeStruct() {
     struct tm timeinfo;
-    time_t now;
-    time(&now);
-    localtime_r(&now, &timeinfo);
-    time_t tt = mktime(&timeinfo);
-
-    if (overflow) {
-        tt += 63071999;
-    }
-    if (offset > 0) {
-        tt += (unsigned long)offset;
-    } else {
-        tt -= (unsigned long)(offset * -1);
-    }
-    struct tm *tn = localtime(&tt);
-    if (overflow) {
-        tn->tm_year += 64;
-    }
-    return *tn;
+    civil_from_unix(getEpoch(), &timeinfo);
+    return timeinfo;
 }
 
 unsigned long getEpoch() {
-    struct tm timeinfo = getTimeStruct();
-    return mktime(&timeinfo);
-}
-unsigned long getMicros() {
     struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return tv.tv_usec;
+    timebase_realtime(&tv);
+    return tv.tv_sec;
 }
 
 uint64_t getCurrentTimeInNTP64BitFormat() {
-    const uint64_t numberOfSecondsBetween1900and1970 = 2208988800;
-
-    uint64_t clockSecondsSinceEpoch = numberOfSecondsBetween1900and1970 + getEpoch();
-    long clockMicroSeconds = (long)getMicros();
-
-    while (clockMicroSeconds > oneSecond_inMicroseconds_L) {
-        clockSecondsSinceEpoch++;
-        clockMicroSeconds -= oneSecond_inMicroseconds_L;
-    };
+    // seconds and fraction from one read, so they can't belong to different seconds
+    return ntp_timestamp_from_ns(timebase_hires_realtime_ns());
+}
 
-    while (clockMicroSeconds < 0L) {
-        clockSecondsSinceEpoch--;
-        clockMicroSeconds += oneSecond_inMicroseconds_L;
+void ntp_server_info(ntp_server_info_t *info) {
+    *info = (ntp_server_info_t){
+        .stratum = 1,
+        .precision = timebase_hires_precision(),  // measured at startup
+        .root_dispersion = 0x50,
+        .refid = 0x44434600,  // "DCF"
+        .reference_time = getCurrentTimeInNTP64BitFormat(),
     };
+#if !CONFIG_CLOCK_SELECT
+    // the receiver sets the clock directly, it is synchronized once a frame was decoded
+    info->leap = dcf77_last_sync() != 0 ? 0 : 3;
+#else
+    // stratum, reference id, root delay and dispersion follow the selected source
+    time_source_status_t status;
+    time_source_status(&status);
+    info->leap = status.synchronized ? 0 : 3;
+    info->stratum = status.stratum;
+    info->root_delay = ntp_short_format(status.root_delay_us);
+    info->root_dispersion = ntp_short_format(status.root_dispersion_us);
+    info->refid = status.refid;
+#endif
+}
 
-    // for the next two lines to be clear, please see: https://tickelton.gitlab.io/articles/ntp-timestamps/
+uint32_t ntp_server_requests(void) { return requests_served; }
 
-    double clockMicroSeconds_D = (double)clockMicroSeconds * (double)(4294.967296);
-    return ((uint64_t)clockSecondsSinceEpoch << 32) | (uint64_t)(clockMicroSeconds_D);
+size_t ntp_server_respond(char *ntp_packet, int len, const struct sockaddr_in *source_addr, uint64_t receive_time) {
+    bool authenticated = false;
+#if CONFIG_NTP_SERVER_AUTH
+    uint32_t key_id = 0;
+    authenticated = len == NTP_PACKET_SIZE + NTP_AUTH_MAC_SIZE;
+    if (authenticated && !ntp_auth_verify((const uint8_t *)ntp_packet, len, &key_id)) {
+        ESP_LOGW(TAG, "Authentication failed, key %lu", (unsigned long)key_id);
+        return 0;
+    }
+#endif
+    if (len != NTP_PACKET_SIZE && !authenticated) {
+        ESP_LOGW(TAG, "Unsupported packet length %d", len);
+        return 0;
+    }
+#if CONFIG_EXAMPLE_ETH_RX_TIMESTAMP
+    // arrival time taken by the Ethernet input hook, or the INT edge of an SPI module in low-latency mode
+    eth_ntp_frame_key_t key = {.src_addr = source_addr->sin_addr.s_addr, .src_port = source_addr->sin_port};
+    memcpy(key.xmt, &ntp_packet[40], sizeof(key.xmt));
+    uint64_t receive_ns = ntp_timestamp_to_ns(receive_time);
+    if (eth_rx_ntp_timestamp(&key, &receive_ns)) {
+        receive_time = ntp_timestamp_from_ns(receive_ns);
+    }
+#endif
+    PROF_POINT(PROF_PATH_NTP, PROF_NTP_TIMESTAMP);
+#if CONFIG_NTP_SERVER_CLIENT_STATS
+    // before the header is overwritten, byte 2 is the poll interval of the client
+    client_stats_update(source_addr->sin_addr.s_addr, (int8_t)ntp_packet[2]);
+#endif
+
+    ntp_server_info_t info;
+    ntp_server_info(&info);
+    ntp_build_response(ntp_packet, 0b00011100, 4, &info, receive_time);
+
+    // get the current time and write it out as the transmit time to bytes 40 to 47 of the response packet
+    ntp_write_timestamp(&ntp_packet[40], getCurrentTimeInNTP64BitFormat());
+
+#if CONFIG_NTP_SERVER_AUTH
+    if (authenticated) {
+        return ntp_auth_sign((uint8_t *)ntp_packet, key_id);
+    }
+#endif
+    return NTP_PACKET_SIZE;
 }
 
 void udp_server_task(void *pvParameters) {
-    char ntp_packet[NTP_PACKET_SIZE];
+    // room for a MAC trailer, longer packets are detected by recvfrom filling the whole buffer
+    char ntp_packet[NTP_PACKET_SIZE + NTP_AUTH_MAC_SIZE + 1];
     int addr_family = AF_INET;
     int ip_protocol = IPPROTO_IP;
 
@@ -85,9 +124,18 @@ void udp_server_task(void *pvParameters) {
 
     // print time
 
+#if CONFIG_NTP_SERVER_AUTH
+    ntp_auth_load_keys();
+#endif
+#if CONFIG_NTP_SERVER_AUTH_BENCH
+    // before the socket exists, the temporary keys never see a request
+    ntp_auth_bench_t bench;
+    ntp_auth_bench(CONFIG_NTP_SERVER_AUTH_BENCH_REQUESTS, &bench);
+#endif
     int sock = socket(addr_family, SOCK_DGRAM, ip_protocol);
     if (sock < 0) {
         ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        mem_budget_task_exit();
         return;
     }
     ESP_LOGI(TAG, "Socket created");
@@ -96,92 +144,39 @@ void udp_server_task(void *pvParameters) {
     if (err < 0) {
         ESP_LOGE(TAG, "Socket unable to bind: errno %d", errno);
         close(sock);
+        mem_budget_task_exit();
         return;
     }
     ESP_LOGI(TAG, "Socket bound, port %d", NTP_PORT);
+#if CONFIG_NTP_SERVER_CLIENT_STATS
+    client_stats_start_reporting();
+#endif
 
     while (1) {
         struct sockaddr_in source_addr;
         socklen_t socklen = sizeof(source_addr);
-        int len = recvfrom(sock, ntp_packet, sizeof(ntp_packet) - 1, 0, (struct sockaddr *)&source_addr, &socklen);
-        ESP_LOGI(TAG, "received udp request");
-        uint64_t receiveTime_uint64_t = getCurrentTimeInNTP64BitFormat();
+        int len = recvfrom(sock, ntp_packet, sizeof(ntp_packet), 0, (struct sockaddr *)&source_addr, &socklen);
+        // before anything else, logging would add the UART output to the timestamp
+        uint64_t receive_time = getCurrentTimeInNTP64BitFormat();
+        PROF_START(PROF_PATH_NTP, PROF_NTP_RECV);
+        ESP_LOGD(TAG, "received udp request");
 
-        if (len < 0 || len > NTP_PACKET_SIZE) {
+        if (len < 0) {
             ESP_LOGE(TAG, "recvfrom failed: errno %d", errno);
             break;
-        } else {
-            ntp_packet[len] = 0;  // Null-terminieren
-            ntp_packet[0] = 0b00011100;
-            // Stratum, or type of clock
-            ntp_packet[1] = 0b00000001;
-            // Polling Interval
-            ntp_packet[2] = 4;
-            ntp_packet[3] = 0xF7;
-            ntp_packet[4] = 0;
-            ntp_packet[5] = 0;
-            ntp_packet[6] = 0;
-            ntp_packet[7] = 0;
-            ntp_packet[8] = 0;
-            ntp_packet[9] = 0;
-            ntp_packet[10] = 0;
-            ntp_packet[11] = 0x50;
-
-            // time source (namestring)
-            ntp_packet[12] = 69;  // D
-            ntp_packet[13] = 67;  // C
-            ntp_packet[14] = 70;  // F
-            ntp_packet[15] = 0;
-
-            uint64_t referenceTime_uint64_t = getCurrentTimeInNTP64BitFormat();
-
-            ntp_packet[16] = (int)((referenceTime_uint64_t >> 56) & 0xFF);
-            ntp_packet[17] = (int)((referenceTime_uint64_t >> 48) & 0xFF);
-            ntp_packet[18] = (int)((referenceTime_uint64_t >> 40) & 0xFF);
-            ntp_packet[19] = (int)((referenceTime_uint64_t >> 32) & 0xFF);
-            ntp_packet[20] = (int)((referenceTime_uint64_t >> 24) & 0xFF);
-            ntp_packet[21] = (int)((referenceTime_uint64_t >> 16) & 0xFF);
-            ntp_packet[22] = (int)((referenceTime_uint64_t >> 8) & 0xFF);
-            ntp_packet[23] = (int)(referenceTime_uint64_t & 0xFF);
-
-            // copy transmit time from the NTP original request to bytes 24 to 31 of the response packet
-            ntp_packet[24] = ntp_packet[40];
-            ntp_packet[25] = ntp_packet[41];
-            ntp_packet[26] = ntp_packet[42];
-            ntp_packet[27] = ntp_packet[43];
-            ntp_packet[28] = ntp_packet[44];
-            ntp_packet[29] = ntp_packet[45];
-            ntp_packet[30] = ntp_packet[46];
-            ntp_packet[31] = ntp_packet[47];
-
-            // write out the receive time (it was set above) to bytes 32 to 39 of the response packet
-            ntp_packet[32] = (int)((receiveTime_uint64_t >> 56) & 0xFF);
-            ntp_packet[33] = (int)((receiveTime_uint64_t >> 48) & 0xFF);
-            ntp_packet[34] = (int)((receiveTime_uint64_t >> 40) & 0xFF);
-            ntp_packet[35] = (int)((receiveTime_uint64_t >> 32) & 0xFF);
-            ntp_packet[36] = (int)((receiveTime_uint64_t >> 24) & 0xFF);
-            ntp_packet[37] = (int)((receiveTime_uint64_t >> 16) & 0xFF);
-            ntp_packet[38] = (int)((receiveTime_uint64_t >> 8) & 0xFF);
-            ntp_packet[39] = (int)(receiveTime_uint64_t & 0xFF);
-
-            // get the current time and write it out as the transmit time to bytes 40 to 47 of the response packet
-            uint64_t transmitTime_uint64_t = getCurrentTimeInNTP64BitFormat();
-
-            ntp_packet[40] = (int)((transmitTime_uint64_t >> 56) & 0xFF);
-            ntp_packet[41] = (int)((transmitTime_uint64_t >> 48) & 0xFF);
-            ntp_packet[42] = (int)((transmitTime_uint64_t >> 40) & 0xFF);
-            ntp_packet[43] = (int)((transmitTime_uint64_t >> 32) & 0xFF);
-            ntp_packet[44] = (int)((transmitTime_uint64_t >> 24) & 0xFF);
-            ntp_packet[45] = (int)((transmitTime_uint64_t >> 16) & 0xFF);
-            ntp_packet[46] = (int)((transmitTime_uint64_t >> 8) & 0xFF);
-            ntp_packet[47] = (int)(transmitTime_uint64_t & 0xFF);
-
-            sendto(sock, ntp_packet, NTP_PACKET_SIZE, 0, (struct sockaddr *)&source_addr, sizeof(source_addr));
         }
+        size_t response_len = ntp_server_respond(ntp_packet, len, &source_addr, receive_time);
+        if (response_len == 0) {
+            continue;
+        }
+        PROF_POINT(PROF_PATH_NTP, PROF_NTP_BUILD);
+        sendto(sock, ntp_packet, response_len, 0, (struct sockaddr *)&source_addr, sizeof(source_addr));
+        PROF_POINT(PROF_PATH_NTP, PROF_NTP_SEND);
+        requests_served++;
     }
 
     if (sock != -1) {
         close(sock);
     }
-    vTaskDelete(NULL);
+    mem_budget_task_exit();
 }
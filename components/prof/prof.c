@@ -0,0 +1,103 @@
+#include "prof.h"
+
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "mem_budget.h"
+#define PROF_LOG(fmt, ...) ESP_LOGI(TAG, fmt, ##__VA_ARGS__)
+#else
+#include <stdio.h>
+#define PROF_LOG(fmt, ...) printf("%s: " fmt "\n", TAG, ##__VA_ARGS__)
+#endif
+
+#if CONFIG_PROF
+
+static const char *TAG = "prof";
+
+static const char *const stage_names[PROF_STAGE_COUNT] = {
+    [PROF_DCF77_ISR] = "dcf77 isr",         [PROF_DCF77_WAKE] = "dcf77 wake",
+    [PROF_DCF77_DECODE] = "dcf77 decode",   [PROF_DCF77_CLOCK] = "dcf77 clock",
+    [PROF_NTP_RECV] = "ntp recv",           [PROF_NTP_TIMESTAMP] = "ntp timestamp",
+    [PROF_NTP_BUILD] = "ntp build",         [PROF_NTP_SEND] = "ntp send",
+};
+
+prof_hist_t prof_hist[PROF_CORES][PROF_STAGE_COUNT];
+// no path started yet
+volatile prof_mark_t prof_mark[PROF_PATH_COUNT] = {[0 ... PROF_PATH_COUNT - 1] = {.core = UINT32_MAX}};
+
+void prof_read(prof_stage_t stage, prof_hist_t *hist) {
+    memset(hist, 0, sizeof(*hist));
+    for (int core = 0; core < PROF_CORES; core++) {
+        const prof_hist_t *h = &prof_hist[core][stage];
+        hist->count += h->count;
+        for (int i = 0; i < PROF_BUCKETS; i++) {
+            hist->buckets[i] += h->buckets[i];
+        }
+    }
+}
+
+void prof_reset(void) { memset(prof_hist, 0, sizeof(prof_hist)); }
+
+// upper bound of the bucket holding the given fraction of the samples, in cycles
+static uint64_t prof_percentile(const prof_hist_t *hist, uint32_t total, uint32_t permille) {
+    uint64_t target = ((uint64_t)total * permille + 999) / 1000;
+    uint64_t seen = 0;
+    for (int i = 0; i < PROF_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= target && seen > 0) {
+            return i == 0 ? 0 : 1ULL << i;
+        }
+    }
+    return 0;
+}
+
+void prof_dump(void) {
+#ifdef ESP_PLATFORM
+    const uint32_t cycles_per_us = esp_rom_get_cpu_ticks_per_us();
+#else
+    const uint32_t cycles_per_us = 1000;  // nanoseconds
+#endif
+    // most stages take less than a microsecond, so the bounds are converted to nanoseconds
+    for (int stage = 0; stage < PROF_STAGE_COUNT; stage++) {
+        prof_hist_t hist;
+        prof_read(stage, &hist);
+        uint32_t total = 0;
+        for (int i = 0; i < PROF_BUCKETS; i++) {
+            total += hist.buckets[i];
+        }
+        if (total == 0) {
+            PROF_LOG("%-14s %8lu", stage_names[stage], (unsigned long)hist.count);
+            continue;
+        }
+        // log2 buckets: the percentiles are upper bounds, at most twice the true value
+        PROF_LOG("%-14s %8lu  p50 < %llu ns  p99 < %llu ns  max < %llu ns", stage_names[stage],
+                 (unsigned long)hist.count,
+                 (unsigned long long)(prof_percentile(&hist, total, 500) * 1000 / cycles_per_us),
+                 (unsigned long long)(prof_percentile(&hist, total, 990) * 1000 / cycles_per_us),
+                 (unsigned long long)(prof_percentile(&hist, total, 1000) * 1000 / cycles_per_us));
+    }
+}
+
+#ifdef ESP_PLATFORM
+static void prof_report(void *arg) { prof_dump(); }
+
+void prof_start_reporting(void) {
+    mem_budget_add_static("prof", sizeof(prof_hist) + sizeof(prof_mark));
+    if (CONFIG_PROF_DUMP_INTERVAL_S == 0) {
+        return;
+    }
+    const esp_timer_create_args_t args = {
+        .callback = prof_report,
+        .name = "prof",
+    };
+    esp_timer_handle_t timer;
+    ESP_ERROR_CHECK(esp_timer_create(&args, &timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(timer, CONFIG_PROF_DUMP_INTERVAL_S * 1000000ULL));
+}
+#endif
+
+#endif  // CONFIG_PROF
@@ -0,0 +1,132 @@
+#pragma once
+
+// Compile time tracepoints on the hot paths. Each tracepoint adds the cycles since the previous tracepoint of its path
+// to a log2 histogram of its stage, per core. A path that starts in an ISR carries the start stamp with its event to
+// the task (PROF_STAMP, PROF_RESUME), so only the task writes the mark of the path. Without CONFIG_PROF the macros
+// expand to nothing. Only needs a cycle counter, on a Linux host CLOCK_MONOTONIC nanoseconds are used instead, so the
+// same probes run in host builds (define CONFIG_PROF there).
+
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+#include "sdkconfig.h"
+#include "soc/soc_caps.h"
+#define PROF_CORES SOC_CPU_CORES_NUM
+#else
+#include <time.h>
+#define PROF_CORES 1
+#endif
+
+#define PROF_BUCKETS 33  // bucket 0: no cycles, bucket n: 2^(n-1) <= cycles < 2^n
+
+typedef enum {
+    PROF_PATH_DCF77,
+    PROF_PATH_NTP,
+    PROF_PATH_COUNT,
+} prof_path_t;
+
+typedef enum {
+    // TCO edge to clock update
+    PROF_DCF77_ISR,     // edge ISR entry, starts the path
+    PROF_DCF77_WAKE,    // dcf77 task received the edge
+    PROF_DCF77_DECODE,  // front end and decoder done
+    PROF_DCF77_CLOCK,   // clock stepped or sample reported to the selection
+    // frame arrival to response sent
+    PROF_NTP_RECV,       // recvfrom() returned, starts the path
+    PROF_NTP_TIMESTAMP,  // receive timestamp taken
+    PROF_NTP_BUILD,      // response built, transmit timestamp and MAC written
+    PROF_NTP_SEND,       // sendto() returned
+    PROF_STAGE_COUNT,
+} prof_stage_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t buckets[PROF_BUCKETS];
+} prof_hist_t;
+
+typedef struct {
+    uint32_t cycles;
+    uint32_t core;
+} prof_mark_t;
+
+#if CONFIG_PROF
+
+extern prof_hist_t prof_hist[PROF_CORES][PROF_STAGE_COUNT];
+extern volatile prof_mark_t prof_mark[PROF_PATH_COUNT];
+
+static inline __attribute__((always_inline)) uint32_t prof_cycles(void) {
+#ifdef ESP_PLATFORM
+    return (uint32_t)esp_cpu_get_cycle_count();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000 + now.tv_nsec);
+#endif
+}
+
+static inline __attribute__((always_inline)) uint32_t prof_core(void) {
+#ifdef ESP_PLATFORM
+    return (uint32_t)esp_cpu_get_core_id();
+#else
+    return 0;
+#endif
+}
+
+// the start stage only counts, there is no previous tracepoint to measure from
+static inline __attribute__((always_inline)) void prof_start(prof_path_t path, prof_stage_t stage) {
+    uint32_t core = prof_core();
+    prof_mark[path].cycles = prof_cycles();
+    prof_mark[path].core = core;
+    prof_hist[core][stage].count++;
+}
+
+// the cycle counters of the cores are independent, a path that moved to another core is not counted
+static inline __attribute__((always_inline)) void prof_point(prof_path_t path, prof_stage_t stage) {
+    uint32_t now = prof_cycles();
+    uint32_t core = prof_core();
+    if (prof_mark[path].core == core) {
+        uint32_t delta = now - prof_mark[path].cycles;
+        prof_hist_t *hist = &prof_hist[core][stage];
+        hist->count++;
+        hist->buckets[delta == 0 ? 0 : 32 - __builtin_clz(delta)]++;
+    }
+    prof_mark[path].cycles = now;
+    prof_mark[path].core = core;
+}
+
+// the start stage of a path that continues elsewhere, the stamp goes with the event
+static inline __attribute__((always_inline)) prof_mark_t prof_stamp(prof_stage_t stage) {
+    prof_mark_t mark = {.cycles = prof_cycles(), .core = prof_core()};
+    prof_hist[mark.core][stage].count++;
+    return mark;
+}
+
+// the next tracepoint after the stamp of the event, measured from the stamp
+static inline __attribute__((always_inline)) void prof_resume(prof_path_t path, prof_stage_t stage, prof_mark_t mark) {
+    prof_mark[path] = mark;
+    prof_point(path, stage);
+}
+
+#define PROF_START(path, stage) prof_start(path, stage)
+#define PROF_POINT(path, stage) prof_point(path, stage)
+#define PROF_STAMP(mark, stage) ((mark) = prof_stamp(stage))
+#define PROF_RESUME(path, stage, mark) prof_resume(path, stage, mark)
+
+#else
+#define PROF_START(path, stage) ((void)0)
+#define PROF_POINT(path, stage) ((void)0)
+#define PROF_STAMP(mark, stage) ((void)0)
+#define PROF_RESUME(path, stage, mark) ((void)0)
+#endif
+
+// copies the histogram of a stage summed over all cores
+void prof_read(prof_stage_t stage, prof_hist_t *hist);
+
+void prof_reset(void);
+
+// logs count and percentiles of each stage in nanoseconds
+void prof_dump(void);
+
+// dumps every CONFIG_PROF_DUMP_INTERVAL_S seconds
+void prof_start_reporting(void);
@@ -0,0 +1,147 @@
+#include "ptp_engine.h"
+
+#include <string.h>
+
+#define PTP_VERSION 2
+#define PTP_HEADER_SIZE 34
+#define PTP_SYNC_SIZE 44
+#define PTP_FOLLOW_UP_SIZE 44
+#define PTP_DELAY_REQ_SIZE 44
+#define PTP_DELAY_RESP_SIZE 54
+#define PTP_ANNOUNCE_SIZE 64
+
+// flagField, first octet
+#define PTP_FLAG_TWO_STEP 0x02
+// flagField, second octet
+#define PTP_FLAG_UTC_OFFSET_VALID 0x04
+#define PTP_FLAG_PTP_TIMESCALE 0x08
+#define PTP_FLAG_TIME_TRACEABLE 0x10
+#define PTP_FLAG_FREQUENCY_TRACEABLE 0x20
+
+// controlField values for the PTPv1 compatible hardware
+#define PTP_CONTROL_SYNC 0
+#define PTP_CONTROL_DELAY_REQ 1
+#define PTP_CONTROL_FOLLOW_UP 2
+#define PTP_CONTROL_DELAY_RESP 3
+#define PTP_CONTROL_OTHER 5
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = v >> 8;
+    p[1] = v & 0xFF;
+}
+
+static void put_timestamp(uint8_t *p, const ptp_timestamp_t *ts) {
+    for (int i = 0; i < 6; i++) {
+        p[i] = (ts->seconds >> (40 - 8 * i)) & 0xFF;
+    }
+    for (int i = 0; i < 4; i++) {
+        p[6 + i] = (ts->nanoseconds >> (24 - 8 * i)) & 0xFF;
+    }
+}
+
+static void put_header(const ptp_engine_t *engine, uint8_t *buf, uint8_t type, uint16_t length, uint16_t sequence_id,
+                       uint8_t control, int8_t log_interval) {
+    memset(buf, 0, PTP_HEADER_SIZE);
+    buf[0] = type;  // transportSpecific 0
+    buf[1] = PTP_VERSION;
+    put_u16(&buf[2], length);
+    buf[4] = engine->domain;
+    if (type == PTP_MSG_SYNC) {
+        buf[6] = PTP_FLAG_TWO_STEP;
+    }
+    // clock class 6 means locked to the primary reference, only then the time is traceable
+    if (engine->quality.clock_class == 6) {
+        buf[7] = PTP_FLAG_TIME_TRACEABLE | PTP_FLAG_FREQUENCY_TRACEABLE;
+    }
+    if (engine->synchronized) {
+        buf[7] |= PTP_FLAG_UTC_OFFSET_VALID;
+    }
+    buf[7] |= PTP_FLAG_PTP_TIMESCALE;
+    // correctionField and reserved stay zero
+    memcpy(&buf[20], engine->clock_identity, 8);
+    put_u16(&buf[28], 1);  // portNumber
+    put_u16(&buf[30], sequence_id);
+    buf[32] = control;
+    buf[33] = (uint8_t)log_interval;
+}
+
+void ptp_engine_init(ptp_engine_t *engine, const uint8_t mac[6], uint8_t domain) {
+    memset(engine, 0, sizeof(*engine));
+    // EUI-48 to EUI-64 clock identity
+    engine->clock_identity[0] = mac[0];
+    engine->clock_identity[1] = mac[1];
+    engine->clock_identity[2] = mac[2];
+    engine->clock_identity[3] = 0xFF;
+    engine->clock_identity[4] = 0xFE;
+    engine->clock_identity[5] = mac[3];
+    engine->clock_identity[6] = mac[4];
+    engine->clock_identity[7] = mac[5];
+    engine->domain = domain;
+    engine->log_sync_interval = 0;
+    engine->log_announce_interval = 1;
+    engine->log_min_delay_req_interval = 0;
+    engine->priority1 = 128;
+    engine->priority2 = 128;
+    engine->current_utc_offset = 37;
+    engine->time_source = PTP_TIME_SOURCE_TERRESTRIAL_RADIO;
+    // default for a clock which is not synchronized
+    engine->quality.clock_class = 248;
+    engine->quality.clock_accuracy = 0xFE;
+    engine->quality.offset_scaled_log_variance = 0xFFFF;
+}
+
+size_t ptp_build_announce(ptp_engine_t *engine, uint8_t *buf) {
+    put_header(engine, buf, PTP_MSG_ANNOUNCE, PTP_ANNOUNCE_SIZE, engine->announce_sequence_id++, PTP_CONTROL_OTHER,
+               engine->log_announce_interval);
+    uint8_t *body = &buf[PTP_HEADER_SIZE];
+    memset(body, 0, PTP_ANNOUNCE_SIZE - PTP_HEADER_SIZE);
+    // originTimestamp may be zero
+    put_u16(&body[10], (uint16_t)engine->current_utc_offset);
+    body[13] = engine->priority1;
+    body[14] = engine->quality.clock_class;
+    body[15] = engine->quality.clock_accuracy;
+    put_u16(&body[16], engine->quality.offset_scaled_log_variance);
+    body[18] = engine->priority2;
+    memcpy(&body[19], engine->clock_identity, 8);
+    put_u16(&body[27], 0);  // stepsRemoved
+    body[29] = engine->time_source;
+    return PTP_ANNOUNCE_SIZE;
+}
+
+size_t ptp_build_sync(ptp_engine_t *engine, uint8_t *buf) {
+    put_header(engine, buf, PTP_MSG_SYNC, PTP_SYNC_SIZE, engine->sync_sequence_id++, PTP_CONTROL_SYNC,
+               engine->log_sync_interval);
+    memset(&buf[PTP_HEADER_SIZE], 0, PTP_SYNC_SIZE - PTP_HEADER_SIZE);
+    return PTP_SYNC_SIZE;
+}
+
+size_t ptp_build_follow_up(const ptp_engine_t *engine, uint8_t *buf, const ptp_timestamp_t *precise_origin) {
+    // same sequence id as the Sync sent just before
+    put_header(engine, buf, PTP_MSG_FOLLOW_UP, PTP_FOLLOW_UP_SIZE, engine->sync_sequence_id - 1,
+               PTP_CONTROL_FOLLOW_UP, engine->log_sync_interval);
+    put_timestamp(&buf[PTP_HEADER_SIZE], precise_origin);
+    return PTP_FOLLOW_UP_SIZE;
+}
+
+size_t ptp_build_delay_resp(const ptp_engine_t *engine, uint8_t *buf, const uint8_t *req, size_t req_len,
+                            const ptp_timestamp_t *receive_time) {
+    if (req_len < PTP_DELAY_REQ_SIZE || ptp_message_type(engine, req, req_len) != PTP_MSG_DELAY_REQ) {
+        return 0;
+    }
+    uint16_t sequence_id = (req[30] << 8) | req[31];
+    put_header(engine, buf, PTP_MSG_DELAY_RESP, PTP_DELAY_RESP_SIZE, sequence_id, PTP_CONTROL_DELAY_RESP,
+               engine->log_min_delay_req_interval);
+    // the correction field of the request is copied to the response
+    memcpy(&buf[8], &req[8], 8);
+    put_timestamp(&buf[PTP_HEADER_SIZE], receive_time);
+    // requestingPortIdentity is the sourcePortIdentity of the request
+    memcpy(&buf[PTP_HEADER_SIZE + 10], &req[20], 10);
+    return PTP_DELAY_RESP_SIZE;
+}
+
+int ptp_message_type(const ptp_engine_t *engine, const uint8_t *buf, size_t len) {
+    if (len < PTP_HEADER_SIZE || (buf[1] & 0x0F) != PTP_VERSION || buf[4] != engine->domain) {
+        return -1;
+    }
+    return buf[0] & 0x0F;
+}
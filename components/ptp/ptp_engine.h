@@ -0,0 +1,72 @@
+#pragma once
+
+// IEEE 1588-2008 (PTPv2) grandmaster protocol engine.
+// Only builds and parses messages, no sockets and no OS calls, so it can be used on the target and on a Linux host.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PTP_EVENT_PORT 319
+#define PTP_GENERAL_PORT 320
+#define PTP_PRIMARY_MCAST_IPV4 "224.0.1.129"
+
+#define PTP_MSG_SYNC 0x0
+#define PTP_MSG_DELAY_REQ 0x1
+#define PTP_MSG_FOLLOW_UP 0x8
+#define PTP_MSG_DELAY_RESP 0x9
+#define PTP_MSG_ANNOUNCE 0xB
+
+#define PTP_MAX_MSG_SIZE 64
+
+// timeSource enumeration, DCF77 is a terrestrial radio source
+#define PTP_TIME_SOURCE_TERRESTRIAL_RADIO 0x30
+
+typedef struct {
+    uint64_t seconds;  // 48 bit on the wire
+    uint32_t nanoseconds;
+} ptp_timestamp_t;
+
+// Timestamping backend. The software backend reads the clock right before sendto() and right after recvfrom(),
+// a hardware backend (EMAC timestamp unit) would return the latched frame timestamps instead.
+typedef struct {
+    void (*tx_timestamp)(void *ctx, ptp_timestamp_t *ts);
+    void (*rx_timestamp)(void *ctx, ptp_timestamp_t *ts);
+    void *ctx;
+} ptp_timestamp_backend_t;
+
+typedef struct {
+    uint8_t clock_class;
+    uint8_t clock_accuracy;
+    uint16_t offset_scaled_log_variance;
+} ptp_clock_quality_t;
+
+typedef struct {
+    uint8_t clock_identity[8];
+    uint8_t domain;
+    int8_t log_sync_interval;
+    int8_t log_announce_interval;
+    int8_t log_min_delay_req_interval;
+    uint8_t priority1;
+    uint8_t priority2;
+    int16_t current_utc_offset;
+    uint8_t time_source;
+    ptp_clock_quality_t quality;
+    bool synchronized;  // the clock was set by the time source, only then currentUtcOffset is announced as valid
+    uint16_t sync_sequence_id;
+    uint16_t announce_sequence_id;
+} ptp_engine_t;
+
+void ptp_engine_init(ptp_engine_t *engine, const uint8_t mac[6], uint8_t domain);
+
+// Each builder writes a complete message to buf (at least PTP_MAX_MSG_SIZE bytes) and returns its length.
+size_t ptp_build_announce(ptp_engine_t *engine, uint8_t *buf);
+// two-step Sync, the precise origin timestamp follows with the Follow_Up of the same sequence id
+size_t ptp_build_sync(ptp_engine_t *engine, uint8_t *buf);
+size_t ptp_build_follow_up(const ptp_engine_t *engine, uint8_t *buf, const ptp_timestamp_t *precise_origin);
+// returns 0 if req is not a Delay_Req for this domain
+size_t ptp_build_delay_resp(const ptp_engine_t *engine, uint8_t *buf, const uint8_t *req, size_t req_len,
+                            const ptp_timestamp_t *receive_time);
+
+// returns the message type or -1 if buf is not a PTPv2 message for this domain
+int ptp_message_type(const ptp_engine_t *engine, const uint8_t *buf, size_t len);
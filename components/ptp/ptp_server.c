@@ -0,0 +1,178 @@
+#include "ptp_server.h"
+
+#include <string.h>
+#include <sys/param.h>
+#include <sys/time.h>
+
+#include "dcf77.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include "mem_budget.h"
+#include "ptp_engine.h"
+#include "ptp_sw_timestamp.h"
+#include "sdkconfig.h"
+#include "time_source.h"
+#include "timebase.h"
+
+#if CONFIG_PTP_GRANDMASTER
+
+static const char *TAG = "ptp";
+
+// without a DCF77 frame for this long the clock is no longer considered locked
+#define PTP_LOCKED_TIMEOUT_S 3600
+#define PTP_HOLDOVER_TIMEOUT_S (24 * 3600)
+
+static int64_t log_interval_us(int8_t log_interval) {
+    return log_interval >= 0 ? 1000000LL << log_interval : 1000000LL >> -log_interval;
+}
+
+// only the event socket joins the group, the general socket is never read
+static int ptp_socket(uint16_t port, bool join) {
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        return -1;
+    }
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    struct ip_mreq mreq = {
+        .imr_interface.s_addr = htonl(INADDR_ANY),
+    };
+    inet_pton(AF_INET, PTP_PRIMARY_MCAST_IPV4, &mreq.imr_multiaddr);
+    uint8_t ttl = 1;
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        (join && setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) ||
+        setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) < 0) {
+        ESP_LOGE(TAG, "Socket setup for port %u failed: errno %d", port, errno);
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// clockClass 6: synchronized by the time source, 7: holdover, 248: never synchronized or holdover expired
+static void ptp_update_quality(ptp_engine_t *engine) {
+#if CONFIG_CLOCK_SELECT
+    time_source_status_t status;
+    time_source_status(&status);
+    bool synchronized = status.synchronized;
+    bool locked = status.synchronized && !status.holdover;
+    // the selection keeps the holdover state until a source is selectable again
+    bool holdover = status.holdover;
+#else
+    struct timeval now;
+    timebase_realtime(&now);
+    time_t last_sync = dcf77_last_sync();
+    time_t age = now.tv_sec - last_sync;
+    bool synchronized = last_sync != 0;
+    bool locked = synchronized && age < PTP_LOCKED_TIMEOUT_S;
+    bool holdover = synchronized && !locked && age < PTP_HOLDOVER_TIMEOUT_S;
+#endif
+    engine->synchronized = synchronized;
+    if (locked) {
+        engine->quality.clock_class = 6;
+        engine->quality.clock_accuracy = 0x31;  // within 10 ms
+        engine->quality.offset_scaled_log_variance = 0x6000;
+    } else if (holdover) {
+        engine->quality.clock_class = 7;
+        engine->quality.clock_accuracy = 0xFE;
+        engine->quality.offset_scaled_log_variance = 0xFFFF;
+    } else {
+        engine->quality.clock_class = 248;
+        engine->quality.clock_accuracy = 0xFE;
+        engine->quality.offset_scaled_log_variance = 0xFFFF;
+    }
+}
+
+void ptp_server_task(void *pvParameters) {
+    static ptp_engine_t engine;
+    mem_budget_add_static("ptp", sizeof(engine));
+    ptp_timestamp_backend_t backend;
+    uint8_t rx_buf[128];
+    uint8_t tx_buf[PTP_MAX_MSG_SIZE];
+
+    uint8_t mac[6];
+    esp_read_mac(mac, ESP_MAC_ETH);
+    ptp_engine_init(&engine, mac, CONFIG_PTP_DOMAIN);
+    engine.log_sync_interval = CONFIG_PTP_LOG_SYNC_INTERVAL;
+    engine.log_announce_interval = CONFIG_PTP_LOG_ANNOUNCE_INTERVAL;
+    engine.priority1 = CONFIG_PTP_PRIORITY1;
+    engine.priority2 = CONFIG_PTP_PRIORITY2;
+    engine.current_utc_offset = CONFIG_PTP_UTC_OFFSET;
+    ptp_sw_backend_init(&backend, &engine);
+
+    int event_sock = ptp_socket(PTP_EVENT_PORT, true);
+    int general_sock = ptp_socket(PTP_GENERAL_PORT, false);
+    if (event_sock < 0 || general_sock < 0) {
+        if (event_sock >= 0) {
+            close(event_sock);
+        }
+        if (general_sock >= 0) {
+            close(general_sock);
+        }
+        mem_budget_task_exit();
+    }
+    ESP_LOGI(TAG, "Grandmaster started, domain %u", engine.domain);
+
+    struct sockaddr_in event_dest = {.sin_family = AF_INET, .sin_port = htons(PTP_EVENT_PORT)};
+    struct sockaddr_in general_dest = {.sin_family = AF_INET, .sin_port = htons(PTP_GENERAL_PORT)};
+    inet_pton(AF_INET, PTP_PRIMARY_MCAST_IPV4, &event_dest.sin_addr);
+    general_dest.sin_addr = event_dest.sin_addr;
+
+    const int64_t sync_interval = log_interval_us(engine.log_sync_interval);
+    const int64_t announce_interval = log_interval_us(engine.log_announce_interval);
+    int64_t next_sync = timebase_monotonic_us();
+    int64_t next_announce = next_sync;
+
+    while (1) {
+        int64_t now = timebase_monotonic_us();
+        if (now >= next_announce) {
+            next_announce += announce_interval;
+            ptp_update_quality(&engine);
+            size_t len = ptp_build_announce(&engine, tx_buf);
+            sendto(general_sock, tx_buf, len, 0, (struct sockaddr *)&general_dest, sizeof(general_dest));
+        }
+        if (now >= next_sync) {
+            next_sync += sync_interval;
+            ptp_timestamp_t origin;
+            size_t len = ptp_build_sync(&engine, tx_buf);
+            backend.tx_timestamp(backend.ctx, &origin);
+            sendto(event_sock, tx_buf, len, 0, (struct sockaddr *)&event_dest, sizeof(event_dest));
+            len = ptp_build_follow_up(&engine, tx_buf, &origin);
+            sendto(general_sock, tx_buf, len, 0, (struct sockaddr *)&general_dest, sizeof(general_dest));
+        }
+
+        // wait for Delay_Req until the next message is due
+        int64_t wait = MIN(next_sync, next_announce) - timebase_monotonic_us();
+        struct timeval timeout = {.tv_sec = 0, .tv_usec = 0};
+        if (wait > 0) {
+            timeout.tv_sec = wait / 1000000;
+            timeout.tv_usec = wait % 1000000;
+        }
+        fd_set read_set;
+        FD_ZERO(&read_set);
+        FD_SET(event_sock, &read_set);
+        if (select(event_sock + 1, &read_set, NULL, NULL, &timeout) <= 0) {
+            continue;
+        }
+
+        int len = recvfrom(event_sock, rx_buf, sizeof(rx_buf), 0, NULL, NULL);
+        ptp_timestamp_t receive_time;
+        backend.rx_timestamp(backend.ctx, &receive_time);
+        if (len <= 0) {
+            continue;
+        }
+        size_t resp_len = ptp_build_delay_resp(&engine, tx_buf, rx_buf, len, &receive_time);
+        if (resp_len > 0) {
+            sendto(general_sock, tx_buf, resp_len, 0, (struct sockaddr *)&general_dest, sizeof(general_dest));
+        }
+    }
+}
+
+#endif  // CONFIG_PTP_GRANDMASTER
@@ -0,0 +1,3 @@
+#pragma once
+
+void ptp_server_task(void *pvParameters);
@@ -0,0 +1,17 @@
+#include "ptp_sw_timestamp.h"
+
+#include "timebase_hires.h"
+
+static void ptp_sw_timestamp(void *ctx, ptp_timestamp_t *ts) {
+    const ptp_engine_t *engine = ctx;
+    // the disciplined clock of the NTP server, with the resolution of the high resolution source
+    uint64_t ns = timebase_hires_realtime_ns();
+    ts->seconds = ns / 1000000000 + engine->current_utc_offset;
+    ts->nanoseconds = (uint32_t)(ns % 1000000000);
+}
+
+void ptp_sw_backend_init(ptp_timestamp_backend_t *backend, const ptp_engine_t *engine) {
+    backend->tx_timestamp = ptp_sw_timestamp;
+    backend->rx_timestamp = ptp_sw_timestamp;
+    backend->ctx = (void *)engine;
+}
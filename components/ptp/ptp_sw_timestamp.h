@@ -0,0 +1,7 @@
+#pragma once
+
+#include "ptp_engine.h"
+
+// Software timestamping backend: reads the disciplined clock through timebase, the same time the NTP server sends,
+// and converts it to the PTP timescale (TAI) using the UTC offset of the engine. Builds on a Linux host as well.
+void ptp_sw_backend_init(ptp_timestamp_backend_t *backend, const ptp_engine_t *engine);
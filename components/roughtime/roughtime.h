@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t requests;     // answered
+    uint32_t signatures;   // one per batch, plus one long-term signature per delegation
+    uint32_t dropped;      // malformed, or received while the clock was not synchronized
+    uint32_t delegations;  // online keys certified since start
+} roughtime_stats_t;
+
+// answers Roughtime requests on CONFIG_ROUGHTIME_PORT, requests arriving close together share one signature
+void roughtime_task(void *pvParameters);
+
+void roughtime_stats(roughtime_stats_t *stats);
@@ -0,0 +1,332 @@
+#include <string.h>
+#include <sys/param.h>
+
+#include "dcf77.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include "mbedtls/base64.h"
+#include "mem_budget.h"
+#include "nvs.h"
+#include "roughtime.h"
+#include "roughtime_wire.h"
+#include "sdkconfig.h"
+#include "sodium.h"
+#include "timebase.h"
+#include "timebase_hires.h"
+#include "udp_server_task.h"
+
+#if CONFIG_ROUGHTIME
+
+static const char *TAG = "roughtime";
+
+#define ROUGHTIME_NVS_NAMESPACE "roughtime"
+#define ROUGHTIME_NVS_SEED "seed"
+#define DELEGATION_US (CONFIG_ROUGHTIME_DELEGATION_HOURS * 3600LL * 1000000)
+#define BATCH_WINDOW_US (CONFIG_ROUGHTIME_BATCH_WINDOW_MS * 1000LL)
+#define STATS_INTERVAL_US (10 * 60 * 1000000LL)
+#define IDLE_CHECK_US 1000000  // the delegation is checked at least this often, also without requests
+#define BACKOFF_MIN_MS 10
+#define BACKOFF_MAX_MS 1000
+
+// encoded sizes: header of 8 bytes per tag plus the values
+#define DELE_SIZE (3 * 8 + ROUGHTIME_PUBKEY_SIZE + 8 + 8)
+#define CERT_SIZE (2 * 8 + ROUGHTIME_SIG_SIZE + DELE_SIZE)
+#define SREP_SIZE (3 * 8 + 4 + 8 + ROUGHTIME_HASH_SIZE)
+#define RESPONSE_SIZE \
+    (5 * 8 + ROUGHTIME_SIG_SIZE + ROUGHTIME_MAX_TREE_DEPTH * ROUGHTIME_HASH_SIZE + SREP_SIZE + CERT_SIZE + 4)
+// requests are padded to 1024 bytes, longer ones are truncated and still answered if the nonce is complete
+#define REQUEST_BUFFER_SIZE 1280
+
+static uint8_t long_term_sk[crypto_sign_SECRETKEYBYTES];
+static uint8_t online_sk[crypto_sign_SECRETKEYBYTES];
+// the certificate of the online key is the same in every response until it is renewed
+static uint8_t cert[CERT_SIZE];
+static size_t cert_length = 0;
+static uint64_t cert_mint;
+static uint64_t cert_maxt;
+
+// the current batch
+static uint8_t nonces[ROUGHTIME_MAX_BATCH][ROUGHTIME_NONCE_SIZE];
+static struct sockaddr_in clients[ROUGHTIME_MAX_BATCH];
+static uint16_t request_lengths[ROUGHTIME_MAX_BATCH];
+static roughtime_tree_t tree;
+static uint8_t request[REQUEST_BUFFER_SIZE];
+
+static roughtime_stats_t stats;
+
+void roughtime_stats(roughtime_stats_t *out) { *out = stats; }
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = v >> (8 * i);
+    }
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = v >> (8 * i);
+    }
+}
+
+// the seed of the long-term key is kept in NVS, a new one is generated on the first start
+static bool load_long_term_key(void) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(ROUGHTIME_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Cannot open NVS namespace '%s' (%s)", ROUGHTIME_NVS_NAMESPACE, esp_err_to_name(err));
+        return false;
+    }
+    uint8_t seed[crypto_sign_SEEDBYTES];
+    size_t len = sizeof(seed);
+    err = nvs_get_blob(handle, ROUGHTIME_NVS_SEED, seed, &len);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        randombytes_buf(seed, sizeof(seed));
+        err = nvs_set_blob(handle, ROUGHTIME_NVS_SEED, seed, sizeof(seed));
+        err = err == ESP_OK ? nvs_commit(handle) : err;
+        ESP_LOGW(TAG, "Generated a new long-term key");
+    } else if (err == ESP_OK && len != sizeof(seed)) {
+        err = ESP_ERR_INVALID_SIZE;
+    }
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "No long-term key (%s)", esp_err_to_name(err));
+        sodium_memzero(seed, sizeof(seed));
+        return false;
+    }
+    uint8_t pk[crypto_sign_PUBLICKEYBYTES];
+    crypto_sign_seed_keypair(pk, long_term_sk, seed);
+    sodium_memzero(seed, sizeof(seed));
+    // clients are configured with the base64 public key
+    unsigned char b64[48];
+    size_t b64_len;
+    mbedtls_base64_encode(b64, sizeof(b64), &b64_len, pk, sizeof(pk));
+    ESP_LOGI(TAG, "Long-term public key %s", b64);
+    return true;
+}
+
+// certifies a new online key for [now, now + CONFIG_ROUGHTIME_DELEGATION_HOURS], the only long-term signature
+static void delegate(uint64_t now_us) {
+    uint8_t pk[crypto_sign_PUBLICKEYBYTES];
+    crypto_sign_keypair(pk, online_sk);
+    cert_mint = now_us;
+    cert_maxt = now_us + DELEGATION_US;
+    uint8_t mint[8];
+    uint8_t maxt[8];
+    put_u64(mint, cert_mint);
+    put_u64(maxt, cert_maxt);
+    const roughtime_field_t dele_fields[] = {
+        {ROUGHTIME_TAG_PUBK, pk, sizeof(pk)},
+        {ROUGHTIME_TAG_MINT, mint, sizeof(mint)},
+        {ROUGHTIME_TAG_MAXT, maxt, sizeof(maxt)},
+    };
+    // the signed data is the context string including its zero, followed by DELE
+    uint8_t signed_dele[sizeof(ROUGHTIME_DELEGATION_CONTEXT) + DELE_SIZE];
+    memcpy(signed_dele, ROUGHTIME_DELEGATION_CONTEXT, sizeof(ROUGHTIME_DELEGATION_CONTEXT));
+    uint8_t *dele = &signed_dele[sizeof(ROUGHTIME_DELEGATION_CONTEXT)];
+    size_t dele_length = roughtime_encode(dele_fields, 3, dele, DELE_SIZE);
+    uint8_t sig[ROUGHTIME_SIG_SIZE];
+    crypto_sign_detached(sig, NULL, signed_dele, sizeof(ROUGHTIME_DELEGATION_CONTEXT) + dele_length, long_term_sk);
+    const roughtime_field_t cert_fields[] = {
+        {ROUGHTIME_TAG_SIG, sig, sizeof(sig)},
+        {ROUGHTIME_TAG_DELE, dele, dele_length},
+    };
+    cert_length = roughtime_encode(cert_fields, 2, cert, sizeof(cert));
+    stats.delegations++;
+    stats.signatures++;
+    ESP_LOGI(TAG, "Delegated a new online key for %d hours", CONFIG_ROUGHTIME_DELEGATION_HOURS);
+}
+
+// radius of the midpoint, false while the time must not be signed
+static bool clock_radius(uint32_t *radius_us) {
+    ntp_server_info_t info;
+    ntp_server_info(&info);
+#if !CONFIG_CLOCK_SELECT
+    if (dcf77_last_sync() == 0) {
+        return false;
+    }
+#endif
+    if (info.leap == 3) {
+        return false;
+    }
+    // NTP short format, 16.16 seconds
+    uint64_t radius = (((uint64_t)info.root_delay / 2 + info.root_dispersion) * 1000000) >> 16;
+    *radius_us = MIN(radius + 1, UINT32_MAX);
+    return true;
+}
+
+// delegates once the clock is synchronized, renews when a quarter of the validity is left or after the clock was
+// stepped back. Runs between batches, so no request waits for the long-term signature.
+static void renew_delegation(void) {
+    uint32_t radius_us;
+    if (!clock_radius(&radius_us)) {
+        return;
+    }
+    uint64_t now = timebase_hires_realtime_ns() / 1000;
+    if (cert_length == 0 || now < cert_mint || now + DELEGATION_US / 4 > cert_maxt) {
+        delegate(now);
+    }
+}
+
+// one signature over the Merkle root of all nonces of the batch, each response carries the path to its leaf
+static void respond(int sock, uint32_t count) {
+    uint32_t radius_us;
+    uint64_t midpoint = timebase_hires_realtime_ns() / 1000;
+    if (!clock_radius(&radius_us) || cert_length == 0 || midpoint < cert_mint || midpoint > cert_maxt) {
+        stats.dropped += count;
+        return;
+    }
+    roughtime_tree_build(&tree, (const uint8_t (*)[ROUGHTIME_NONCE_SIZE])nonces, count);
+
+    uint8_t radi[4];
+    uint8_t midp[8];
+    put_u32(radi, radius_us);
+    put_u64(midp, midpoint);
+    const roughtime_field_t srep_fields[] = {
+        {ROUGHTIME_TAG_RADI, radi, sizeof(radi)},
+        {ROUGHTIME_TAG_MIDP, midp, sizeof(midp)},
+        {ROUGHTIME_TAG_ROOT, roughtime_tree_root(&tree), ROUGHTIME_HASH_SIZE},
+    };
+    uint8_t signed_srep[sizeof(ROUGHTIME_RESPONSE_CONTEXT) + SREP_SIZE];
+    memcpy(signed_srep, ROUGHTIME_RESPONSE_CONTEXT, sizeof(ROUGHTIME_RESPONSE_CONTEXT));
+    uint8_t *srep = &signed_srep[sizeof(ROUGHTIME_RESPONSE_CONTEXT)];
+    size_t srep_length = roughtime_encode(srep_fields, 3, srep, SREP_SIZE);
+    uint8_t sig[ROUGHTIME_SIG_SIZE];
+    crypto_sign_detached(sig, NULL, signed_srep, sizeof(ROUGHTIME_RESPONSE_CONTEXT) + srep_length, online_sk);
+    stats.signatures++;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t path[ROUGHTIME_MAX_TREE_DEPTH * ROUGHTIME_HASH_SIZE];
+        uint8_t indx[4];
+        roughtime_tree_path(&tree, i, path);
+        put_u32(indx, i);
+        const roughtime_field_t fields[] = {
+            {ROUGHTIME_TAG_SIG, sig, sizeof(sig)},
+            {ROUGHTIME_TAG_PATH, path, tree.depth * ROUGHTIME_HASH_SIZE},
+            {ROUGHTIME_TAG_SREP, srep, srep_length},
+            {ROUGHTIME_TAG_CERT, cert, cert_length},
+            {ROUGHTIME_TAG_INDX, indx, sizeof(indx)},
+        };
+        uint8_t response[RESPONSE_SIZE];
+        // never larger than the request, no amplification
+        size_t length = roughtime_encode(fields, 5, response, MIN(sizeof(response), request_lengths[i]));
+        if (length > 0) {
+            sendto(sock, response, length, 0, (struct sockaddr *)&clients[i], sizeof(clients[i]));
+        }
+    }
+    stats.requests += count;
+}
+
+// adds a waiting request to the batch if it is valid. Returns 1 if a datagram was read, 0 if none was waiting and
+// -1 with errno set if the socket failed.
+static int receive(int sock, uint32_t *count) {
+    struct sockaddr_in source_addr;
+    socklen_t socklen = sizeof(source_addr);
+    int len = recvfrom(sock, request, sizeof(request), MSG_DONTWAIT, (struct sockaddr *)&source_addr, &socklen);
+    if (len < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+    }
+    const uint8_t *nonce = roughtime_request_nonce(request, len);
+    if (nonce == NULL) {
+        stats.dropped++;
+        return 1;
+    }
+    memcpy(nonces[*count], nonce, ROUGHTIME_NONCE_SIZE);
+    clients[*count] = source_addr;
+    request_lengths[*count] = len;
+    (*count)++;
+    return 1;
+}
+
+// > 0 if a datagram is waiting, 0 after the timeout, < 0 with errno set on errors
+static int wait_readable(int sock, int64_t timeout_us) {
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(sock, &fds);
+    struct timeval tv = {.tv_sec = timeout_us / 1000000, .tv_usec = timeout_us % 1000000};
+    return select(sock + 1, &fds, NULL, NULL, &tv);
+}
+
+void roughtime_task(void *pvParameters) {
+    mem_budget_add_static("roughtime", sizeof(long_term_sk) + sizeof(online_sk) + sizeof(cert) + sizeof(nonces) +
+                                           sizeof(clients) + sizeof(request_lengths) + sizeof(tree) + sizeof(request));
+    if (sodium_init() < 0 || !load_long_term_key()) {
+        mem_budget_task_exit();
+        return;
+    }
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        mem_budget_task_exit();
+        return;
+    }
+    struct sockaddr_in dest_addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(CONFIG_ROUGHTIME_PORT),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr)) < 0) {
+        ESP_LOGE(TAG, "Socket unable to bind: errno %d", errno);
+        close(sock);
+        mem_budget_task_exit();
+        return;
+    }
+    ESP_LOGI(TAG, "Socket bound, port %d", CONFIG_ROUGHTIME_PORT);
+
+    // request rate in 1/16 requests per second, decides how long a batch waits for more requests
+    int64_t rate = 0;
+    int64_t last_batch = timebase_monotonic_us();
+    int64_t last_report = last_batch;
+    int backoff_ms = 0;
+    while (1) {
+        renew_delegation();
+        uint32_t count = 0;
+        int ready = wait_readable(sock, IDLE_CHECK_US);
+        int received = ready > 0 ? receive(sock, &count) : ready;
+        if (received < 0 && errno != EINTR) {
+            // a failing socket must not keep the task busy, the log shows each retry
+            int err = errno;
+            backoff_ms = MIN(MAX(backoff_ms * 2, BACKOFF_MIN_MS), BACKOFF_MAX_MS);
+            ESP_LOGE(TAG, "Receive failed: errno %d, retrying in %d ms", err, backoff_ms);
+            vTaskDelay(pdMS_TO_TICKS(backoff_ms));
+            continue;
+        }
+        if (received > 0) {
+            backoff_ms = 0;
+        }
+        if (count == 0) {
+            continue;
+        }
+        int64_t first = timebase_monotonic_us();
+        // at low rates the first request is answered at once, the window is only spent when more are expected
+        uint32_t expected = MIN(MAX(rate * BATCH_WINDOW_US / (16 * 1000000LL), 1), ROUGHTIME_MAX_BATCH);
+        while (count < ROUGHTIME_MAX_BATCH) {
+            // whatever is queued already joins the batch
+            received = receive(sock, &count);
+            if (received > 0) {
+                continue;
+            }
+            int64_t waited = timebase_monotonic_us() - first;
+            // a socket error ends the batch, the next wait reports it
+            if (received < 0 || count >= expected || waited >= BATCH_WINDOW_US ||
+                wait_readable(sock, BATCH_WINDOW_US - waited) <= 0) {
+                break;
+            }
+        }
+        respond(sock, count);
+
+        int64_t now = timebase_monotonic_us();
+        int64_t sample = (int64_t)count * 16 * 1000000 / MAX(now - last_batch, 1);
+        rate += (sample - rate) / 4;
+        last_batch = now;
+        if (now - last_report >= STATS_INTERVAL_US) {
+            last_report = now;
+            ESP_LOGI(TAG, "%lu requests, %lu signatures, %lu dropped, batch limit %lu",
+                     (unsigned long)stats.requests, (unsigned long)stats.signatures, (unsigned long)stats.dropped,
+                     (unsigned long)expected);
+        }
+    }
+}
+
+#endif  // CONFIG_ROUGHTIME
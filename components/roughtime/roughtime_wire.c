@@ -0,0 +1,136 @@
+#include "roughtime_wire.h"
+
+#include <string.h>
+
+#include "mbedtls/sha512.h"
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+// header: number of tags, offsets of the values 1..n-1 relative to the first value, tags
+size_t roughtime_encode(const roughtime_field_t *fields, int count, uint8_t *out, size_t size) {
+    size_t header = count == 0 ? 4 : 8 * (size_t)count;
+    size_t total = header;
+    for (int i = 0; i < count; i++) {
+        if (fields[i].length % 4 != 0 || (i > 0 && fields[i].tag <= fields[i - 1].tag)) {
+            return 0;
+        }
+        total += fields[i].length;
+    }
+    if (total > size) {
+        return 0;
+    }
+    put_u32(out, count);
+    uint32_t offset = 0;
+    uint8_t *value = out + header;
+    for (int i = 0; i < count; i++) {
+        if (i > 0) {
+            put_u32(out + 4 * i, offset);
+        }
+        put_u32(out + 4 * count + 4 * i, fields[i].tag);
+        memcpy(value + offset, fields[i].value, fields[i].length);
+        offset += fields[i].length;
+    }
+    return total;
+}
+
+bool roughtime_find(const uint8_t *msg, size_t length, uint32_t tag, const uint8_t **value, uint32_t *value_length) {
+    if (length < 4 || length % 4 != 0) {
+        return false;
+    }
+    uint32_t count = get_u32(msg);
+    if (count == 0 || count > length / 8) {
+        return false;
+    }
+    const uint8_t *offsets = msg + 4;  // offsets[-1] is the implicit 0 of the first value
+    const uint8_t *tags = msg + 4 * count;
+    const uint8_t *values = msg + 8 * count;
+    uint32_t values_length = length - 8 * count;
+    bool found = false;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t start = i == 0 ? 0 : get_u32(offsets + 4 * (i - 1));
+        uint32_t end = i == count - 1 ? values_length : get_u32(offsets + 4 * i);
+        uint32_t t = get_u32(tags + 4 * i);
+        if (start % 4 != 0 || end < start || end > values_length || (i > 0 && t <= get_u32(tags + 4 * (i - 1)))) {
+            return false;
+        }
+        if (t == tag) {
+            *value = values + start;
+            *value_length = end - start;
+            found = true;
+        }
+    }
+    return found;
+}
+
+const uint8_t *roughtime_request_nonce(const uint8_t *msg, size_t length) {
+    const uint8_t *nonce;
+    uint32_t nonce_length;
+    if (length < ROUGHTIME_MIN_REQUEST_SIZE ||
+        !roughtime_find(msg, length, ROUGHTIME_TAG_NONC, &nonce, &nonce_length) ||
+        nonce_length != ROUGHTIME_NONCE_SIZE) {
+        return NULL;
+    }
+    return nonce;
+}
+
+// leaf: H(0x00 || nonce), node: H(0x01 || left || right)
+static void hash_leaf(const uint8_t *nonce, uint8_t *out) {
+    uint8_t in[1 + ROUGHTIME_NONCE_SIZE];
+    in[0] = 0x00;
+    memcpy(&in[1], nonce, ROUGHTIME_NONCE_SIZE);
+    mbedtls_sha512(in, sizeof(in), out, 0);
+}
+
+static void hash_node(const uint8_t *left, const uint8_t *right, uint8_t *out) {
+    uint8_t in[1 + 2 * ROUGHTIME_HASH_SIZE];
+    in[0] = 0x01;
+    memcpy(&in[1], left, ROUGHTIME_HASH_SIZE);
+    memcpy(&in[1 + ROUGHTIME_HASH_SIZE], right, ROUGHTIME_HASH_SIZE);
+    mbedtls_sha512(in, sizeof(in), out, 0);
+}
+
+void roughtime_tree_build(roughtime_tree_t *tree, const uint8_t (*nonces)[ROUGHTIME_NONCE_SIZE], uint32_t count) {
+    tree->leaves = 1;
+    tree->depth = 0;
+    while (tree->leaves < count) {
+        tree->leaves <<= 1;
+        tree->depth++;
+    }
+    for (uint32_t i = 0; i < tree->leaves; i++) {
+        // the padding leaves only have to be something no client can claim
+        if (i < count) {
+            hash_leaf(nonces[i], tree->nodes[i]);
+        } else {
+            memset(tree->nodes[i], 0, ROUGHTIME_HASH_SIZE);
+        }
+    }
+    // each level follows the one below it
+    uint32_t below = 0;
+    uint32_t level = tree->leaves;
+    for (uint32_t width = tree->leaves / 2; width > 0; width /= 2) {
+        for (uint32_t i = 0; i < width; i++) {
+            hash_node(tree->nodes[below + 2 * i], tree->nodes[below + 2 * i + 1], tree->nodes[level + i]);
+        }
+        below = level;
+        level += width;
+    }
+}
+
+void roughtime_tree_path(const roughtime_tree_t *tree, uint32_t index, uint8_t *path) {
+    uint32_t level = 0;
+    for (uint32_t width = tree->leaves; width > 1; width /= 2) {
+        memcpy(path, tree->nodes[level + (index ^ 1)], ROUGHTIME_HASH_SIZE);
+        path += ROUGHTIME_HASH_SIZE;
+        level += width;
+        index /= 2;
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+// Roughtime wire format (the original Google protocol): tagged messages, the Merkle tree over the request nonces
+// and its paths. No crypto besides SHA-512, no sockets, so it builds on a Linux host as well.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#define ROUGHTIME_MIN_REQUEST_SIZE 1024  // requests are padded, no response is larger than its request
+#define ROUGHTIME_NONCE_SIZE 64
+#define ROUGHTIME_HASH_SIZE 64  // SHA-512
+#define ROUGHTIME_SIG_SIZE 64
+#define ROUGHTIME_PUBKEY_SIZE 32
+#ifdef CONFIG_ROUGHTIME_MAX_BATCH_LOG2
+#define ROUGHTIME_MAX_TREE_DEPTH CONFIG_ROUGHTIME_MAX_BATCH_LOG2
+#else
+#define ROUGHTIME_MAX_TREE_DEPTH 7
+#endif
+#define ROUGHTIME_MAX_BATCH (1 << ROUGHTIME_MAX_TREE_DEPTH)
+
+// tags are four ASCII characters, compared as little endian uint32
+#define ROUGHTIME_TAG(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+#define ROUGHTIME_TAG_SIG ROUGHTIME_TAG('S', 'I', 'G', 0)
+#define ROUGHTIME_TAG_NONC ROUGHTIME_TAG('N', 'O', 'N', 'C')
+#define ROUGHTIME_TAG_DELE ROUGHTIME_TAG('D', 'E', 'L', 'E')
+#define ROUGHTIME_TAG_PATH ROUGHTIME_TAG('P', 'A', 'T', 'H')
+#define ROUGHTIME_TAG_RADI ROUGHTIME_TAG('R', 'A', 'D', 'I')
+#define ROUGHTIME_TAG_PUBK ROUGHTIME_TAG('P', 'U', 'B', 'K')
+#define ROUGHTIME_TAG_MIDP ROUGHTIME_TAG('M', 'I', 'D', 'P')
+#define ROUGHTIME_TAG_SREP ROUGHTIME_TAG('S', 'R', 'E', 'P')
+#define ROUGHTIME_TAG_MINT ROUGHTIME_TAG('M', 'I', 'N', 'T')
+#define ROUGHTIME_TAG_ROOT ROUGHTIME_TAG('R', 'O', 'O', 'T')
+#define ROUGHTIME_TAG_CERT ROUGHTIME_TAG('C', 'E', 'R', 'T')
+#define ROUGHTIME_TAG_MAXT ROUGHTIME_TAG('M', 'A', 'X', 'T')
+#define ROUGHTIME_TAG_INDX ROUGHTIME_TAG('I', 'N', 'D', 'X')
+
+// signature contexts, the terminating zero is part of the signed data
+#define ROUGHTIME_DELEGATION_CONTEXT "RoughTime v1 delegation signature--"
+#define ROUGHTIME_RESPONSE_CONTEXT "RoughTime v1 response signature"
+
+typedef struct {
+    uint32_t tag;
+    const void *value;
+    uint32_t length;  // multiple of 4
+} roughtime_field_t;
+
+// writes a message, the fields must be sorted by tag. Returns the length or 0 if it does not fit.
+size_t roughtime_encode(const roughtime_field_t *fields, int count, uint8_t *out, size_t size);
+
+// finds the value of a tag in a message, false if the message is malformed or has no such tag
+bool roughtime_find(const uint8_t *msg, size_t length, uint32_t tag, const uint8_t **value, uint32_t *value_length);
+
+// returns the 64 byte nonce of a request or NULL if it is not a valid request
+const uint8_t *roughtime_request_nonce(const uint8_t *msg, size_t length);
+
+// Merkle tree over the nonces of one batch, leaves padded to a power of two
+typedef struct {
+    uint8_t nodes[(2 << ROUGHTIME_MAX_TREE_DEPTH) - 1][ROUGHTIME_HASH_SIZE];  // leaves first, root last
+    uint32_t leaves;  // power of two
+    uint8_t depth;
+} roughtime_tree_t;
+
+void roughtime_tree_build(roughtime_tree_t *tree, const uint8_t (*nonces)[ROUGHTIME_NONCE_SIZE], uint32_t count);
+
+static inline const uint8_t *roughtime_tree_root(const roughtime_tree_t *tree) {
+    return tree->nodes[2 * tree->leaves - 2];
+}
+
+// writes the sibling hashes from the leaf up to the root, depth * ROUGHTIME_HASH_SIZE bytes
+void roughtime_tree_path(const roughtime_tree_t *tree, uint32_t index, uint8_t *path);
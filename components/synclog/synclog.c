@@ -0,0 +1,158 @@
+#include "synclog.h"
+
+#include <string.h>
+
+#include "dcf77.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "mem_budget.h"
+#include "sdkconfig.h"
+#include "synclog_ring.h"
+#include "time_source.h"
+#include "timebase.h"
+#include "udp_server_task.h"
+
+#if CONFIG_SYNCLOG
+
+static const char *TAG = "synclog";
+
+#define SYNCLOG_PARTITION_NAME "synclog"
+// without a valid frame for this long the receiver counts as holdover (no clock selection)
+#define HOLDOVER_AFTER_S 120
+// time in each minute at which the entry is collected and written, between the second 30 and 31 pulses
+#define WAKE_MS 30500
+
+// snapshot of the cumulative counters at the end of the previous minute
+typedef struct {
+    timecode_rx_stats_t rx;
+    uint32_t requests;
+    timebase_corrections_t corrections;
+} synclog_counters_t;
+
+static synclog_ring_t ring;
+static synclog_entry_t pending[CONFIG_SYNCLOG_BATCH];
+static int pending_count = 0;
+static SemaphoreHandle_t lock = NULL;
+
+void synclog_flush(void) {
+    if (lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    synclog_ring_write(&ring, pending, pending_count);
+    pending_count = 0;
+    xSemaphoreGive(lock);
+}
+
+bool synclog_read(uint32_t age, synclog_entry_t *entry) {
+    if (lock == NULL) {
+        return false;
+    }
+    bool found = false;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (age < (uint32_t)pending_count) {
+        *entry = pending[pending_count - 1 - age];
+        found = true;
+    } else {
+        found = synclog_ring_read(&ring, age - pending_count + 1, entry);
+    }
+    xSemaphoreGive(lock);
+    return found;
+}
+
+static uint32_t saturate_u32(int64_t v) { return v < 0 ? 0 : (v > UINT32_MAX ? UINT32_MAX : (uint32_t)v); }
+
+static void synclog_collect(synclog_entry_t *entry, synclog_counters_t *last, uint32_t time, bool boot) {
+    synclog_counters_t now;
+    dcf77_stats(&now.rx);
+    now.requests = ntp_server_requests();
+    timebase_corrections(&now.corrections);
+
+    int64_t offset = now.corrections.total_us - last->corrections.total_us;
+    uint32_t pulses = now.rx.pulses - last->rx.pulses;
+    uint32_t invalid = now.rx.invalid_pulses - last->rx.invalid_pulses;
+    uint32_t requests = now.requests - last->requests;
+    uint32_t valid = now.rx.frames_valid - last->rx.frames_valid;
+    uint32_t failed = now.rx.frames_invalid - last->rx.frames_invalid;
+
+    ntp_server_info_t info;
+    ntp_server_info(&info);
+    *entry = (synclog_entry_t){
+        .seq = 0,  // assigned when queued
+        .time = time,
+        .offset_us = offset > INT32_MAX ? INT32_MAX : (offset < INT32_MIN ? INT32_MIN : (int32_t)offset),
+        .root_dispersion_us = saturate_u32(((uint64_t)info.root_dispersion * 1000000) >> 16),
+        .requests = requests > UINT16_MAX ? UINT16_MAX : requests,
+        .frames_valid = valid > UINT8_MAX ? UINT8_MAX : valid,
+        .frames_invalid = failed > UINT8_MAX ? UINT8_MAX : failed,
+        .pulse_quality = pulses + invalid == 0 ? 255 : (uint8_t)(100 * pulses / (pulses + invalid)),
+        .stratum = info.stratum,
+        .refid = info.refid,
+    };
+#if CONFIG_CLOCK_SELECT
+    time_source_status_t status;
+    time_source_status(&status);
+    entry->flags |= status.synchronized ? SYNCLOG_FLAG_SYNCHRONIZED : 0;
+    entry->flags |= status.holdover ? SYNCLOG_FLAG_HOLDOVER : 0;
+#else
+    time_t last_sync = dcf77_last_sync();
+    entry->flags |= last_sync != 0 ? SYNCLOG_FLAG_SYNCHRONIZED : 0;
+    entry->flags |= last_sync != 0 && time - last_sync > HOLDOVER_AFTER_S ? SYNCLOG_FLAG_HOLDOVER : 0;
+#endif
+    entry->flags |= now.corrections.steps != last->corrections.steps ? SYNCLOG_FLAG_STEPPED : 0;
+    entry->flags |= boot ? SYNCLOG_FLAG_BOOT : 0;
+    *last = now;
+}
+
+void synclog_task(void *pvParameters) {
+    const esp_partition_t *partition =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, SYNCLOG_PARTITION_SUBTYPE, SYNCLOG_PARTITION_NAME);
+    if (partition == NULL || partition->size < 2 * SYNCLOG_SECTOR_SIZE) {
+        ESP_LOGE(TAG, "No '%s' partition of at least two sectors, see partitions.csv", SYNCLOG_PARTITION_NAME);
+        mem_budget_task_exit();
+        return;
+    }
+    synclog_ring_open(&ring, partition);
+    static StaticSemaphore_t lock_buffer;
+    lock = xSemaphoreCreateMutexStatic(&lock_buffer);
+    mem_budget_add_static("synclog", sizeof(pending) + sizeof(lock_buffer));
+    esp_register_shutdown_handler(synclog_flush);
+
+    synclog_counters_t last = {0};
+    bool boot = true;
+    struct timeval tv;
+    timebase_realtime(&tv);
+    while (1) {
+        // wake up once a minute at second 30.5 of the system clock, in the middle of a pulse gap of the receiver:
+        // erasing or programming flash holds off every interrupt that is not in IRAM, the DCF77 edge ISR included.
+        // The delay is rounded to ticks and the clock may be slewed meanwhile, so an early wake-up waits for the
+        // rest of the minute; a step back also ends the wait.
+        int64_t ms = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000 - WAKE_MS;
+        int64_t minute = ms / 60000;
+        do {
+            vTaskDelay(pdMS_TO_TICKS(60000 - ms % 60000) + 1);
+            timebase_realtime(&tv);
+            ms = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000 - WAKE_MS;
+        } while (ms / 60000 == minute);
+
+        synclog_entry_t entry;
+        synclog_collect(&entry, &last, (uint32_t)tv.tv_sec, boot);
+        boot = false;
+
+        xSemaphoreTake(lock, portMAX_DELAY);
+        entry.seq = ring.next_seq++;
+        entry.crc = synclog_entry_crc(&entry);
+        pending[pending_count++] = entry;
+        if (pending_count == CONFIG_SYNCLOG_BATCH) {
+            synclog_ring_write(&ring, pending, pending_count);
+            pending_count = 0;
+        }
+        xSemaphoreGive(lock);
+    }
+}
+
+#endif  // CONFIG_SYNCLOG
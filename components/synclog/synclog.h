@@ -0,0 +1,19 @@
+#pragma once
+
+// Append-only sync history in the "synclog" partition: one synclog_entry_t per minute with decode result,
+// applied offset, signal quality, request count and holdover state. A low priority task collects the entries and
+// writes them in batches, so flash access never happens on the decoder or server paths. Decode a partition image
+// with tools/synclog_decode.py.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "synclog_format.h"
+
+void synclog_task(void *pvParameters);
+
+// writes the collected entries now, e.g. before a planned restart (also registered as shutdown handler)
+void synclog_flush(void);
+
+// copies the entry written age minutes ago (0 = newest, including entries not flushed yet), false if there is none
+bool synclog_read(uint32_t age, synclog_entry_t *entry);
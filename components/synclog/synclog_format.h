@@ -0,0 +1,36 @@
+#pragma once
+
+// On-flash format of the sync history log, shared with tools/synclog_decode.py.
+// The partition is a ring of 4 kB sectors holding fixed-size little-endian entries, one per minute. Erased flash
+// (all ones) marks free slots, the sequence number orders the entries across the ring.
+
+#include <stdint.h>
+
+#define SYNCLOG_PARTITION_SUBTYPE 0x40
+#define SYNCLOG_SECTOR_SIZE 4096
+#define SYNCLOG_ENTRY_SIZE 32
+#define SYNCLOG_ENTRIES_PER_SECTOR (SYNCLOG_SECTOR_SIZE / SYNCLOG_ENTRY_SIZE)
+#define SYNCLOG_SEQ_FREE 0xFFFFFFFF
+
+#define SYNCLOG_FLAG_SYNCHRONIZED 0x01
+#define SYNCLOG_FLAG_HOLDOVER 0x02
+#define SYNCLOG_FLAG_STEPPED 0x04  // the clock was stepped in this minute
+#define SYNCLOG_FLAG_BOOT 0x08     // first entry after a reboot
+
+typedef struct __attribute__((packed)) {
+    uint32_t seq;
+    uint32_t time;                // Unix time at the end of the minute, second 30
+    int32_t offset_us;            // corrections applied to the clock in this minute, saturated
+    uint32_t root_dispersion_us;  // as announced by the NTP server, saturated
+    uint16_t requests;            // NTP requests answered in this minute, saturated
+    uint8_t frames_valid;         // time code frames decoded in this minute
+    uint8_t frames_invalid;
+    uint8_t pulse_quality;        // pulses of a known width in percent, 255 if there were none
+    uint8_t flags;                // SYNCLOG_FLAG_*
+    uint8_t stratum;
+    uint8_t reserved;
+    uint32_t refid;
+    uint32_t crc;                 // CRC-32 (as zlib) of the bytes before
+} synclog_entry_t;
+
+_Static_assert(sizeof(synclog_entry_t) == SYNCLOG_ENTRY_SIZE, "synclog entry size");
@@ -0,0 +1,107 @@
+#include "synclog_ring.h"
+
+#include <stddef.h>
+
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+
+static const char *TAG = "synclog";
+
+uint32_t synclog_entry_crc(const synclog_entry_t *entry) {
+    return esp_rom_crc32_le(0, (const uint8_t *)entry, offsetof(synclog_entry_t, crc));
+}
+
+static bool read_slot(const synclog_ring_t *ring, uint32_t slot, synclog_entry_t *entry) {
+    return esp_partition_read(ring->partition, slot * SYNCLOG_ENTRY_SIZE, entry, sizeof(*entry)) == ESP_OK &&
+           entry->seq != SYNCLOG_SEQ_FREE && entry->crc == synclog_entry_crc(entry);
+}
+
+// true if the slots from first to end are erased flash, so they can be written
+static bool slots_erased(const synclog_ring_t *ring, uint32_t first, uint32_t end) {
+    for (uint32_t slot = first; slot < end; slot++) {
+        uint32_t words[SYNCLOG_ENTRY_SIZE / 4];
+        if (esp_partition_read(ring->partition, slot * SYNCLOG_ENTRY_SIZE, words, sizeof(words)) != ESP_OK) {
+            return false;
+        }
+        for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+            if (words[i] != 0xFFFFFFFF) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void synclog_ring_open(synclog_ring_t *ring, const esp_partition_t *partition) {
+    *ring = (synclog_ring_t){
+        .partition = partition,
+        .capacity = partition->size / SYNCLOG_SECTOR_SIZE * SYNCLOG_ENTRIES_PER_SECTOR,
+    };
+    uint32_t sectors = ring->capacity / SYNCLOG_ENTRIES_PER_SECTOR;
+    bool found = false;
+    uint32_t newest_sector = 0;
+    uint32_t newest_seq = 0;
+    for (uint32_t s = 0; s < sectors; s++) {
+        synclog_entry_t entry;
+        if (read_slot(ring, s * SYNCLOG_ENTRIES_PER_SECTOR, &entry) && (!found || entry.seq > newest_seq)) {
+            found = true;
+            newest_sector = s;
+            newest_seq = entry.seq;
+        }
+    }
+    if (!found) {
+        ESP_LOGI(TAG, "Empty log, %lu entries (%lu days)", (unsigned long)ring->capacity,
+                 (unsigned long)(ring->capacity / (24 * 60)));
+        return;
+    }
+    uint32_t first = newest_sector * SYNCLOG_ENTRIES_PER_SECTOR;
+    uint32_t end = first + SYNCLOG_ENTRIES_PER_SECTOR;
+    uint32_t slot = first;
+    synclog_entry_t entry;
+    while (slot < end && read_slot(ring, slot, &entry)) {
+        ring->next_seq = entry.seq + 1;
+        slot++;
+    }
+    if (!slots_erased(ring, slot, end)) {
+        ESP_LOGW(TAG, "Torn entry at %lu, the log continues in the next sector", (unsigned long)slot);
+        slot = end;
+    }
+    ring->next_slot = slot % ring->capacity;
+    // the other sectors are full once the ring has been around, the sector after the newest then holds entries
+    bool wrapped = read_slot(ring, end % ring->capacity, &entry);
+    ring->written = wrapped ? ring->capacity - (end - slot) : slot;
+    ESP_LOGI(TAG, "Log continues at entry %lu", (unsigned long)ring->next_seq);
+}
+
+void synclog_ring_write(synclog_ring_t *ring, const synclog_entry_t *entries, int count) {
+    while (count > 0) {
+        uint32_t in_sector = ring->next_slot % SYNCLOG_ENTRIES_PER_SECTOR;
+        if (in_sector == 0 && esp_partition_erase_range(ring->partition, ring->next_slot * SYNCLOG_ENTRY_SIZE,
+                                                        SYNCLOG_SECTOR_SIZE) != ESP_OK) {
+            ESP_LOGE(TAG, "Erase failed at entry %lu", (unsigned long)ring->next_slot);
+            return;
+        }
+        int n = SYNCLOG_ENTRIES_PER_SECTOR - in_sector;
+        n = n < count ? n : count;
+        if (esp_partition_write(ring->partition, ring->next_slot * SYNCLOG_ENTRY_SIZE, entries,
+                                n * SYNCLOG_ENTRY_SIZE) != ESP_OK) {
+            ESP_LOGE(TAG, "Write failed at entry %lu", (unsigned long)ring->next_slot);
+            return;
+        }
+        // the erased sector dropped the oldest entries
+        if (in_sector == 0 && ring->written + SYNCLOG_ENTRIES_PER_SECTOR > ring->capacity) {
+            ring->written = ring->capacity - SYNCLOG_ENTRIES_PER_SECTOR;
+        }
+        ring->written += n;
+        ring->next_slot = (ring->next_slot + n) % ring->capacity;
+        entries += n;
+        count -= n;
+    }
+}
+
+bool synclog_ring_read(const synclog_ring_t *ring, uint32_t back, synclog_entry_t *entry) {
+    if (back == 0 || back > ring->written) {
+        return false;
+    }
+    return read_slot(ring, (ring->next_slot + ring->capacity - back) % ring->capacity, entry);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// The ring of synclog entries in the partition, without locking. The sector with the newest first entry holds the
+// end of the ring, a sector is erased when the ring enters it. Only uses esp_partition, so it also runs on a host
+// against an emulated flash.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_partition.h"
+#include "synclog_format.h"
+
+typedef struct {
+    const esp_partition_t *partition;
+    uint32_t capacity;   // entries in the partition
+    uint32_t next_slot;  // where the next entry goes
+    uint32_t next_seq;
+    uint32_t written;  // slots in use, at most capacity
+} synclog_ring_t;
+
+uint32_t synclog_entry_crc(const synclog_entry_t *entry);
+
+// finds the end of the ring in a partition of at least two sectors. A torn entry (reset during a write) at the end
+// can't be written over, the ring continues in the next sector.
+void synclog_ring_open(synclog_ring_t *ring, const esp_partition_t *partition);
+
+// writes entries with seq and crc set to consecutive slots
+void synclog_ring_write(synclog_ring_t *ring, const synclog_entry_t *entries, int count);
+
+// copies the entry back slots before the end (1 = the newest in flash), false if there is none or it is invalid
+bool synclog_ring_read(const synclog_ring_t *ring, uint32_t back, synclog_entry_t *entry);
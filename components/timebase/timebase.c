@@ -0,0 +1,72 @@
+#include "timebase.h"
+
+#include <time.h>
+
+static int64_t system_monotonic_us(void *ctx) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static void system_realtime(void *ctx, struct timeval *tv) { gettimeofday(tv, NULL); }
+
+static void system_step(void *ctx, int64_t offset_us) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    int64_t t = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec + offset_us;
+    tv.tv_sec = t / 1000000;
+    tv.tv_usec = t % 1000000;
+    settimeofday(&tv, NULL);
+}
+
+static void system_slew(void *ctx, int64_t offset_us) {
+    struct timeval delta = {.tv_sec = offset_us / 1000000, .tv_usec = offset_us % 1000000};
+    adjtime(&delta, NULL);
+}
+
+static int64_t system_slew_remaining_us(void *ctx) {
+    struct timeval remaining;
+    if (adjtime(NULL, &remaining) != 0) {
+        return 0;
+    }
+    return (int64_t)remaining.tv_sec * 1000000 + remaining.tv_usec;
+}
+
+static const timebase_backend_t system_backend = {
+    .monotonic_us = system_monotonic_us,
+    .realtime = system_realtime,
+    .step = system_step,
+    .slew = system_slew,
+    .slew_remaining_us = system_slew_remaining_us,
+};
+
+static const timebase_backend_t *backend = &system_backend;
+static int64_t corrected_us = 0;
+static uint32_t step_count = 0;
+static uint32_t slew_count = 0;
+
+void timebase_set_backend(const timebase_backend_t *b) { backend = b != NULL ? b : &system_backend; }
+
+int64_t timebase_monotonic_us(void) { return backend->monotonic_us(backend->ctx); }
+
+void timebase_realtime(struct timeval *tv) { backend->realtime(backend->ctx, tv); }
+
+void timebase_step(int64_t offset_us) {
+    backend->step(backend->ctx, offset_us);
+    __atomic_fetch_add(&corrected_us, offset_us, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&step_count, 1, __ATOMIC_RELAXED);
+}
+
+void timebase_slew(int64_t offset_us) {
+    backend->slew(backend->ctx, offset_us);
+    __atomic_fetch_add(&corrected_us, offset_us, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&slew_count, 1, __ATOMIC_RELAXED);
+}
+
+int64_t timebase_slew_remaining_us(void) { return backend->slew_remaining_us(backend->ctx); }
+
+void timebase_corrections(timebase_corrections_t *corrections) {
+    corrections->total_us = __atomic_load_n(&corrected_us, __ATOMIC_RELAXED);
+    corrections->steps = __atomic_load_n(&step_count, __ATOMIC_RELAXED);
+    corrections->slews = __atomic_load_n(&slew_count, __ATOMIC_RELAXED);
+}
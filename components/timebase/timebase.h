@@ -0,0 +1,43 @@
+#pragma once
+
+// Time base of the application: every time read and clock correction of the decoders, the source selection and the
+// servers goes through here. The default backend is the system clock, a virtual clock can be installed instead, e.g.
+// to run weeks of operation on a Linux host in minutes. Only depends on POSIX clock_gettime(), settimeofday() and
+// adjtime().
+
+#include <stdint.h>
+#include <sys/time.h>
+
+typedef struct {
+    int64_t (*monotonic_us)(void *ctx);               // time since boot, never stepped
+    void (*realtime)(void *ctx, struct timeval *tv);  // disciplined UTC
+    void (*step)(void *ctx, int64_t offset_us);       // sets realtime to realtime + offset at once
+    void (*slew)(void *ctx, int64_t offset_us);       // corrects realtime by offset gradually
+    int64_t (*slew_remaining_us)(void *ctx);          // part of the last slew not applied yet
+    void *ctx;
+} timebase_backend_t;
+
+// backend must stay valid while installed, NULL restores the system clock. Not thread safe, call it before the
+// tasks are started.
+void timebase_set_backend(const timebase_backend_t *backend);
+
+int64_t timebase_monotonic_us(void);
+
+void timebase_realtime(struct timeval *tv);
+
+void timebase_step(int64_t offset_us);
+
+void timebase_slew(int64_t offset_us);
+
+// 0 once the last timebase_slew() has been applied in full, or after a step
+int64_t timebase_slew_remaining_us(void);
+
+// corrections applied through timebase_step() and timebase_slew() since start
+typedef struct {
+    int64_t total_us;  // sum of all offsets
+    uint32_t steps;
+    uint32_t slews;
+} timebase_corrections_t;
+
+// thread safe, the counters are updated atomically
+void timebase_corrections(timebase_corrections_t *corrections);
@@ -0,0 +1,179 @@
+#include "timebase_hires.h"
+
+#include "driver/gptimer.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+#include "timebase.h"
+
+// microsecond system clock, 2^-19 s is the next power of two above 1 us
+#define PRECISION_SYSTEM_CLOCK -19
+
+static int8_t precision = PRECISION_SYSTEM_CLOCK;
+
+static uint64_t realtime_ns(void) {
+    struct timeval tv;
+    timebase_realtime(&tv);
+    return (uint64_t)tv.tv_sec * 1000000000 + (uint64_t)tv.tv_usec * 1000;
+}
+
+#if CONFIG_TIMEBASE_HIRES
+
+static const char *TAG = "timebase_hires";
+
+#define CALIBRATION_INTERVAL_US 1000000
+// a larger difference between interpolation and system time is a step of the clock, not drift
+#define STEP_THRESHOLD_NS 1000000
+// a calibration pair is only used if reading the system time took less than this
+#define CALIBRATION_WINDOW_NS 20000
+#define CALIBRATION_TRIES 3
+#define PRECISION_SAMPLES 1000
+
+// realtime(count) = base_ns + (count - base_count) * rate, rate in ns per tick as 32.32 fixed point split in
+// integer and fraction, so the products fit 64 bits for up to 2^32 ticks
+typedef struct {
+    uint64_t base_count;
+    uint64_t base_ns;
+    uint32_t rate_int;
+    uint32_t rate_frac;
+} hires_anchor_t;
+
+static gptimer_handle_t timer = NULL;
+static uint32_t resolution_hz;
+static hires_anchor_t anchor;
+static uint64_t last_count;
+static uint64_t last_ns;
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint64_t interpolate(const hires_anchor_t *a, uint64_t count) {
+    uint64_t ticks = count - a->base_count;
+    return a->base_ns + ticks * a->rate_int + ((ticks * a->rate_frac) >> 32);
+}
+
+static void set_rate(hires_anchor_t *a, uint64_t ns, uint64_t ticks) {
+    uint64_t rate = ((ns / ticks) << 32) + (((ns % ticks) << 32) / ticks);
+    a->rate_int = rate >> 32;
+    a->rate_frac = (uint32_t)rate;
+}
+
+// GPTimer count in the middle of a system time read; gettimeofday() takes a lock, so it can't be read inside the
+// critical section, a preempted read is repeated
+static bool calibration_pair(uint64_t *count, uint64_t *ns) {
+    uint64_t window_ticks = (uint64_t)CALIBRATION_WINDOW_NS * resolution_hz / 1000000000;
+    for (int i = 0; i < CALIBRATION_TRIES; i++) {
+        uint64_t before, after;
+        gptimer_get_raw_count(timer, &before);
+        *ns = realtime_ns();
+        gptimer_get_raw_count(timer, &after);
+        if (after - before <= window_ticks) {
+            *count = before + (after - before) / 2;
+            return true;
+        }
+    }
+    return false;
+}
+
+// keeps the interpolation continuous and steers it onto the system time over the next interval
+static void calibrate(void *arg) {
+    uint64_t count, now_ns;
+    if (!calibration_pair(&count, &now_ns)) {
+        return;
+    }
+    portENTER_CRITICAL(&lock);
+    hires_anchor_t a = anchor;
+    portEXIT_CRITICAL(&lock);
+
+    uint64_t predicted = interpolate(&a, count);
+    int64_t error = (int64_t)(now_ns - predicted);
+    int64_t target = (int64_t)(now_ns - last_ns) + error;
+    if (error > STEP_THRESHOLD_NS || error < -STEP_THRESHOLD_NS || target <= 0 || count == last_count) {
+        // stepped clock: start over from the system time with the nominal rate
+        a.base_ns = now_ns;
+        set_rate(&a, 1000000000, resolution_hz);
+    } else {
+        a.base_ns = predicted;
+        set_rate(&a, target, count - last_count);
+    }
+    a.base_count = count;
+    last_count = count;
+    last_ns = now_ns;
+
+    portENTER_CRITICAL(&lock);
+    anchor = a;
+    portEXIT_CRITICAL(&lock);
+}
+
+// smallest p with 2^p seconds >= ns
+static int8_t log2_seconds(uint64_t ns) {
+    int8_t p = -30;
+    while (p < 0 && (1000000000ULL >> -p) < ns) {
+        p++;
+    }
+    return p;
+}
+
+void timebase_hires_start(void) {
+    gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = CONFIG_TIMEBASE_HIRES_RESOLUTION_HZ,
+    };
+    gptimer_handle_t t = NULL;
+    ESP_ERROR_CHECK(gptimer_new_timer(&timer_config, &t));
+    ESP_ERROR_CHECK(gptimer_get_resolution(t, &resolution_hz));
+    ESP_ERROR_CHECK(gptimer_enable(t));
+    ESP_ERROR_CHECK(gptimer_start(t));
+
+    gptimer_get_raw_count(t, &last_count);
+    last_ns = realtime_ns();
+    anchor.base_count = last_count;
+    anchor.base_ns = last_ns;
+    set_rate(&anchor, 1000000000, resolution_hz);
+    timer = t;
+
+    // read cost: average time between consecutive reads, resolution: one tick
+    uint64_t first = timebase_hires_realtime_ns();
+    uint64_t prev = first;
+    uint64_t min_step = UINT64_MAX;
+    for (int i = 0; i < PRECISION_SAMPLES; i++) {
+        uint64_t ns = timebase_hires_realtime_ns();
+        if (ns > prev && ns - prev < min_step) {
+            min_step = ns - prev;
+        }
+        prev = ns;
+    }
+    uint64_t read_cost_ns = (prev - first) / PRECISION_SAMPLES;
+    uint64_t tick_ns = (1000000000ULL + resolution_hz - 1) / resolution_hz;
+    precision = log2_seconds(read_cost_ns > tick_ns ? read_cost_ns : tick_ns);
+    ESP_LOGI(TAG, "GPTimer %lu Hz (%llu ns), read cost %llu ns, smallest step %llu ns, precision %d",
+             (unsigned long)resolution_hz, (unsigned long long)tick_ns, (unsigned long long)read_cost_ns,
+             (unsigned long long)min_step, precision);
+
+    const esp_timer_create_args_t args = {
+        .callback = calibrate,
+        .name = "timebase_hires",
+    };
+    esp_timer_handle_t calibration_timer;
+    ESP_ERROR_CHECK(esp_timer_create(&args, &calibration_timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(calibration_timer, CALIBRATION_INTERVAL_US));
+}
+
+#endif  // CONFIG_TIMEBASE_HIRES
+
+uint64_t timebase_hires_realtime_ns(void) {
+#if CONFIG_TIMEBASE_HIRES
+    if (timer != NULL) {
+        uint64_t count;
+        portENTER_CRITICAL(&lock);
+        gptimer_get_raw_count(timer, &count);
+        uint64_t ns = interpolate(&anchor, count);
+        portEXIT_CRITICAL(&lock);
+        return ns;
+    }
+#endif
+    return realtime_ns();
+}
+
+int8_t timebase_hires_precision(void) { return precision; }
@@ -0,0 +1,16 @@
+#pragma once
+
+// High resolution realtime: a free running GPTimer interpolates between calibrations against timebase_realtime(),
+// the interpolation follows slewing and steps of the disciplined clock.
+
+#include <stdint.h>
+
+// creates the GPTimer, calibrates and measures read cost and resolution, call once before the tasks are started.
+// Only with CONFIG_TIMEBASE_HIRES.
+void timebase_hires_start(void);
+
+// nanoseconds since the Unix epoch, timebase_realtime() in microseconds if not started
+uint64_t timebase_hires_realtime_ns(void);
+
+// measured precision (log2 seconds) of timebase_hires_realtime_ns(), the larger of resolution and read cost
+int8_t timebase_hires_precision(void);
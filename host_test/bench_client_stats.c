@@ -0,0 +1,117 @@
+// client_stats_update() with millions of distinct sources. Every background source sends two requests,
+// 4 heavy hitters send 40 % of all requests. Reports ns per update next to the linear space-saving scan it replaced,
+// checks that the heavy hitters are found with correct bounds and the distinct client estimate.
+//   bench_client_stats [max sources]
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "client_stats.h"
+#include "freertos/FreeRTOS.h"
+#include "test_util.h"
+
+#define HEAVY_HITTERS 4
+#define TOP_K CONFIG_NTP_SERVER_CLIENT_STATS_TOP_K
+
+static inline uint32_t mix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+// request r of a stream over sources background sources, every fifth pair of requests is two heavy hitters
+static inline uint32_t source_of(uint32_t r, uint32_t sources) {
+    if (r % 5 < 2) {
+        return 0x0A000000 | ((r / 5 * 2 + r % 5) % HEAVY_HITTERS);
+    }
+    uint32_t n = r / 5 * 3 + r % 5 - 2;  // background request number
+    // a permutation of the sources, each one twice
+    return mix((uint32_t)((uint64_t)n * 2654435761u % sources) + 0x0B000000);
+}
+
+// the previous implementation: one pass over all K entries per request
+static client_stats_talker_t linear_top[TOP_K];
+static int linear_used;
+static portMUX_TYPE linear_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void linear_update(uint32_t addr) {
+    int min = 0;
+    // the same critical section as client_stats_update()
+    portENTER_CRITICAL(&linear_lock);
+    for (int i = 0; i < linear_used; i++) {
+        if (linear_top[i].addr == addr) {
+            linear_top[i].count++;
+            portEXIT_CRITICAL(&linear_lock);
+            return;
+        }
+        if (linear_top[i].count < linear_top[min].count) {
+            min = i;
+        }
+    }
+    if (linear_used < TOP_K) {
+        linear_top[linear_used++] = (client_stats_talker_t){.addr = addr, .count = 1};
+    } else {
+        linear_top[min].addr = addr;
+        linear_top[min].error = linear_top[min].count;
+        linear_top[min].count++;
+    }
+    portEXIT_CRITICAL(&linear_lock);
+}
+
+static void run(uint32_t sources) {
+    // two requests per background source
+    uint32_t requests = sources * 2 / 3 * 5;
+    int64_t start = test_clock_ns(CLOCK_MONOTONIC);
+    for (uint32_t r = 0; r < requests; r++) {
+        client_stats_update(source_of(r, sources), 6);
+    }
+    double ns = (double)(test_clock_ns(CLOCK_MONOTONIC) - start) / requests;
+
+    linear_used = 0;
+    start = test_clock_ns(CLOCK_MONOTONIC);
+    for (uint32_t r = 0; r < requests; r++) {
+        linear_update(source_of(r, sources));
+    }
+    double linear_ns = (double)(test_clock_ns(CLOCK_MONOTONIC) - start) / requests;
+
+    client_stats_report_t report;
+    client_stats_read(&report, true);
+    CHECK_EQ(report.requests, requests);
+    CHECK_EQ(report.poll_histogram[6], requests);
+    // each heavy hitter sends 10 % of the requests, more than 1/K, so space-saving must keep it
+    uint32_t heavy_requests[HEAVY_HITTERS] = {0};
+    for (uint32_t r = 0; r < requests; r++) {
+        if (r % 5 < 2) {
+            heavy_requests[source_of(r, sources) & 0xFF]++;
+        }
+    }
+    for (uint32_t h = 0; h < HEAVY_HITTERS; h++) {
+        bool found = false;
+        for (int i = 0; i < TOP_K; i++) {
+            if (report.top[i].addr == (0x0A000000 | h)) {
+                found = true;
+                CHECK(report.top[i].count >= heavy_requests[h]);
+                CHECK(report.top[i].count - report.top[i].error <= heavy_requests[h]);
+            }
+        }
+        CHECK(found);
+        CHECK_EQ(report.top[h].addr & 0xFFFFFF00, 0x0A000000);  // sorted, the heavy hitters come first
+    }
+    double error = ((double)report.distinct_clients - (sources + HEAVY_HITTERS)) / (sources + HEAVY_HITTERS);
+    printf("K=%d %9lu sources, %9lu requests: %5.1f ns/update (linear scan %5.1f ns), distinct estimate %lu "
+           "(%+.1f %%)\n",
+           TOP_K, (unsigned long)sources, (unsigned long)requests, ns, linear_ns,
+           (unsigned long)report.distinct_clients, 100 * error);
+    CHECK(error > -0.12 && error < 0.12);
+}
+
+int main(int argc, char **argv) {
+    uint32_t max_sources = argc > 1 ? strtoul(argv[1], NULL, 10) : 16000000;
+    for (uint32_t sources = 1000000; sources <= max_sources; sources *= 4) {
+        run(sources);
+    }
+    return 0;
+}
@@ -0,0 +1,260 @@
+// Microbenchmarks of the time critical functions: the clock reads of the NTP server, response assembly,
+// and the time code front end per bit (the two edges of one pulse) and per frame. Reports ns per operation and,
+// where perf_event_open() is permitted, instructions, cycles and cache misses per operation. The JSON output has
+// a fixed layout (keys in this order, null for unavailable counters), so runs of two commits can be diffed:
+//   {"format": 1, "perf_counters": true, "benchmarks": [
+//     {"name": "...", "iterations": N, "ns_per_op": x, "instructions_per_op": x, "cycles_per_op": x,
+//      "cache_misses_per_op": x}, ...]}
+//   bench_micro [--min-time-ms N] [--out file.json]
+
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "ntp_packet.h"
+#include "test_util.h"
+#include "timecode_formats.h"
+#include "timecode_rx.h"
+#include "timecode_synth.h"
+#include "udp_server_task.h"
+
+#define EDGE_MINUTES 16
+#define MAX_EDGES (EDGE_MINUTES * 61 * 4 + 16)
+
+time_t dcf77_last_sync(void) { return 1; }
+
+// perf counters of the calling thread, user space only: instructions (group leader), cycles, cache misses
+enum { COUNTER_INSTRUCTIONS, COUNTER_CYCLES, COUNTER_CACHE_MISSES, COUNTER_COUNT };
+static int counter_fd[COUNTER_COUNT] = {-1, -1, -1};
+
+static bool counters_open(void) {
+    static const uint64_t configs[COUNTER_COUNT] = {PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES,
+                                                    PERF_COUNT_HW_CACHE_MISSES};
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        struct perf_event_attr attr = {
+            .type = PERF_TYPE_HARDWARE,
+            .size = sizeof(attr),
+            .config = configs[i],
+            .disabled = i == 0,
+            .exclude_kernel = 1,
+            .exclude_hv = 1,
+            .read_format = PERF_FORMAT_GROUP,
+        };
+        counter_fd[i] = syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : counter_fd[0], 0);
+        if (counter_fd[i] < 0) {
+            for (int j = 0; j < i; j++) {
+                close(counter_fd[j]);
+                counter_fd[j] = -1;
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+static void counters_read(uint64_t values[COUNTER_COUNT]) {
+    struct {
+        uint64_t count;
+        uint64_t values[COUNTER_COUNT];
+    } group;
+    memset(values, 0, COUNTER_COUNT * sizeof(uint64_t));
+    if (counter_fd[0] >= 0 && read(counter_fd[0], &group, sizeof(group)) == sizeof(group)) {
+        memcpy(values, group.values, sizeof(group.values));
+    }
+}
+
+typedef void (*bench_fn)(uint64_t iterations);
+
+typedef struct {
+    const char *name;
+    bench_fn fn;
+} bench_t;
+
+static volatile uint64_t sink;
+
+static void bench_ntp64(uint64_t n) {
+    for (uint64_t i = 0; i < n; i++) {
+        sink += getCurrentTimeInNTP64BitFormat();
+    }
+}
+
+static void bench_time_struct(uint64_t n) {
+    for (uint64_t i = 0; i < n; i++) {
+        struct tm tm = getTimeStruct();
+        sink += tm.tm_min;
+    }
+}
+
+static void bench_epoch(uint64_t n) {
+    for (uint64_t i = 0; i < n; i++) {
+        sink += getEpoch();
+    }
+}
+
+static const ntp_server_info_t info = {.stratum = 1, .precision = -19, .root_dispersion = 0x50, .refid = 0x44434600};
+
+static void bench_build_response(uint64_t n) {
+    char packet[NTP_PACKET_SIZE] = {0x23};
+    for (uint64_t i = 0; i < n; i++) {
+        packet[0] = 0x23;
+        ntp_build_response(packet, 0b00011100, 4, &info, 0xE9A1B2C3D4E5F607ULL + i);
+        sink += (uint8_t)packet[47];
+    }
+}
+
+static void bench_respond(uint64_t n) {
+    char packet[NTP_PACKET_SIZE];
+    struct sockaddr_in source = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(0xC0000201)};
+    for (uint64_t i = 0; i < n; i++) {
+        memset(packet, 0, sizeof(packet));
+        packet[0] = 0x23;
+        sink += ntp_server_respond(packet, NTP_PACKET_SIZE, &source, 0xE9A1B2C3D4E5F607ULL + i);
+    }
+}
+
+// DCF77 edges of EDGE_MINUTES consecutive minutes, the receiver sees them as a continuous signal
+typedef struct {
+    uint64_t time_us;
+    bool active;
+} edge_t;
+
+static edge_t edges[MAX_EDGES];
+static int edge_count;
+static int edges_per_minute;
+static timecode_frame_t frame;
+
+static void collect_edge(void *ctx, uint64_t time_us, bool active) {
+    CHECK(edge_count < MAX_EDGES);
+    edges[edge_count++] = (edge_t){time_us, active};
+}
+
+static void edges_init(void) {
+    timecode_synth_t synth;
+    timecode_synth_init(&synth, &timecode_format_dcf77);
+    uint64_t t = 0;
+    for (int m = 0; m < EDGE_MINUTES; m++) {
+        t += timecode_synth_minute(&synth, 1711846620 + 60 * m, t, collect_edge, NULL);
+    }
+    edges_per_minute = edge_count / EDGE_MINUTES;
+    timecode_synth_frame(&synth, 1711846620, &frame);
+}
+
+// the next n edges through the receiver, a bit is the start and end edge of its pulse. The edges are replayed with a
+// growing time offset, so the receiver never sees a jump back.
+static void run_edges(uint64_t n_edges) {
+    static timecode_rx_t rx;
+    static int next;
+    static uint64_t offset;
+    static bool started;
+    if (!started) {
+        timecode_rx_init(&rx, &timecode_format_dcf77);
+        started = true;
+    }
+    for (uint64_t i = 0; i < n_edges; i++) {
+        timecode_time_t time;
+        uint64_t marker;
+        sink += timecode_rx_edge(&rx, edges[next].time_us + offset, edges[next].active, &time, &marker);
+        if (++next == edge_count) {
+            next = 0;
+            offset += edges[edge_count - 1].time_us + 1000000;
+        }
+    }
+}
+
+static void bench_dcf77_bit(uint64_t n) { run_edges(2 * n); }
+
+static void bench_dcf77_minute(uint64_t n) { run_edges(n * edges_per_minute); }
+
+static void bench_dcf77_frame_decode(uint64_t n) {
+    for (uint64_t i = 0; i < n; i++) {
+        timecode_time_t time;
+        sink += timecode_decode(&timecode_format_dcf77, &frame, &time);
+    }
+}
+
+static const bench_t benches[] = {
+    {"getCurrentTimeInNTP64BitFormat", bench_ntp64},
+    {"getTimeStruct", bench_time_struct},
+    {"getEpoch", bench_epoch},
+    {"ntp_build_response", bench_build_response},
+    {"ntp_server_respond", bench_respond},
+    {"dcf77_rx_bit", bench_dcf77_bit},
+    {"dcf77_rx_minute", bench_dcf77_minute},
+    {"dcf77_frame_decode", bench_dcf77_frame_decode},
+};
+
+static void print_per_op(FILE *out, const char *key, uint64_t value, uint64_t iterations, bool available,
+                         const char *end) {
+    if (available) {
+        fprintf(out, "\"%s\": %.2f%s", key, (double)value / iterations, end);
+    } else {
+        fprintf(out, "\"%s\": null%s", key, end);
+    }
+}
+
+int main(int argc, char **argv) {
+    int64_t min_time_ns = 200000000;
+    const char *out_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--min-time-ms") == 0 && i + 1 < argc) {
+            min_time_ns = atoll(argv[++i]) * 1000000;
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else {
+            fprintf(stderr, "usage: bench_micro [--min-time-ms N] [--out file.json]\n");
+            return 1;
+        }
+    }
+    FILE *out = out_path != NULL ? fopen(out_path, "w") : stdout;
+    CHECK(out != NULL);
+    edges_init();
+    bool perf = counters_open();
+    if (!perf) {
+        fprintf(stderr, "perf_event_open: %s, counters are null\n", strerror(errno));
+    }
+
+    fprintf(out, "{\"format\": 1, \"perf_counters\": %s, \"benchmarks\": [\n", perf ? "true" : "false");
+    size_t count = sizeof(benches) / sizeof(benches[0]);
+    for (size_t b = 0; b < count; b++) {
+        // warm up and find an iteration count that runs for at least the minimum time
+        uint64_t iterations = 16;
+        int64_t ns;
+        uint64_t before[COUNTER_COUNT], after[COUNTER_COUNT];
+        while (1) {
+            benches[b].fn(iterations);
+            counters_read(before);
+            if (perf) {
+                ioctl(counter_fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+            int64_t start = test_clock_ns(CLOCK_MONOTONIC);
+            benches[b].fn(iterations);
+            ns = test_clock_ns(CLOCK_MONOTONIC) - start;
+            if (perf) {
+                ioctl(counter_fd[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            }
+            counters_read(after);
+            if (ns >= min_time_ns || iterations >= (1ULL << 40)) {
+                break;
+            }
+            iterations *= ns > 0 && min_time_ns / ns < 8 ? 2 : 8;
+        }
+        CHECK(ns > 0);
+        fprintf(out, "  {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.2f, ", benches[b].name,
+                (unsigned long long)iterations, (double)ns / iterations);
+        print_per_op(out, "instructions_per_op", after[COUNTER_INSTRUCTIONS] - before[COUNTER_INSTRUCTIONS],
+                     iterations, perf, ", ");
+        print_per_op(out, "cycles_per_op", after[COUNTER_CYCLES] - before[COUNTER_CYCLES], iterations, perf, ", ");
+        print_per_op(out, "cache_misses_per_op", after[COUNTER_CACHE_MISSES] - before[COUNTER_CACHE_MISSES],
+                     iterations, perf, "");
+        fprintf(out, "}%s\n", b + 1 < count ? "," : "");
+    }
+    fprintf(out, "]}\n");
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
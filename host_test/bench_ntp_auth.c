@@ -0,0 +1,22 @@
+// Requests per second of the request path without MAC, with MD5 and with AES-CMAC, the same
+// ntp_auth_bench() the target runs at startup with CONFIG_NTP_SERVER_AUTH_BENCH.
+//   bench_ntp_auth [requests]
+
+#include <stdlib.h>
+
+#include "ntp_auth.h"
+#include "test_util.h"
+
+time_t dcf77_last_sync(void) { return 1; }
+
+int main(int argc, char **argv) {
+    uint32_t requests = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+    ntp_auth_bench_t bench;
+    CHECK(ntp_auth_bench(requests, &bench));
+    printf("requests/s: unauthenticated %lu, MD5 %lu (%.2fx), AES-CMAC %lu (%.2fx)\n",
+           (unsigned long)bench.unauthenticated_per_s, (unsigned long)bench.md5_per_s,
+           (double)bench.unauthenticated_per_s / bench.md5_per_s, (unsigned long)bench.aes_cmac_per_s,
+           (double)bench.unauthenticated_per_s / bench.aes_cmac_per_s);
+    CHECK(bench.unauthenticated_per_s > 0 && bench.md5_per_s > 0 && bench.aes_cmac_per_s > 0);
+    return 0;
+}
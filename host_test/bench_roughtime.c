@@ -0,0 +1,86 @@
+// Throughput of the Roughtime responder task on loopback against 1 to 64 concurrent clients, each
+// sending its next request as soon as the last one is answered. Every response is checked by roughtime_client.c.
+// Signatures per request fall as the load rises, because more requests share the signature of a batch.
+//   bench_roughtime [requests per client]
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "nvs.h"
+#include "roughtime.h"
+#include "roughtime_client.h"
+#include "sodium.h"
+#include "test_util.h"
+
+#define TIMEOUT_MS 1000
+#define MAX_CLIENTS 64
+
+static uint8_t pk[crypto_sign_PUBLICKEYBYTES];
+static int requests_per_client = 200;
+static atomic_int failures;
+
+time_t dcf77_last_sync(void) { return 1; }
+
+static void *client(void *arg) {
+    int sock = roughtime_client_socket(CONFIG_ROUGHTIME_PORT);
+    for (int i = 0; i < requests_per_client; i++) {
+        roughtime_reply_t reply;
+        roughtime_result_t result = roughtime_query(sock, pk, ROUGHTIME_MIN_REQUEST_SIZE, TIMEOUT_MS, &reply);
+        if (result != ROUGHTIME_OK && atomic_fetch_add(&failures, 1) < 5) {
+            fprintf(stderr, "roughtime: %s\n", roughtime_result_name(result));
+        }
+    }
+    close(sock);
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        requests_per_client = atoi(argv[1]);
+    }
+    uint8_t seed[crypto_sign_SEEDBYTES];
+    uint8_t sk[crypto_sign_SECRETKEYBYTES];
+    randombytes_buf(seed, sizeof(seed));
+    crypto_sign_seed_keypair(pk, sk, seed);
+    CHECK_EQ(host_nvs_set_blob("roughtime", "seed", seed, sizeof(seed)), ESP_OK);
+    xTaskCreatePinnedToCore(roughtime_task, "roughtime", 8192, NULL, 4, NULL, 1);
+    // the idle path delegates within a second
+    roughtime_stats_t before = {0};
+    for (int ms = 0; ms < 3000 && before.delegations == 0; ms += 10) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        roughtime_stats(&before);
+    }
+    CHECK_EQ(before.delegations, 1);
+
+    printf("clients,requests,requests_per_s,signatures_per_request\n");
+    double first_ratio = 0;
+    double ratio = 0;
+    for (int clients = 1; clients <= MAX_CLIENTS; clients *= 4) {
+        pthread_t threads[MAX_CLIENTS];
+        int64_t start = test_clock_ns(CLOCK_MONOTONIC);
+        for (int i = 0; i < clients; i++) {
+            pthread_create(&threads[i], NULL, client, NULL);
+        }
+        for (int i = 0; i < clients; i++) {
+            pthread_join(threads[i], NULL);
+        }
+        double seconds = (test_clock_ns(CLOCK_MONOTONIC) - start) / 1e9;
+        roughtime_stats_t after;
+        roughtime_stats(&after);
+        uint32_t requests = after.requests - before.requests;
+        ratio = (double)(after.signatures - before.signatures) / requests;
+        first_ratio = clients == 1 ? ratio : first_ratio;
+        printf("%d,%lu,%.0f,%.3f\n", clients, (unsigned long)requests, requests / seconds, ratio);
+        CHECK_EQ(requests, clients * requests_per_client);
+        before = after;
+    }
+    CHECK_EQ(failures, 0);
+    // one request at a time is signed at once, under load a batch shares the signature
+    CHECK(first_ratio > 0.9);
+    CHECK(ratio < first_ratio / 4);
+    return 0;
+}
@@ -0,0 +1,126 @@
+// Decode yield and time to sync of the receiver front end (the decoding logic of the dcf77 task) against
+// the level of each impairment: edge jitter, glitches, missing pulses, fades and receiver clock drift. Every run
+// starts cold at a random phase of a random minute in 2024-2026, so the rollovers and summer time changes are part
+// of the mix. One CSV line per impairment level, the curves to judge decoder changes by:
+//   format,impairment,level,yield_pct,wrong,invalid,tts_p50_s,tts_p90_s,never_synced
+// yield is the share of minutes decoded correctly, wrong counts valid frames with a wrong time, time to sync is
+// from the cold start to the end of the first correct frame (-1 if more than that share of the runs never synced).
+//   bench_timecode_yield [dcf77|msf|wwvb|jjy] [runs per level] [minutes per run]
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "test_util.h"
+#include "timecode_formats.h"
+#include "timecode_impair.h"
+
+#define FIRST_MINUTE 1704067200  // 2024-01-01
+#define SPAN_MINUTES (3 * 365 * 24 * 60)
+#define MAX_RUNS 1024
+
+typedef enum { JITTER, GLITCHES, DROPOUT, FADES, DRIFT } impairment_t;
+
+typedef struct {
+    impairment_t impairment;
+    const char *name;
+    double levels[8];
+    int level_count;
+} sweep_t;
+
+static const sweep_t sweeps[] = {
+    {JITTER, "jitter_us", {0, 10000, 20000, 40000, 60000, 80000, 100000}, 7},
+    {GLITCHES, "glitches_per_s", {0, 0.01, 0.03, 0.1, 0.3, 1, 3}, 7},
+    {DROPOUT, "dropout", {0, 0.001, 0.003, 0.01, 0.03, 0.1}, 6},
+    {FADES, "fades_per_hour_20s", {0, 1, 3, 10, 30, 60}, 6},
+    {DRIFT, "drift_ppm", {0, 1000, 10000, 30000, 60000, 100000}, 6},
+};
+
+static uint32_t random_state = 12345;
+
+static uint32_t next_random(void) {
+    random_state = random_state * 1664525 + 1013904223;
+    return random_state >> 8;
+}
+
+static const timecode_format_t *format_by_name(const char *name) {
+    static const timecode_format_t *formats[] = {&timecode_format_dcf77, &timecode_format_msf, &timecode_format_wwvb,
+                                                 &timecode_format_jjy};
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        if (strcasecmp(formats[i]->name, name) == 0) {
+            return formats[i];
+        }
+    }
+    return NULL;
+}
+
+static int compare_i64(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// p-th percentile in seconds, runs that never synchronized count as infinite
+static double percentile_s(const int64_t *sorted, int n, double p) {
+    int64_t v = sorted[(int)(p * (n - 1) + 0.5)];
+    return v == INT64_MAX ? -1 : v / 1e6;
+}
+
+int main(int argc, char **argv) {
+    const timecode_format_t *fmt = format_by_name(argc > 1 ? argv[1] : "dcf77");
+    int runs = argc > 2 ? atoi(argv[2]) : 50;
+    int minutes = argc > 3 ? atoi(argv[3]) : 30;
+    CHECK(fmt != NULL && runs > 0 && runs <= MAX_RUNS && minutes > 0);
+    timecode_synth_t synth;
+    timecode_synth_init(&synth, fmt);
+
+    printf("format,impairment,level,yield_pct,wrong,invalid,tts_p50_s,tts_p90_s,never_synced\n");
+    for (size_t s = 0; s < sizeof(sweeps) / sizeof(sweeps[0]); s++) {
+        const sweep_t *sweep = &sweeps[s];
+        for (int l = 0; l < sweep->level_count; l++) {
+            double level = sweep->levels[l];
+            int64_t tts[MAX_RUNS];
+            int correct = 0, wrong = 0, invalid = 0, never = 0;
+            random_state = 12345;  // the same starts for every level
+            for (int r = 0; r < runs; r++) {
+                timecode_impair_config_t config = {.fade_s = 20, .seed = r + 1};
+                switch (sweep->impairment) {
+                    case JITTER:
+                        config.jitter_us = (uint32_t)level;
+                        break;
+                    case GLITCHES:
+                        config.glitches_per_s = level;
+                        break;
+                    case DROPOUT:
+                        config.dropout = level;
+                        break;
+                    case FADES:
+                        config.fades_per_hour = level;
+                        break;
+                    case DRIFT:
+                        config.drift_ppm = level;
+                        break;
+                }
+                time_t first = FIRST_MINUTE + 60 * (time_t)(next_random() % SPAN_MINUTES);
+                // up to second 57, so the receiver can see the marker that starts the first counted minute
+                uint64_t offset = ((uint64_t)next_random() << 24 | next_random()) % 57000000;
+                timecode_impair_result_t result;
+                timecode_impair_run(&synth, &config, first, minutes, offset, &result);
+                correct += result.correct;
+                wrong += result.wrong;
+                invalid += result.invalid;
+                tts[r] = result.first_correct_us >= 0 ? result.first_correct_us : INT64_MAX;
+                never += result.first_correct_us < 0;
+            }
+            qsort(tts, runs, sizeof(tts[0]), compare_i64);
+            double yield = 100.0 * correct / ((double)runs * minutes);
+            printf("%s,%s,%g,%.1f,%d,%d,%.1f,%.1f,%d\n", fmt->name, sweep->name, level, yield, wrong, invalid,
+                   percentile_s(tts, runs, 0.5), percentile_s(tts, runs, 0.9), never);
+            // without impairment every minute decodes, and nothing decodes wrong
+            if (level == 0) {
+                CHECK_EQ(correct, runs * minutes);
+                CHECK_EQ(wrong, 0);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+// Runs the source selection and the upstream NTP client on a Linux host against local NTP servers, e.g. the chronyd
+// or ntpd instances of test_ntp_switchover.sh. The time code receiver is simulated: for the first radio seconds it
+// reports the system clock plus a bias every second, then it is lost. The selection corrects a virtual clock that
+// follows CLOCK_MONOTONIC, so the clock of the host is left alone. Prints the offset of the virtual clock to the
+// system clock and the system peer every second, and the switchover time and the largest phase change at the end.
+//   clock_select_runner <seconds> <radio seconds> <radio bias us>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "test_util.h"
+#include "time_source.h"
+#include "virtual_clock.h"
+
+#define RADIO_REFID 0x44434600  // "DCF"
+#define RADIO_TIMEOUT_US 10000000LL
+
+static virtual_clock_t vclock;
+static pthread_mutex_t clock_lock = PTHREAD_MUTEX_INITIALIZER;
+static int64_t start_us;
+
+// brings the virtual clock to the current CLOCK_MONOTONIC, call with clock_lock held
+static void follow(void) {
+    int64_t now = test_clock_ns(CLOCK_MONOTONIC) / 1000 - start_us;
+    if (now > vclock.monotonic_us) {
+        virtual_clock_advance(&vclock, now - vclock.monotonic_us);
+    }
+}
+
+static int64_t follow_monotonic_us(void *ctx) {
+    pthread_mutex_lock(&clock_lock);
+    follow();
+    int64_t t = vclock.monotonic_us;
+    pthread_mutex_unlock(&clock_lock);
+    return t;
+}
+
+static void follow_realtime(void *ctx, struct timeval *tv) {
+    pthread_mutex_lock(&clock_lock);
+    follow();
+    vclock.backend.realtime(&vclock, tv);
+    pthread_mutex_unlock(&clock_lock);
+}
+
+static void follow_step(void *ctx, int64_t offset_us) {
+    pthread_mutex_lock(&clock_lock);
+    follow();
+    vclock.backend.step(&vclock, offset_us);
+    pthread_mutex_unlock(&clock_lock);
+}
+
+static void follow_slew(void *ctx, int64_t offset_us) {
+    pthread_mutex_lock(&clock_lock);
+    follow();
+    vclock.backend.slew(&vclock, offset_us);
+    pthread_mutex_unlock(&clock_lock);
+}
+
+static int64_t follow_slew_remaining_us(void *ctx) {
+    pthread_mutex_lock(&clock_lock);
+    follow();
+    int64_t remaining = vclock.slew_remaining_us;
+    pthread_mutex_unlock(&clock_lock);
+    return remaining;
+}
+
+static const timebase_backend_t follow_backend = {
+    .monotonic_us = follow_monotonic_us,
+    .realtime = follow_realtime,
+    .step = follow_step,
+    .slew = follow_slew,
+    .slew_remaining_us = follow_slew_remaining_us,
+};
+
+// virtual clock - system clock
+static int64_t clock_offset_us(void) {
+    struct timeval tv;
+    timebase_realtime(&tv);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec - test_clock_ns(CLOCK_REALTIME) / 1000;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: clock_select_runner <seconds> <radio seconds> <radio bias us>\n");
+        return 1;
+    }
+    int seconds = atoi(argv[1]);
+    int radio_seconds = atoi(argv[2]);
+    int64_t radio_bias_us = atoll(argv[3]);
+
+    start_us = test_clock_ns(CLOCK_MONOTONIC) / 1000;
+    virtual_clock_init(&vclock, test_clock_ns(CLOCK_REALTIME) / 1000);
+    timebase_set_backend(&follow_backend);
+    xTaskCreatePinnedToCore(time_source_task, "time_source", 4096, NULL, 6, NULL, tskNO_AFFINITY);
+    usleep(100000);  // the task creates the report queue
+    xTaskCreatePinnedToCore(ntp_upstream_task, "ntp_upstream", 4096, NULL, 5, NULL, tskNO_AFFINITY);
+
+    int switchover_s = -1;
+    int64_t max_phase_change = 0, previous = clock_offset_us();
+    for (int s = 0; s < seconds; s++) {
+        if (s < radio_seconds) {
+            time_source_report_t report = {
+                .source = TIME_SOURCE_RADIO,
+                .stratum = 0,
+                .refid = RADIO_REFID,
+                .timeout_us = RADIO_TIMEOUT_US,
+                .sample =
+                    {
+                        .offset_us = radio_bias_us - clock_offset_us(),
+                        .dispersion_us = CONFIG_CLOCK_SELECT_RADIO_DISPERSION_US,
+                        .time_us = timebase_monotonic_us(),
+                    },
+            };
+            time_source_report(&report);
+        }
+        sleep(1);
+        time_source_status_t status;
+        time_source_status(&status);
+        int64_t offset = clock_offset_us();
+        int64_t change = llabs(offset - previous);
+        max_phase_change = change > max_phase_change ? change : max_phase_change;
+        previous = offset;
+        if (s >= radio_seconds && switchover_s < 0 && status.synchronized && status.refid != RADIO_REFID) {
+            switchover_s = s + 1 - radio_seconds;
+        }
+        printf("%4d refid %08lx stratum %2u offset %7lld us\n", s + 1, (unsigned long)status.refid, status.stratum,
+               (long long)offset);
+        fflush(stdout);
+    }
+    printf("switchover %d s after the last radio sample, max phase change %lld us/s, final offset %lld us\n",
+           switchover_s, (long long)max_phase_change, (long long)previous);
+    return switchover_s > 0 ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+// Runs the PTP grandmaster task on a Linux host, on the system clock, e.g. as master for ptp4l:
+//   ptp_runner [seconds] [--unsynced]
+// Without --unsynced the clock counts as set by DCF77 right now, so Announce carries class 6 and a valid UTC offset.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "ptp_server.h"
+
+static time_t last_sync;
+
+time_t dcf77_last_sync(void) { return last_sync; }
+
+int main(int argc, char **argv) {
+    int seconds = 0;
+    bool synced = true;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--unsynced") == 0) {
+            synced = false;
+        } else {
+            seconds = atoi(argv[i]);
+        }
+    }
+    last_sync = synced ? time(NULL) : 0;
+    xTaskCreatePinnedToCore(ptp_server_task, "ptp_server", 4096, NULL, 7, NULL, 1);
+    if (seconds > 0) {
+        sleep(seconds);
+        return 0;
+    }
+    while (1) {
+        pause();
+    }
+}
@@ -0,0 +1,155 @@
+#include "roughtime_client.h"
+
+#include <poll.h>
+#include <string.h>
+
+#include "lwip/sockets.h"
+#include "mbedtls/sha512.h"
+#include "sodium.h"
+#include "timebase.h"
+
+#define PAD_TAG ROUGHTIME_TAG('P', 'A', 'D', 0xff)
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t get_u64(const uint8_t *p) { return get_u32(p) | ((uint64_t)get_u32(p + 4) << 32); }
+
+// the client reads the clock the responder reads, a test backend moves both
+static uint64_t realtime_us(void) {
+    struct timeval tv;
+    timebase_realtime(&tv);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+// a fixed size value of a tag
+static bool find_exact(const uint8_t *msg, size_t length, uint32_t tag, const uint8_t **value, uint32_t size) {
+    uint32_t value_length;
+    return roughtime_find(msg, length, tag, value, &value_length) && value_length == size;
+}
+
+// the signed data is the context string including its zero, followed by the message
+static bool verify(const uint8_t *sig, const char *context, size_t context_size, const uint8_t *msg, uint32_t length,
+                   const uint8_t *pk) {
+    uint8_t data[64 + 1024];
+    if (context_size + length > sizeof(data)) {
+        return false;
+    }
+    memcpy(data, context, context_size);
+    memcpy(data + context_size, msg, length);
+    return crypto_sign_verify_detached(sig, data, context_size + length, pk) == 0;
+}
+
+int roughtime_client_socket(int port) {
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    if (sock >= 0 && connect(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+roughtime_result_t roughtime_query(int sock, const uint8_t *long_term_pk, size_t length, int timeout_ms,
+                                   roughtime_reply_t *reply) {
+    uint8_t nonce[ROUGHTIME_NONCE_SIZE];
+    static const uint8_t pad[ROUGHTIME_MIN_REQUEST_SIZE];
+    randombytes_buf(nonce, sizeof(nonce));
+    const roughtime_field_t fields[] = {
+        {ROUGHTIME_TAG_NONC, nonce, sizeof(nonce)},
+        {PAD_TAG, pad, length - 2 * 8 - sizeof(nonce)},
+    };
+    uint8_t request[ROUGHTIME_MIN_REQUEST_SIZE];
+    size_t request_length = roughtime_encode(fields, 2, request, sizeof(request));
+    // drop what a timed out query left behind
+    uint8_t response[ROUGHTIME_MIN_REQUEST_SIZE + 1];
+    while (recv(sock, response, sizeof(response), MSG_DONTWAIT) > 0) {
+    }
+    uint64_t sent = realtime_us();
+    send(sock, request, request_length, 0);
+    struct pollfd fd = {.fd = sock, .events = POLLIN};
+    if (poll(&fd, 1, timeout_ms) <= 0) {
+        return ROUGHTIME_NO_RESPONSE;
+    }
+    ssize_t n = recv(sock, response, sizeof(response), 0);
+    uint64_t received = realtime_us();
+    if (n <= 0 || (size_t)n > request_length) {
+        return ROUGHTIME_MALFORMED;
+    }
+    *reply = (roughtime_reply_t){.length = n};
+
+    const uint8_t *sig, *srep, *cert, *path, *indx;
+    uint32_t srep_length, cert_length, path_length;
+    if (!find_exact(response, n, ROUGHTIME_TAG_SIG, &sig, ROUGHTIME_SIG_SIZE) ||
+        !roughtime_find(response, n, ROUGHTIME_TAG_SREP, &srep, &srep_length) ||
+        !roughtime_find(response, n, ROUGHTIME_TAG_CERT, &cert, &cert_length) ||
+        !roughtime_find(response, n, ROUGHTIME_TAG_PATH, &path, &path_length) ||
+        !find_exact(response, n, ROUGHTIME_TAG_INDX, &indx, 4) || path_length % ROUGHTIME_HASH_SIZE != 0) {
+        return ROUGHTIME_MALFORMED;
+    }
+    memcpy(reply->sig, sig, sizeof(reply->sig));
+    reply->index = get_u32(indx);
+
+    const uint8_t *cert_sig, *dele, *online_pk, *mint, *maxt;
+    uint32_t dele_length;
+    if (!find_exact(cert, cert_length, ROUGHTIME_TAG_SIG, &cert_sig, ROUGHTIME_SIG_SIZE) ||
+        !roughtime_find(cert, cert_length, ROUGHTIME_TAG_DELE, &dele, &dele_length) ||
+        !find_exact(dele, dele_length, ROUGHTIME_TAG_PUBK, &online_pk, ROUGHTIME_PUBKEY_SIZE) ||
+        !find_exact(dele, dele_length, ROUGHTIME_TAG_MINT, &mint, 8) ||
+        !find_exact(dele, dele_length, ROUGHTIME_TAG_MAXT, &maxt, 8)) {
+        return ROUGHTIME_MALFORMED;
+    }
+    if (!verify(cert_sig, ROUGHTIME_DELEGATION_CONTEXT, sizeof(ROUGHTIME_DELEGATION_CONTEXT), dele, dele_length,
+                long_term_pk)) {
+        return ROUGHTIME_BAD_CERT;
+    }
+    if (!verify(sig, ROUGHTIME_RESPONSE_CONTEXT, sizeof(ROUGHTIME_RESPONSE_CONTEXT), srep, srep_length, online_pk)) {
+        return ROUGHTIME_BAD_SIGNATURE;
+    }
+
+    const uint8_t *root, *midp, *radi;
+    if (!find_exact(srep, srep_length, ROUGHTIME_TAG_ROOT, &root, ROUGHTIME_HASH_SIZE) ||
+        !find_exact(srep, srep_length, ROUGHTIME_TAG_MIDP, &midp, 8) ||
+        !find_exact(srep, srep_length, ROUGHTIME_TAG_RADI, &radi, 4)) {
+        return ROUGHTIME_MALFORMED;
+    }
+    // leaf: H(0x00 || nonce), node: H(0x01 || left || right), the index says on which side the path hash goes
+    uint8_t in[1 + 2 * ROUGHTIME_HASH_SIZE];
+    uint8_t hash[ROUGHTIME_HASH_SIZE];
+    in[0] = 0x00;
+    memcpy(&in[1], nonce, sizeof(nonce));
+    mbedtls_sha512(in, 1 + sizeof(nonce), hash, 0);
+    uint32_t index = reply->index;
+    for (uint32_t i = 0; i < path_length / ROUGHTIME_HASH_SIZE; i++, index /= 2) {
+        const uint8_t *sibling = path + i * ROUGHTIME_HASH_SIZE;
+        in[0] = 0x01;
+        memcpy(&in[1], index % 2 == 0 ? hash : sibling, ROUGHTIME_HASH_SIZE);
+        memcpy(&in[1 + ROUGHTIME_HASH_SIZE], index % 2 == 0 ? sibling : hash, ROUGHTIME_HASH_SIZE);
+        mbedtls_sha512(in, sizeof(in), hash, 0);
+    }
+    if (index != 0 || memcmp(hash, root, ROUGHTIME_HASH_SIZE) != 0) {
+        return ROUGHTIME_BAD_PATH;
+    }
+
+    reply->midpoint_us = get_u64(midp);
+    reply->radius_us = get_u32(radi);
+    reply->mint_us = get_u64(mint);
+    if (reply->midpoint_us < reply->mint_us || reply->midpoint_us > get_u64(maxt)) {
+        return ROUGHTIME_BAD_CERT;
+    }
+    if (reply->midpoint_us + reply->radius_us < sent || reply->midpoint_us > received + reply->radius_us) {
+        return ROUGHTIME_BAD_TIME;
+    }
+    return ROUGHTIME_OK;
+}
+
+const char *roughtime_result_name(roughtime_result_t result) {
+    static const char *names[] = {"ok", "no response", "malformed", "bad certificate", "bad signature", "bad path",
+                                  "bad time"};
+    return names[result];
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+// Roughtime client for the host tests of the responder: sends a padded request over UDP and checks the response
+// as a client would, the certificate against the long-term key, the response against the online key, the Merkle
+// path from the nonce to the signed root and the midpoint against the round trip.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "roughtime_wire.h"
+
+typedef enum {
+    ROUGHTIME_OK,
+    ROUGHTIME_NO_RESPONSE,
+    ROUGHTIME_MALFORMED,
+    ROUGHTIME_BAD_CERT,  // delegation signature, or the midpoint outside the delegation
+    ROUGHTIME_BAD_SIGNATURE,
+    ROUGHTIME_BAD_PATH,
+    ROUGHTIME_BAD_TIME,  // midpoint and radius do not overlap the round trip
+} roughtime_result_t;
+
+typedef struct {
+    uint64_t midpoint_us;
+    uint32_t radius_us;
+    uint64_t mint_us;
+    uint8_t sig[ROUGHTIME_SIG_SIZE];  // the same for all responses of a batch
+    uint32_t index;
+    uint32_t length;
+} roughtime_reply_t;
+
+// a UDP socket connected to 127.0.0.1:port
+int roughtime_client_socket(int port);
+
+// one request of length bytes (at least ROUGHTIME_MIN_REQUEST_SIZE for an answer), waits up to timeout_ms
+roughtime_result_t roughtime_query(int sock, const uint8_t *long_term_pk, size_t length, int timeout_ms,
+                                   roughtime_reply_t *reply);
+
+const char *roughtime_result_name(roughtime_result_t result);
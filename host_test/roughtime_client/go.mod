@@ -0,0 +1,3 @@
+module roughtime_client
+
+go 1.20
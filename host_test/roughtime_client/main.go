@@ -0,0 +1,254 @@
+// Reference Roughtime client (original Google protocol) for test_roughtime_client.sh, written from the protocol
+// description with the Go standard library only, so it shares no code with the responder. Every response is
+// verified: the delegation against the long-term key, the response against the online key, the Merkle path of
+// the nonce, the midpoint within the delegation and within the round trip. Prints one line per run:
+//
+//	clients <n>: <requests> requests, <signatures> signatures, <failures> failures, <rate>/s
+package main
+
+import (
+	"bytes"
+	"crypto/ed25519"
+	"crypto/rand"
+	"crypto/sha512"
+	"encoding/base64"
+	"encoding/binary"
+	"errors"
+	"flag"
+	"fmt"
+	"net"
+	"os"
+	"sync"
+	"time"
+)
+
+const requestSize = 1024
+
+func tag(s string) uint32 {
+	b := append([]byte(s), 0, 0, 0)
+	return binary.LittleEndian.Uint32(b[:4])
+}
+
+func parse(msg []byte) (map[uint32][]byte, error) {
+	if len(msg) < 4 || len(msg)%4 != 0 {
+		return nil, errors.New("message length")
+	}
+	n := int(binary.LittleEndian.Uint32(msg))
+	if n == 0 || 8*n > len(msg) {
+		return nil, errors.New("number of tags")
+	}
+	values := msg[8*n:]
+	fields := map[uint32][]byte{}
+	var prev uint32
+	for i := 0; i < n; i++ {
+		start, end := 0, len(values)
+		if i > 0 {
+			start = int(binary.LittleEndian.Uint32(msg[4*i:]))
+		}
+		if i < n-1 {
+			end = int(binary.LittleEndian.Uint32(msg[4*(i+1):]))
+		}
+		t := binary.LittleEndian.Uint32(msg[4*n+4*i:])
+		if (i > 0 && t <= prev) || start%4 != 0 || end < start || end > len(values) {
+			return nil, errors.New("header")
+		}
+		prev = t
+		fields[t] = values[start:end]
+	}
+	return fields, nil
+}
+
+func get(fields map[uint32][]byte, name string, size int) ([]byte, error) {
+	v, ok := fields[tag(name)]
+	if !ok || (size > 0 && len(v) != size) {
+		return nil, fmt.Errorf("missing or bad %s", name)
+	}
+	return v, nil
+}
+
+func request(nonce []byte) []byte {
+	var b bytes.Buffer
+	pad := make([]byte, requestSize-2*8-len(nonce))
+	binary.Write(&b, binary.LittleEndian, []uint32{2, uint32(len(nonce)), tag("NONC"), tag("PAD\xff")})
+	b.Write(nonce)
+	b.Write(pad)
+	return b.Bytes()
+}
+
+// returns the signature of the response, shared by all responses of a batch
+func query(conn *net.UDPConn, rootKey ed25519.PublicKey) ([]byte, error) {
+	nonce := make([]byte, 64)
+	rand.Read(nonce)
+	sent := time.Now()
+	if _, err := conn.Write(request(nonce)); err != nil {
+		return nil, err
+	}
+	conn.SetReadDeadline(sent.Add(time.Second))
+	buf := make([]byte, 2*requestSize)
+	n, err := conn.Read(buf)
+	received := time.Now()
+	if err != nil {
+		return nil, err
+	}
+	if n > requestSize {
+		return nil, errors.New("response larger than the request")
+	}
+	resp, err := parse(buf[:n])
+	if err != nil {
+		return nil, err
+	}
+	sig, err := get(resp, "SIG", 64)
+	if err != nil {
+		return nil, err
+	}
+	srepBytes, err := get(resp, "SREP", 0)
+	if err != nil {
+		return nil, err
+	}
+	certBytes, err := get(resp, "CERT", 0)
+	if err != nil {
+		return nil, err
+	}
+	path, err := get(resp, "PATH", 0)
+	if err != nil {
+		return nil, err
+	}
+	indx, err := get(resp, "INDX", 4)
+	if err != nil {
+		return nil, err
+	}
+
+	cert, err := parse(certBytes)
+	if err != nil {
+		return nil, err
+	}
+	certSig, err := get(cert, "SIG", 64)
+	if err != nil {
+		return nil, err
+	}
+	deleBytes, err := get(cert, "DELE", 0)
+	if err != nil {
+		return nil, err
+	}
+	if !ed25519.Verify(rootKey, append([]byte("RoughTime v1 delegation signature--\x00"), deleBytes...), certSig) {
+		return nil, errors.New("delegation signature")
+	}
+	dele, err := parse(deleBytes)
+	if err != nil {
+		return nil, err
+	}
+	onlineKey, err := get(dele, "PUBK", 32)
+	if err != nil {
+		return nil, err
+	}
+	if !ed25519.Verify(onlineKey, append([]byte("RoughTime v1 response signature\x00"), srepBytes...), sig) {
+		return nil, errors.New("response signature")
+	}
+
+	srep, err := parse(srepBytes)
+	if err != nil {
+		return nil, err
+	}
+	root, err := get(srep, "ROOT", 64)
+	if err != nil {
+		return nil, err
+	}
+	leaf := sha512.Sum512(append([]byte{0}, nonce...))
+	hash := leaf[:]
+	index := binary.LittleEndian.Uint32(indx)
+	if len(path)%64 != 0 {
+		return nil, errors.New("path length")
+	}
+	for ; len(path) > 0; path = path[64:] {
+		var node [64 * 2]byte
+		if index&1 == 0 {
+			copy(node[:64], hash)
+			copy(node[64:], path[:64])
+		} else {
+			copy(node[:64], path[:64])
+			copy(node[64:], hash)
+		}
+		h := sha512.Sum512(append([]byte{1}, node[:]...))
+		hash = h[:]
+		index >>= 1
+	}
+	if index != 0 || !bytes.Equal(hash, root) {
+		return nil, errors.New("merkle path")
+	}
+
+	fields := map[string]uint64{}
+	for name, m := range map[string]map[uint32][]byte{"MIDP": srep, "MINT": dele, "MAXT": dele} {
+		v, err := get(m, name, 8)
+		if err != nil {
+			return nil, err
+		}
+		fields[name] = binary.LittleEndian.Uint64(v)
+	}
+	radi, err := get(srep, "RADI", 4)
+	if err != nil {
+		return nil, err
+	}
+	midp, radius := int64(fields["MIDP"]), int64(binary.LittleEndian.Uint32(radi))
+	if fields["MIDP"] < fields["MINT"] || fields["MIDP"] > fields["MAXT"] {
+		return nil, errors.New("midpoint outside the delegation")
+	}
+	if midp+radius < sent.UnixMicro() || midp-radius > received.UnixMicro() {
+		return nil, fmt.Errorf("midpoint %d outside the round trip %d..%d", midp, sent.UnixMicro(), received.UnixMicro())
+	}
+	return sig, nil
+}
+
+func main() {
+	addr := flag.String("addr", "127.0.0.1:2002", "responder")
+	key := flag.String("key", "", "base64 long-term public key")
+	clients := flag.Int("clients", 1, "concurrent clients")
+	requests := flag.Int("requests", 100, "requests per client")
+	flag.Parse()
+	rootKey, err := base64.StdEncoding.DecodeString(*key)
+	if err != nil || len(rootKey) != ed25519.PublicKeySize {
+		fmt.Fprintln(os.Stderr, "bad -key")
+		os.Exit(2)
+	}
+	server, err := net.ResolveUDPAddr("udp", *addr)
+	if err != nil {
+		fmt.Fprintln(os.Stderr, err)
+		os.Exit(2)
+	}
+
+	var mu sync.Mutex
+	var wg sync.WaitGroup
+	signatures := map[string]bool{}
+	failures := 0
+	start := time.Now()
+	for c := 0; c < *clients; c++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			conn, err := net.DialUDP("udp", nil, server)
+			if err != nil {
+				mu.Lock()
+				failures += *requests
+				mu.Unlock()
+				return
+			}
+			defer conn.Close()
+			for i := 0; i < *requests; i++ {
+				sig, err := query(conn, rootKey)
+				mu.Lock()
+				if err != nil {
+					failures++
+					if failures <= 5 {
+						fmt.Fprintln(os.Stderr, "failed:", err)
+					}
+				} else {
+					signatures[string(sig)] = true
+				}
+				mu.Unlock()
+			}
+		}()
+	}
+	wg.Wait()
+	total := *clients * *requests
+	fmt.Printf("clients %d: %d requests, %d signatures, %d failures, %.0f/s\n", *clients, total, len(signatures),
+		failures, float64(total)/time.Since(start).Seconds())
+}
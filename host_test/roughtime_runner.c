@@ -0,0 +1,49 @@
+// Runs the Roughtime responder task on a Linux host, on the system clock synchronized right now, e.g. for a
+// reference client:
+//   roughtime_runner [seconds]
+// Prints the base64 long-term public key first, and the request and signature counts at the end.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "mbedtls/base64.h"
+#include "nvs.h"
+#include "roughtime.h"
+#include "sodium.h"
+
+static time_t last_sync;
+
+time_t dcf77_last_sync(void) { return last_sync; }
+
+int main(int argc, char **argv) {
+    int seconds = argc > 1 ? atoi(argv[1]) : 0;
+    uint8_t seed[crypto_sign_SEEDBYTES];
+    uint8_t pk[crypto_sign_PUBLICKEYBYTES];
+    uint8_t sk[crypto_sign_SECRETKEYBYTES];
+    randombytes_buf(seed, sizeof(seed));
+    crypto_sign_seed_keypair(pk, sk, seed);
+    host_nvs_set_blob("roughtime", "seed", seed, sizeof(seed));
+    unsigned char b64[48];
+    size_t b64_len;
+    mbedtls_base64_encode(b64, sizeof(b64), &b64_len, pk, sizeof(pk));
+    printf("%s\n", b64);
+    fflush(stdout);
+
+    last_sync = time(NULL);
+    xTaskCreatePinnedToCore(roughtime_task, "roughtime", 8192, NULL, 4, NULL, 1);
+    if (seconds == 0) {
+        while (1) {
+            pause();
+        }
+    }
+    sleep(seconds);
+    roughtime_stats_t stats;
+    roughtime_stats(&stats);
+    printf("%lu requests, %lu signatures, %lu dropped, %lu delegations\n", (unsigned long)stats.requests,
+           (unsigned long)stats.signatures, (unsigned long)stats.dropped, (unsigned long)stats.delegations);
+    return 0;
+}
@@ -0,0 +1,331 @@
+// A week of the server on a virtual clock, 2024-10-21 to 2024-10-28 across the end of summer time. The DCF77 edges
+// come from the synthesizer through mild receiver impairments into the receiver front end and the frame handling of
+// dcf77.c, a client sends a request every second. With CONFIG_CLOCK_SELECT an upstream server answers every 64 s
+// and the selection runs every 10 s, without it every frame steps the clock. The scenario has outages of the
+// receiver, of the upstream server and of both, a reboot and a power cycle that loses the system clock. Reports per
+// day the availability (responses without the alarm LI), the requests served, the offset of the transmit timestamps
+// to true time while a source is selected and the largest offset in holdover. Valid frames with a wrong time are
+// counted, there must be none.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dcf77_sync.h"
+#include "ntp_packet.h"
+#include "test_util.h"
+#include "timebase.h"
+#include "timecode_formats.h"
+#include "timecode_impair.h"
+#include "timecode_rx.h"
+#include "udp_server_task.h"
+#include "virtual_clock.h"
+
+#define FIRST_DAY 1729468800  // 2024-10-21 00:00 UTC
+#define DAYS 7
+#define DAY_S 86400
+#define HOUR_S 3600
+#define BOOT_US 1000000  // the device powers on 1 s before FIRST_DAY, the clock at 1970
+#define DRIFT_PPM 5.0
+#define MARKER_TOLERANCE_US 50000
+#define UPSTREAM_POLL_S 64
+#define SELECT_INTERVAL_S 10
+#define HOLDOVER_AFTER_S 120  // without clock selection, as the sync log counts it
+
+// requirements, checked at the end of the week
+#define MIN_AVAILABILITY_PCT 99.9
+#define MAX_OFFSET_P99_US 5000
+#if CONFIG_CLOCK_SELECT
+#define MAX_OFFSET_US 100000  // the drift over the longest holdover (3 h), slewed out after it
+#else
+#define MAX_OFFSET_US 150000  // the drift over the longest receiver outage (6 h)
+#endif
+
+typedef enum { RADIO_DOWN = 1, UPSTREAM_DOWN = 2, DEVICE_DOWN = 4, CLOCK_LOST = 8 } outage_t;
+
+typedef struct {
+    const char *name;
+    int start_s;  // since FIRST_DAY
+    int length_s;
+    int what;
+} event_t;
+
+static const event_t events[] = {
+    {"receiver outage 6 h", 1 * DAY_S + 12 * HOUR_S, 6 * HOUR_S, RADIO_DOWN},
+    {"upstream outage 2 h", 2 * DAY_S + 8 * HOUR_S, 2 * HOUR_S, UPSTREAM_DOWN},
+    {"receiver and upstream outage 3 h", 3 * DAY_S + 2 * HOUR_S, 3 * HOUR_S, RADIO_DOWN | UPSTREAM_DOWN},
+    {"reboot, 20 s", 4 * DAY_S + 10 * HOUR_S, 20, DEVICE_DOWN},
+    {"upstream outage 1 h", 5 * DAY_S + 13 * HOUR_S, HOUR_S, UPSTREAM_DOWN},
+    {"power cycle during it, 20 s", 5 * DAY_S + 13 * HOUR_S + 1200, 20, DEVICE_DOWN | CLOCK_LOST},
+};
+
+typedef struct {
+    int64_t up_s;
+    int64_t available_s;
+    int64_t holdover_s;
+    uint32_t served;
+    uint32_t unsynchronized;  // served with LI alarm
+    uint32_t steps;
+    int64_t holdover_max_ns;
+    int frames;
+    int frames_wrong;
+    int frames_invalid;
+    int offsets;
+} day_t;
+
+static virtual_clock_t vclock;
+static timecode_rx_t rx;
+static day_t days[DAYS];
+static int64_t offset_ns[DAYS][DAY_S];
+static int64_t next_tick_s;
+static bool device_up = false;
+static time_t last_sync = 0;
+
+time_t dcf77_last_sync(void) { return last_sync; }
+
+#if CONFIG_CLOCK_SELECT
+static uint32_t random_state = 1;
+
+// uniform in [-range, range]
+static int64_t noise(int64_t range) {
+    random_state = random_state * 1103515245 + 12345;
+    return (int64_t)((random_state >> 8) % (2 * range + 1)) - range;
+}
+#endif
+
+// the true time runs with the monotonic clock
+static int64_t true_us(void) { return (int64_t)FIRST_DAY * 1000000 + vclock.monotonic_us - BOOT_US; }
+
+static int64_t sim_s(void) { return (vclock.monotonic_us - BOOT_US) / 1000000; }
+
+static int outages(int64_t s) {
+    int what = 0;
+    for (size_t i = 0; i < sizeof(events) / sizeof(events[0]); i++) {
+        if (s >= events[i].start_s && s < events[i].start_s + events[i].length_s) {
+            what |= events[i].what;
+        }
+    }
+    return what;
+}
+
+static day_t *today(void) {
+    int64_t s = sim_s();
+    return &days[s < 0 ? 0 : s >= DAYS * DAY_S ? DAYS - 1 : s / DAY_S];
+}
+
+// a restart: selection and receiver start over, after a power cycle also the system clock
+static void boot(bool clock_lost) {
+    timecode_rx_init(&rx, &timecode_format_dcf77);
+    last_sync = 0;
+#if CONFIG_CLOCK_SELECT
+    time_source_reset();
+#endif
+    if (clock_lost) {
+        vclock.realtime_us = 0;
+        vclock.slew_remaining_us = 0;
+    }
+}
+
+#if CONFIG_CLOCK_SELECT
+static void report_upstream(void) {
+    int64_t delay = 2000 + noise(500);
+    time_source_report_t report = {
+        .source = TIME_SOURCE_UPSTREAM,
+        .stratum = 1,
+        .refid = 0xC0000201,
+        .root_delay_us = 1000,
+        .root_dispersion_us = 1000,
+        .timeout_us = 8LL * UPSTREAM_POLL_S * 1000000,
+        .sample =
+            {
+                .offset_us = true_us() - vclock.realtime_us + noise(delay / 4),
+                .delay_us = delay,
+                .dispersion_us = 1000,
+                .time_us = vclock.monotonic_us,
+            },
+    };
+    time_source_process(&report);
+}
+#endif
+
+// one client request, the offset is the transmit timestamp against true time
+static void client_request(int64_t s, bool holdover) {
+    char packet[NTP_PACKET_SIZE] = {0x23};
+    ntp_write_timestamp(&packet[40], 0xE9A1B2C300000000ULL + s);
+    struct sockaddr_in source = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(0x0A000000 + s % 65536)};
+    CHECK_EQ(ntp_server_respond(packet, NTP_PACKET_SIZE, &source, getCurrentTimeInNTP64BitFormat()), NTP_PACKET_SIZE);
+    day_t *day = today();
+    day->served++;
+    if ((uint8_t)packet[0] >> 6 == 3) {
+        day->unsynchronized++;
+        return;
+    }
+    uint64_t transmit = 0;
+    for (int i = 0; i < 8; i++) {
+        transmit = transmit << 8 | (uint8_t)packet[40 + i];
+    }
+    int64_t ns = llabs((int64_t)ntp_timestamp_to_ns(transmit) - true_us() * 1000);
+    if (!holdover) {
+        offset_ns[day - days][day->offsets++] = ns;
+    } else if (ns > day->holdover_max_ns) {
+        day->holdover_max_ns = ns;
+    }
+}
+
+// the work of second s: boot after a downtime, selection, upstream poll, a client request
+static void tick(int64_t s) {
+    int what = outages(s);
+    bool up = !(what & DEVICE_DOWN);
+    if (up && !device_up) {
+        boot(outages(s - 1) & CLOCK_LOST);
+    }
+    device_up = up;
+    if (!up || s >= DAYS * DAY_S) {
+        return;
+    }
+#if CONFIG_CLOCK_SELECT
+    if (s % SELECT_INTERVAL_S == 0) {
+        time_source_process(NULL);
+    }
+    if (s % UPSTREAM_POLL_S == 7 && !(what & UPSTREAM_DOWN)) {
+        report_upstream();
+    }
+    time_source_status_t status;
+    time_source_status(&status);
+    bool synchronized = status.synchronized;
+    bool holdover = status.holdover;
+#else
+    bool synchronized = last_sync != 0;
+    bool holdover = synchronized && vclock.realtime_us / 1000000 - last_sync > HOLDOVER_AFTER_S;
+#endif
+    client_request(s, holdover);
+    day_t *day = today();
+    day->up_s++;
+    day->available_s += synchronized;
+    day->holdover_s += holdover;
+}
+
+static void advance_to(int64_t monotonic_us) {
+    while (BOOT_US + next_tick_s * 1000000 <= monotonic_us) {
+        virtual_clock_advance(&vclock, BOOT_US + next_tick_s * 1000000 - vclock.monotonic_us);
+        tick(next_tick_s++);
+    }
+    virtual_clock_advance(&vclock, monotonic_us - vclock.monotonic_us);
+}
+
+// receiver output after the impairments, nothing while the receiver has no signal or the device is down
+static void rx_edge(void *ctx, uint64_t time_us, bool active) {
+    advance_to(time_us);
+    if (!device_up || (outages(sim_s()) & RADIO_DOWN)) {
+        return;
+    }
+    timecode_time_t time;
+    uint64_t marker_us;
+    timecode_rx_result_t r = timecode_rx_edge(&rx, time_us, active, &time, &marker_us);
+    day_t *day = today();
+    if (r == TC_RX_INVALID) {
+        day->frames_invalid++;
+    }
+    if (r != TC_RX_TIME) {
+        return;
+    }
+    // the marker against true time, then what dcf77.c does with the frame
+    int64_t utc_us = (int64_t)timecode_utc(&timecode_format_dcf77, &time) * 1000000;
+    int64_t marker_true_us = (int64_t)FIRST_DAY * 1000000 + (int64_t)marker_us - BOOT_US;
+    day->frames++;
+    if (llabs(utc_us - marker_true_us) > MARKER_TOLERANCE_US) {
+        day->frames_wrong++;
+    }
+    int64_t offset_us = dcf77_sync_offset_us(&timecode_format_dcf77, &time, vclock.monotonic_us - marker_us);
+#if CONFIG_CLOCK_SELECT
+    time_source_report_t report;
+    dcf77_sync_report(&timecode_format_dcf77, offset_us, &report);
+    time_source_process(&report);
+#else
+    timebase_step(offset_us);
+#endif
+    last_sync = utc_us / 1000000;
+}
+
+static int compare_i64(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+int main(void) {
+    virtual_clock_init(&vclock, 0);
+    vclock.drift_ppm = DRIFT_PPM;
+    virtual_clock_install(&vclock);
+    timecode_rx_init(&rx, &timecode_format_dcf77);
+    timecode_synth_t synth;
+    timecode_synth_init(&synth, &timecode_format_dcf77);
+    const timecode_impair_config_t config = {
+        .jitter_us = 3000, .glitches_per_s = 0.003, .fades_per_hour = 1, .fade_s = 20, .seed = 38};
+    timecode_impair_t impair;
+    timecode_impair_init(&impair, &config, rx_edge, NULL);
+
+#if CONFIG_CLOCK_SELECT
+    printf("scenario, day 0 is 2024-10-21 UTC, receiver and upstream server through the selection\n");
+#else
+    printf("scenario, day 0 is 2024-10-21 UTC, receiver only, every frame steps the clock\n");
+#endif
+    for (size_t i = 0; i < sizeof(events) / sizeof(events[0]); i++) {
+        printf("  day %d %02d:%02d UTC  %s\n", events[i].start_s / DAY_S, events[i].start_s % DAY_S / HOUR_S,
+               events[i].start_s % HOUR_S / 60, events[i].name);
+    }
+    printf("  day 6 01:00 UTC  end of summer time\n");
+
+    uint64_t start_us = BOOT_US;
+    timebase_corrections_t corrections = {0};
+    uint32_t steps = 0;
+    for (int m = 0; m < DAYS * DAY_S / 60; m++) {
+        start_us += timecode_synth_minute(&synth, FIRST_DAY + 60 * (time_t)m, start_us, timecode_impair_edge, &impair);
+        timebase_corrections(&corrections);
+        days[(m * 60) / DAY_S].steps += corrections.steps - steps;
+        steps = corrections.steps;
+    }
+    advance_to(BOOT_US + (int64_t)DAYS * DAY_S * 1000000);
+
+    printf("\nday  date        avail %%    served  unsync  |offset| p50 us  p99 us  max us  holdover s  max us  steps  "
+           "frames  wrong  invalid\n");
+    day_t week = {0};
+    static int64_t week_ns[DAYS * DAY_S];
+    for (int d = 0; d < DAYS; d++) {
+        day_t *day = &days[d];
+        char date[16];
+        strftime(date, sizeof(date), "%Y-%m-%d", gmtime(&(time_t){FIRST_DAY + d * DAY_S}));
+        memcpy(&week_ns[week.offsets], offset_ns[d], day->offsets * sizeof(int64_t));
+        qsort(offset_ns[d], day->offsets, sizeof(int64_t), compare_i64);
+        int n = day->offsets;
+        printf("%3d  %s  %7.3f  %8lu  %6lu  %15.1f  %6.1f  %6.1f  %10lld  %6.1f  %5lu  %6d  %5d  %7d\n", d, date,
+               100.0 * day->available_s / DAY_S, (unsigned long)day->served, (unsigned long)day->unsynchronized,
+               offset_ns[d][n / 2] / 1e3, offset_ns[d][n * 99 / 100] / 1e3, offset_ns[d][n - 1] / 1e3,
+               (long long)day->holdover_s, day->holdover_max_ns / 1e3, (unsigned long)day->steps, day->frames,
+               day->frames_wrong, day->frames_invalid);
+        week.available_s += day->available_s;
+        week.holdover_s += day->holdover_s;
+        if (day->holdover_max_ns > week.holdover_max_ns) {
+            week.holdover_max_ns = day->holdover_max_ns;
+        }
+        week.served += day->served;
+        week.unsynchronized += day->unsynchronized;
+        week.frames += day->frames;
+        week.frames_wrong += day->frames_wrong;
+        week.offsets += n;
+    }
+    qsort(week_ns, week.offsets, sizeof(int64_t), compare_i64);
+    double availability = 100.0 * week.available_s / (DAYS * DAY_S);
+    double p99_us = week_ns[week.offsets * 99 / 100] / 1e3;
+    double max_us = week_ns[week.offsets - 1] / 1e3;
+    printf("week: availability %.3f %%, %lu requests served, %lu unsynchronized, |offset| p50 %.1f us p99 %.1f us "
+           "max %.1f us, holdover %lld s up to %.1f us, %d frames, %d wrong\n",
+           availability, (unsigned long)week.served, (unsigned long)week.unsynchronized,
+           week_ns[week.offsets / 2] / 1e3, p99_us, max_us, (long long)week.holdover_s, week.holdover_max_ns / 1e3,
+           week.frames, week.frames_wrong);
+
+    CHECK(availability >= MIN_AVAILABILITY_PCT);
+    CHECK(p99_us <= MAX_OFFSET_P99_US);
+    CHECK(max_us <= MAX_OFFSET_US);
+    CHECK(week.holdover_max_ns <= MAX_OFFSET_US * 1000LL);
+    CHECK_EQ(week.frames_wrong, 0);
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+#include <string.h>
+
+#include "mbedtls/base64.h"
+#include "mbedtls/cmac.h"
+#include "mbedtls/sha512.h"
+#include "sodium.h"
+
+#define CMAC_SIZE 16
+
+// only AES-128 is supported, the info is a tag
+static const int aes_128_info;
+
+const mbedtls_cipher_info_t *mbedtls_cipher_info_from_type(mbedtls_cipher_type_t type) {
+    return type == MBEDTLS_CIPHER_AES_128_ECB ? (const mbedtls_cipher_info_t *)&aes_128_info : NULL;
+}
+
+void mbedtls_cipher_init(mbedtls_cipher_context_t *ctx) { memset(ctx, 0, sizeof(*ctx)); }
+
+int mbedtls_cipher_setup(mbedtls_cipher_context_t *ctx, const mbedtls_cipher_info_t *cipher_info) {
+    if (cipher_info == NULL) {
+        return -1;
+    }
+    EVP_MAC *mac = EVP_MAC_fetch(NULL, OSSL_MAC_NAME_CMAC, NULL);
+    ctx->cipher_info = cipher_info;
+    ctx->cmac_ctx = mac != NULL ? EVP_MAC_CTX_new(mac) : NULL;
+    EVP_MAC_free(mac);
+    return ctx->cmac_ctx != NULL ? 0 : -1;
+}
+
+void mbedtls_cipher_free(mbedtls_cipher_context_t *ctx) {
+    EVP_MAC_CTX_free(ctx->cmac_ctx);
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+int mbedtls_cipher_cmac_starts(mbedtls_cipher_context_t *ctx, const unsigned char *key, size_t keybits) {
+    OSSL_PARAM params[] = {OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_CIPHER, "AES-128-CBC", 0),
+                           OSSL_PARAM_construct_end()};
+    return keybits == 128 && EVP_MAC_init(ctx->cmac_ctx, key, keybits / 8, params) == 1 ? 0 : -1;
+}
+
+int mbedtls_cipher_cmac_update(mbedtls_cipher_context_t *ctx, const unsigned char *input, size_t ilen) {
+    return EVP_MAC_update(ctx->cmac_ctx, input, ilen) == 1 ? 0 : -1;
+}
+
+int mbedtls_cipher_cmac_finish(mbedtls_cipher_context_t *ctx, unsigned char *output) {
+    size_t len = 0;
+    return EVP_MAC_final(ctx->cmac_ctx, output, &len, CMAC_SIZE) == 1 ? 0 : -1;
+}
+
+// the key of mbedtls_cipher_cmac_starts() stays
+int mbedtls_cipher_cmac_reset(mbedtls_cipher_context_t *ctx) {
+    return EVP_MAC_init(ctx->cmac_ctx, NULL, 0, NULL) == 1 ? 0 : -1;
+}
+
+int sodium_init(void) { return 0; }
+
+void sodium_memzero(void *buf, size_t len) { OPENSSL_cleanse(buf, len); }
+
+void randombytes_buf(void *buf, size_t len) { RAND_bytes(buf, len); }
+
+int crypto_sign_seed_keypair(unsigned char *pk, unsigned char *sk, const unsigned char *seed) {
+    EVP_PKEY *key = EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, NULL, seed, crypto_sign_SEEDBYTES);
+    size_t len = crypto_sign_PUBLICKEYBYTES;
+    int ok = key != NULL && EVP_PKEY_get_raw_public_key(key, pk, &len) == 1;
+    EVP_PKEY_free(key);
+    memcpy(sk, seed, crypto_sign_SEEDBYTES);
+    memcpy(sk + crypto_sign_SEEDBYTES, pk, crypto_sign_PUBLICKEYBYTES);
+    return ok ? 0 : -1;
+}
+
+int crypto_sign_keypair(unsigned char *pk, unsigned char *sk) {
+    unsigned char seed[crypto_sign_SEEDBYTES];
+    randombytes_buf(seed, sizeof(seed));
+    int ret = crypto_sign_seed_keypair(pk, sk, seed);
+    sodium_memzero(seed, sizeof(seed));
+    return ret;
+}
+
+int crypto_sign_detached(unsigned char *sig, unsigned long long *siglen, const unsigned char *m,
+                         unsigned long long mlen, const unsigned char *sk) {
+    EVP_PKEY *key = EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, NULL, sk, crypto_sign_SEEDBYTES);
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    size_t len = crypto_sign_BYTES;
+    int ok = key != NULL && ctx != NULL && EVP_DigestSignInit(ctx, NULL, NULL, NULL, key) == 1 &&
+             EVP_DigestSign(ctx, sig, &len, m, mlen) == 1;
+    EVP_MD_CTX_free(ctx);
+    EVP_PKEY_free(key);
+    if (siglen != NULL) {
+        *siglen = len;
+    }
+    return ok ? 0 : -1;
+}
+
+int crypto_sign_verify_detached(const unsigned char *sig, const unsigned char *m, unsigned long long mlen,
+                                const unsigned char *pk) {
+    EVP_PKEY *key = EVP_PKEY_new_raw_public_key(EVP_PKEY_ED25519, NULL, pk, crypto_sign_PUBLICKEYBYTES);
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    int ok = key != NULL && ctx != NULL && EVP_DigestVerifyInit(ctx, NULL, NULL, NULL, key) == 1 &&
+             EVP_DigestVerify(ctx, sig, crypto_sign_BYTES, m, mlen) == 1;
+    EVP_MD_CTX_free(ctx);
+    EVP_PKEY_free(key);
+    return ok ? 0 : -1;
+}
+
+int mbedtls_sha512(const unsigned char *input, size_t ilen, unsigned char *output, int is384) {
+    if (is384) {
+        SHA384(input, ilen, output);
+    } else {
+        SHA512(input, ilen, output);
+    }
+    return 0;
+}
+
+int mbedtls_base64_encode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen) {
+    size_t needed = 4 * ((slen + 2) / 3);
+    if (dlen < needed + 1) {
+        *olen = needed + 1;
+        return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+    }
+    *olen = EVP_EncodeBlock(dst, src, slen);
+    return 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+// GPTimer counting CLOCK_MONOTONIC_RAW at the requested resolution, the ETM capture task (driver/gptimer_etm.h)
+// latches the count
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef struct gptimer *gptimer_handle_t;
+
+typedef enum {
+    GPTIMER_CLK_SRC_DEFAULT,
+} gptimer_clock_source_t;
+
+typedef enum {
+    GPTIMER_COUNT_DOWN,
+    GPTIMER_COUNT_UP,
+} gptimer_count_direction_t;
+
+typedef struct {
+    gptimer_clock_source_t clk_src;
+    gptimer_count_direction_t direction;
+    uint32_t resolution_hz;
+} gptimer_config_t;
+
+esp_err_t gptimer_new_timer(const gptimer_config_t *config, gptimer_handle_t *ret_timer);
+esp_err_t gptimer_get_resolution(gptimer_handle_t timer, uint32_t *out_resolution);
+esp_err_t gptimer_enable(gptimer_handle_t timer);
+esp_err_t gptimer_start(gptimer_handle_t timer);
+esp_err_t gptimer_get_raw_count(gptimer_handle_t timer, uint64_t *value);
+esp_err_t gptimer_get_captured_count(gptimer_handle_t timer, uint64_t *value);
@@ -0,0 +1,21 @@
+#pragma once
+
+// GPTimer tasks of the event task matrix, only the capture of the count is emulated
+
+#include "driver/gptimer.h"
+#include "esp_etm.h"
+
+typedef enum {
+    GPTIMER_ETM_TASK_START_COUNT,
+    GPTIMER_ETM_TASK_STOP_COUNT,
+    GPTIMER_ETM_TASK_EN_ALARM,
+    GPTIMER_ETM_TASK_RELOAD,
+    GPTIMER_ETM_TASK_CAPTURE,
+} gptimer_etm_task_type_t;
+
+typedef struct {
+    gptimer_etm_task_type_t task_type;
+} gptimer_etm_task_config_t;
+
+esp_err_t gptimer_new_etm_task(gptimer_handle_t timer, const gptimer_etm_task_config_t *config,
+                               esp_etm_task_handle_t *out_task);
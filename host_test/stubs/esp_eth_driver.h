@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef void *esp_eth_handle_t;
+
+// provided by the test that plays the driver
+esp_err_t esp_eth_update_input_path(esp_eth_handle_t hdl,
+                                    esp_err_t (*stack_input)(esp_eth_handle_t hdl, uint8_t *buffer, uint32_t length,
+                                                             void *priv),
+                                    void *priv);
@@ -0,0 +1,23 @@
+#pragma once
+
+// Event task matrix: a channel connects an event (GPIO edge) to a task (GPTimer capture) without the CPU. The host
+// test raises the GPIO edges with host_gpio_etm_edge() from driver/gpio_etm.h.
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef struct esp_etm_event *esp_etm_event_handle_t;
+typedef struct esp_etm_task *esp_etm_task_handle_t;
+typedef struct esp_etm_channel *esp_etm_channel_handle_t;
+
+typedef struct {
+    struct {
+        uint32_t allow_pd : 1;
+    } flags;
+} esp_etm_channel_config_t;
+
+esp_err_t esp_etm_new_channel(const esp_etm_channel_config_t *config, esp_etm_channel_handle_t *ret_chan);
+esp_err_t esp_etm_channel_connect(esp_etm_channel_handle_t chan, esp_etm_event_handle_t event,
+                                  esp_etm_task_handle_t task);
+esp_err_t esp_etm_channel_enable(esp_etm_channel_handle_t chan);
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdio.h>
+
+// errors and warnings go to stderr, info only if HOST_LOG_INFO is set in the environment, debug never
+extern int host_log_info;
+
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...)                                      \
+    do {                                                             \
+        if (host_log_info) {                                         \
+            fprintf(stderr, "I %s: " fmt "\n", tag, ##__VA_ARGS__);  \
+        }                                                            \
+    } while (0)
+#define ESP_LOGD(tag, fmt, ...) ((void)(tag))
+#define ESP_LOGV(tag, fmt, ...) ((void)(tag))
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "esp_err.h"
+
+typedef struct esp_netif_obj esp_netif_t;
+
+// provided by the test that plays the stack
+esp_err_t esp_netif_receive(esp_netif_t *esp_netif, void *buffer, size_t len, void *eb);
@@ -0,0 +1,42 @@
+#pragma once
+
+// In-memory flash partitions for the host tests with NOR semantics: an erase sets whole sectors to ones, a write can
+// only clear bits. host_partition_create() adds a partition, host_partition_tear_next_write() cuts the next write
+// short as a reset during the write would.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define HOST_PARTITION_SECTOR_SIZE 4096
+
+typedef enum {
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01,
+} esp_partition_type_t;
+
+typedef enum {
+    ESP_PARTITION_SUBTYPE_ANY = 0xff,
+} esp_partition_subtype_t;
+
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    uint32_t erase_size;
+    char label[17];
+} esp_partition_t;
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label);
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size);
+
+// a partition of erased flash, size a multiple of the sector size
+const esp_partition_t *host_partition_create(esp_partition_type_t type, int subtype, const char *label, size_t size);
+
+// the next write stops after this many bytes and fails
+void host_partition_tear_next_write(size_t bytes);
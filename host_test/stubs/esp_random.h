@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stddef.h>
+
+// from getrandom(), the hardware RNG on the target
+void esp_fill_random(void *buf, size_t len);
@@ -0,0 +1,7 @@
+#pragma once
+
+// CRC-32 of the ROM, the same result as zlib's crc32() for crc = 0
+
+#include <stdint.h>
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len);
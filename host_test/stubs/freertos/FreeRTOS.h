@@ -0,0 +1,40 @@
+#pragma once
+
+// FreeRTOS on POSIX threads: ticks are milliseconds of CLOCK_MONOTONIC, critical sections take one global
+// recursive mutex.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void *TaskHandle_t;
+typedef uint8_t StackType_t;  // stack sizes are in bytes on ESP-IDF
+typedef struct {
+    int unused;
+} StaticTask_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY 0xFFFFFFFFu
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+void host_critical_enter(void);
+void host_critical_exit(void);
+#define portENTER_CRITICAL(mux) ((void)(mux), host_critical_enter())
+#define portEXIT_CRITICAL(mux) ((void)(mux), host_critical_exit())
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux), host_critical_enter())
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux), host_critical_exit())
+#define portYIELD_FROM_ISR() ((void)0)
+#define xPortInIsrContext() 0
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void *);
+
+TickType_t xTaskGetTickCount(void);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t period);
+// ends the calling thread, its handle stays valid for host_task_deleted()
+void vTaskDelete(TaskHandle_t task);
+// starts a POSIX thread, stack size, priority and core are ignored
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                           UBaseType_t priority, StackType_t *stack_buffer, StaticTask_t *tcb,
+                                           BaseType_t core);
+// NULL on threads not started as a task
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+// abort on a deleted task, on the target its TCB may already be freed; the host reports half the stack as used
+char *pcTaskGetName(TaskHandle_t task);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+bool host_task_deleted(TaskHandle_t task);
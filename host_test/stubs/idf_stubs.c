@@ -0,0 +1,421 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/random.h>
+#include <time.h>
+
+#include "driver/gpio_etm.h"
+#include "driver/gptimer.h"
+#include "driver/gptimer_etm.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_random.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "newlib_string.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+int host_log_info = 0;
+
+__attribute__((constructor)) static void host_log_init(void) { host_log_info = getenv("HOST_LOG_INFO") != NULL; }
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:
+            return "ESP_OK";
+        case ESP_ERR_NO_MEM:
+            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:
+            return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:
+            return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:
+            return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:
+            return "ESP_ERR_NOT_FOUND";
+        default:
+            return "ESP_FAIL";
+    }
+}
+
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type) {
+    static const uint8_t host_mac[6] = {0x02, 0x00, 0x5E, 0x10, 0x00, 0x01};
+    for (int i = 0; i < 6; i++) {
+        mac[i] = host_mac[i];
+    }
+    return ESP_OK;
+}
+
+size_t strlcpy(char *dst, const char *src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) { return 0; }
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) { return 0; }
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler) { return ESP_OK; }
+
+void esp_fill_random(void *buf, size_t len) {
+    for (size_t done = 0; done < len;) {
+        ssize_t n = getrandom((uint8_t *)buf + done, len - done, 0);
+        done += n > 0 ? n : 0;
+    }
+}
+
+static pthread_mutex_t critical = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+void host_critical_enter(void) { pthread_mutex_lock(&critical); }
+
+void host_critical_exit(void) { pthread_mutex_unlock(&critical); }
+
+TickType_t xTaskGetTickCount(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (TickType_t)(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    struct timespec d = {.tv_sec = ticks / 1000, .tv_nsec = (ticks % 1000) * 1000000L};
+    nanosleep(&d, NULL);
+}
+
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t period) {
+    *previous_wake += period;
+    int32_t left = (int32_t)(*previous_wake - xTaskGetTickCount());
+    if (left > 0) {
+        vTaskDelay(left);
+    }
+}
+
+// a task handle points to this, it is never freed, so uses after vTaskDelete() can be detected
+typedef struct {
+    TaskFunction_t fn;
+    void *arg;
+    char name[16];
+    uint32_t stack;
+    volatile bool deleted;
+} host_task_t;
+
+static __thread host_task_t *current_task;
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == NULL) {
+        task = current_task;
+    }
+    if (task != NULL) {
+        ((host_task_t *)task)->deleted = true;
+    }
+    pthread_exit(NULL);
+}
+
+static void *host_task_run(void *p) {
+    current_task = p;
+    current_task->fn(current_task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core) {
+    host_task_t *task = calloc(1, sizeof(*task));
+    task->fn = fn;
+    task->arg = arg;
+    strlcpy(task->name, name, sizeof(task->name));
+    task->stack = stack;
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, host_task_run, task) != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(thread);
+    if (handle != NULL) {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                           UBaseType_t priority, StackType_t *stack_buffer, StaticTask_t *tcb,
+                                           BaseType_t core) {
+    TaskHandle_t handle = NULL;
+    xTaskCreatePinnedToCore(fn, name, stack, arg, priority, &handle, core);
+    return handle;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return current_task; }
+
+static host_task_t *host_task_alive(TaskHandle_t task, const char *call) {
+    if (((host_task_t *)task)->deleted) {
+        fprintf(stderr, "%s() on the deleted task %s\n", call, ((host_task_t *)task)->name);
+        abort();
+    }
+    return task;
+}
+
+char *pcTaskGetName(TaskHandle_t task) { return host_task_alive(task, "pcTaskGetName")->name; }
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    return host_task_alive(task, "uxTaskGetStackHighWaterMark")->stack / 2;
+}
+
+bool host_task_deleted(TaskHandle_t task) { return ((host_task_t *)task)->deleted; }
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t items[];
+};
+
+// absolute CLOCK_MONOTONIC deadline of a wait in ticks
+static struct timespec host_deadline(TickType_t wait) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    uint64_t ns = t.tv_nsec + (uint64_t)wait * 1000000;
+    t.tv_sec += ns / 1000000000;
+    t.tv_nsec = ns % 1000000000;
+    return t;
+}
+
+// waits until the condition changed, false on timeout
+static bool host_queue_wait(QueueHandle_t queue, TickType_t wait, const struct timespec *deadline) {
+    if (wait == 0) {
+        return false;
+    }
+    if (wait == portMAX_DELAY) {
+        pthread_cond_wait(&queue->changed, &queue->lock);
+        return true;
+    }
+    return pthread_cond_timedwait(&queue->changed, &queue->lock, deadline) == 0;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    QueueHandle_t queue = calloc(1, sizeof(*queue) + (size_t)length * item_size);
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&queue->changed, &attr);
+    pthread_condattr_destroy(&attr);
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait) {
+    struct timespec deadline = host_deadline(wait);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length) {
+        if (!host_queue_wait(queue, wait, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFALSE;
+        }
+    }
+    UBaseType_t tail = (queue->head + queue->count) % queue->length;
+    memcpy(&queue->items[tail * queue->item_size], item, queue->item_size);
+    queue->count++;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *higher_priority_task_woken) {
+    if (higher_priority_task_woken != NULL) {
+        *higher_priority_task_woken = pdFALSE;
+    }
+    return xQueueSend(queue, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait) {
+    struct timespec deadline = host_deadline(wait);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        if (!host_queue_wait(queue, wait, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFALSE;
+        }
+    }
+    memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+struct gptimer {
+    uint32_t resolution_hz;
+    _Atomic uint64_t captured;
+};
+
+esp_err_t gptimer_new_timer(const gptimer_config_t *config, gptimer_handle_t *ret_timer) {
+    struct gptimer *t = calloc(1, sizeof(*t));
+    t->resolution_hz = config->resolution_hz;
+    *ret_timer = t;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_get_resolution(gptimer_handle_t timer, uint32_t *out_resolution) {
+    *out_resolution = timer->resolution_hz;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_enable(gptimer_handle_t timer) { return ESP_OK; }
+
+esp_err_t gptimer_start(gptimer_handle_t timer) { return ESP_OK; }
+
+esp_err_t gptimer_get_raw_count(gptimer_handle_t timer, uint64_t *value) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    unsigned __int128 ns = (unsigned __int128)now.tv_sec * 1000000000 + now.tv_nsec;
+    *value = (uint64_t)(ns * timer->resolution_hz / 1000000000);
+    return ESP_OK;
+}
+
+esp_err_t gptimer_get_captured_count(gptimer_handle_t timer, uint64_t *value) {
+    *value = timer->captured;
+    return ESP_OK;
+}
+
+// ETM: GPIO edge events run the capture task of a GPTimer
+struct esp_etm_event {
+    gpio_etm_event_edge_t edge;
+    int gpio_num;
+};
+
+struct esp_etm_task {
+    gptimer_handle_t timer;
+};
+
+struct esp_etm_channel {
+    esp_etm_event_handle_t event;
+    esp_etm_task_handle_t task;
+    bool enabled;
+};
+
+#define HOST_ETM_CHANNELS 8
+
+static struct esp_etm_channel etm_channels[HOST_ETM_CHANNELS];
+static int etm_channel_count;
+
+esp_err_t gpio_new_etm_event(const gpio_etm_event_config_t *config, esp_etm_event_handle_t *ret_event) {
+    struct esp_etm_event *event = calloc(1, sizeof(*event));
+    event->edge = config->edge;
+    event->gpio_num = -1;
+    *ret_event = event;
+    return ESP_OK;
+}
+
+esp_err_t gpio_etm_event_bind_gpio(esp_etm_event_handle_t event, int gpio_num) {
+    event->gpio_num = gpio_num;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_new_etm_task(gptimer_handle_t timer, const gptimer_etm_task_config_t *config,
+                               esp_etm_task_handle_t *out_task) {
+    if (config->task_type != GPTIMER_ETM_TASK_CAPTURE) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    struct esp_etm_task *task = calloc(1, sizeof(*task));
+    task->timer = timer;
+    *out_task = task;
+    return ESP_OK;
+}
+
+esp_err_t esp_etm_new_channel(const esp_etm_channel_config_t *config, esp_etm_channel_handle_t *ret_chan) {
+    if (etm_channel_count == HOST_ETM_CHANNELS) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *ret_chan = &etm_channels[etm_channel_count++];
+    return ESP_OK;
+}
+
+esp_err_t esp_etm_channel_connect(esp_etm_channel_handle_t chan, esp_etm_event_handle_t event,
+                                  esp_etm_task_handle_t task) {
+    chan->event = event;
+    chan->task = task;
+    return ESP_OK;
+}
+
+esp_err_t esp_etm_channel_enable(esp_etm_channel_handle_t chan) {
+    chan->enabled = chan->event != NULL && chan->task != NULL;
+    return chan->enabled ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+void host_gpio_etm_edge(int gpio_num, bool rising) {
+    gpio_etm_event_edge_t edge = rising ? GPIO_ETM_EVENT_EDGE_POS : GPIO_ETM_EVENT_EDGE_NEG;
+    for (int i = 0; i < etm_channel_count; i++) {
+        struct esp_etm_channel *chan = &etm_channels[i];
+        if (chan->enabled && chan->event->gpio_num == gpio_num &&
+            (chan->event->edge == edge || chan->event->edge == GPIO_ETM_EVENT_EDGE_ANY)) {
+            uint64_t count;
+            gptimer_get_raw_count(chan->task->timer, &count);
+            chan->task->timer->captured = count;
+        }
+    }
+}
+
+struct esp_timer {
+    esp_timer_create_args_t args;
+    uint64_t period_us;
+    volatile int running;
+    pthread_t thread;
+};
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle) {
+    struct esp_timer *t = calloc(1, sizeof(*t));
+    t->args = *args;
+    *handle = t;
+    return ESP_OK;
+}
+
+static void *esp_timer_run(void *p) {
+    struct esp_timer *t = p;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (t->running) {
+        uint64_t ns = next.tv_nsec + t->period_us * 1000;
+        next.tv_sec += ns / 1000000000;
+        next.tv_nsec = ns % 1000000000;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        if (t->running) {
+            t->args.callback(t->args.arg);
+        }
+    }
+    return NULL;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+    timer->period_us = period_us;
+    timer->running = 1;
+    if (pthread_create(&timer->thread, NULL, esp_timer_run, timer) != 0) {
+        return ESP_FAIL;
+    }
+    pthread_detach(timer->thread);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    timer->running = 0;
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+// lwIP's BSD socket API is the POSIX one
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
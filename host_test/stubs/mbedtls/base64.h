@@ -0,0 +1,10 @@
+#pragma once
+
+// mbedtls base64 on OpenSSL (crypto_stub.c)
+
+#include <stddef.h>
+
+#define MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL -0x002A
+
+// writes the encoding and a terminating zero, *olen excludes the zero
+int mbedtls_base64_encode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen);
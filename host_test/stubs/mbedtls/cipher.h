@@ -0,0 +1,22 @@
+#pragma once
+
+// mbedtls cipher contexts on OpenSSL (crypto_stub.c), only what the AES-CMAC of the NTP MAC uses
+
+typedef enum {
+    MBEDTLS_CIPHER_AES_128_ECB = 2,
+} mbedtls_cipher_type_t;
+
+typedef struct mbedtls_cipher_info_t mbedtls_cipher_info_t;
+
+typedef struct {
+    const mbedtls_cipher_info_t *cipher_info;
+    void *cmac_ctx;  // EVP_MAC_CTX
+} mbedtls_cipher_context_t;
+
+const mbedtls_cipher_info_t *mbedtls_cipher_info_from_type(mbedtls_cipher_type_t type);
+
+void mbedtls_cipher_init(mbedtls_cipher_context_t *ctx);
+
+int mbedtls_cipher_setup(mbedtls_cipher_context_t *ctx, const mbedtls_cipher_info_t *cipher_info);
+
+void mbedtls_cipher_free(mbedtls_cipher_context_t *ctx);
@@ -0,0 +1,15 @@
+#pragma once
+
+// mbedtls CMAC on OpenSSL (crypto_stub.c)
+
+#include <stddef.h>
+
+#include "mbedtls/cipher.h"
+
+int mbedtls_cipher_cmac_starts(mbedtls_cipher_context_t *ctx, const unsigned char *key, size_t keybits);
+
+int mbedtls_cipher_cmac_update(mbedtls_cipher_context_t *ctx, const unsigned char *input, size_t ilen);
+
+int mbedtls_cipher_cmac_finish(mbedtls_cipher_context_t *ctx, unsigned char *output);
+
+int mbedtls_cipher_cmac_reset(mbedtls_cipher_context_t *ctx);
@@ -0,0 +1,7 @@
+#pragma once
+
+// mbedtls SHA-512 on OpenSSL (crypto_stub.c)
+
+#include <stddef.h>
+
+int mbedtls_sha512(const unsigned char *input, size_t ilen, unsigned char *output, int is384);
@@ -0,0 +1,7 @@
+#pragma once
+
+// newlib's string.h declares strlcpy(), glibc only from 2.38. Force included where the components use it.
+
+#include <string.h>
+
+size_t strlcpy(char *dst, const char *src, size_t size);
@@ -0,0 +1,146 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "nvs.h"
+
+#define HOST_NVS_ENTRIES 64
+#define HOST_NVS_BLOB_SIZE 64
+#define HOST_NVS_NAMESPACES 16
+
+typedef struct {
+    char namespace_name[NVS_KEY_NAME_MAX_SIZE];
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    uint8_t value[HOST_NVS_BLOB_SIZE];
+    size_t length;
+} host_nvs_entry_t;
+
+struct host_nvs_iterator {
+    int index;
+    char namespace_name[NVS_KEY_NAME_MAX_SIZE];
+};
+
+static host_nvs_entry_t entries[HOST_NVS_ENTRIES];
+static int entry_count;
+// a handle is the index of its namespace name + 1
+static char namespaces[HOST_NVS_NAMESPACES][NVS_KEY_NAME_MAX_SIZE];
+static int namespace_count;
+
+static host_nvs_entry_t *find(const char *namespace_name, const char *key) {
+    for (int i = 0; i < entry_count; i++) {
+        if (strcmp(entries[i].namespace_name, namespace_name) == 0 && strcmp(entries[i].key, key) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+static bool namespace_used(const char *namespace_name) {
+    for (int i = 0; i < entry_count; i++) {
+        if (strcmp(entries[i].namespace_name, namespace_name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t host_nvs_set_blob(const char *namespace_name, const char *key, const void *value, size_t length) {
+    if (length > HOST_NVS_BLOB_SIZE) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    host_nvs_entry_t *entry = find(namespace_name, key);
+    if (entry == NULL) {
+        if (entry_count == HOST_NVS_ENTRIES) {
+            return ESP_ERR_NO_MEM;
+        }
+        entry = &entries[entry_count++];
+        strncpy(entry->namespace_name, namespace_name, NVS_KEY_NAME_MAX_SIZE - 1);
+        strncpy(entry->key, key, NVS_KEY_NAME_MAX_SIZE - 1);
+    }
+    memcpy(entry->value, value, length);
+    entry->length = length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) {
+    if (open_mode == NVS_READONLY && !namespace_used(namespace_name)) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    for (int i = 0; i < namespace_count; i++) {
+        if (strcmp(namespaces[i], namespace_name) == 0) {
+            *out_handle = i + 1;
+            return ESP_OK;
+        }
+    }
+    if (namespace_count == HOST_NVS_NAMESPACES) {
+        return ESP_ERR_NO_MEM;
+    }
+    strncpy(namespaces[namespace_count], namespace_name, NVS_KEY_NAME_MAX_SIZE - 1);
+    *out_handle = ++namespace_count;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) {
+    host_nvs_entry_t *entry = find(namespaces[handle - 1], key);
+    if (entry == NULL) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (out_value == NULL) {
+        *length = entry->length;
+        return ESP_OK;
+    }
+    if (*length < entry->length) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out_value, entry->value, entry->length);
+    *length = entry->length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    return host_nvs_set_blob(namespaces[handle - 1], key, value, length);
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) { return ESP_OK; }
+
+static esp_err_t seek(nvs_iterator_t it) {
+    while (it->index < entry_count && strcmp(entries[it->index].namespace_name, it->namespace_name) != 0) {
+        it->index++;
+    }
+    return it->index < entry_count ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_entry_find(const char *part_name, const char *namespace_name, nvs_type_t type,
+                         nvs_iterator_t *output_iterator) {
+    nvs_iterator_t it = calloc(1, sizeof(*it));
+    strncpy(it->namespace_name, namespace_name, NVS_KEY_NAME_MAX_SIZE - 1);
+    if (seek(it) != ESP_OK) {
+        free(it);
+        *output_iterator = NULL;
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *output_iterator = it;
+    return ESP_OK;
+}
+
+esp_err_t nvs_entry_next(nvs_iterator_t *iterator) {
+    (*iterator)->index++;
+    if (seek(*iterator) != ESP_OK) {
+        free(*iterator);
+        *iterator = NULL;
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_entry_info(nvs_iterator_t iterator, nvs_entry_info_t *out_info) {
+    const host_nvs_entry_t *entry = &entries[iterator->index];
+    memset(out_info, 0, sizeof(*out_info));
+    strcpy(out_info->namespace_name, entry->namespace_name);
+    strcpy(out_info->key, entry->key);
+    out_info->type = NVS_TYPE_BLOB;
+    return ESP_OK;
+}
+
+void nvs_release_iterator(nvs_iterator_t iterator) { free(iterator); }
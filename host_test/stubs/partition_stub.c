@@ -0,0 +1,100 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+
+#define HOST_PARTITIONS 4
+
+typedef struct {
+    esp_partition_t partition;
+    uint8_t *data;
+} host_partition_t;
+
+static host_partition_t partitions[HOST_PARTITIONS];
+static int partition_count;
+static size_t tear_after = SIZE_MAX;
+
+static uint8_t *data_of(const esp_partition_t *partition, size_t offset, size_t size) {
+    for (int i = 0; i < partition_count; i++) {
+        if (&partitions[i].partition == partition) {
+            return offset + size <= partition->size ? partitions[i].data + offset : NULL;
+        }
+    }
+    return NULL;
+}
+
+const esp_partition_t *host_partition_create(esp_partition_type_t type, int subtype, const char *label, size_t size) {
+    if (partition_count == HOST_PARTITIONS || size % HOST_PARTITION_SECTOR_SIZE != 0) {
+        return NULL;
+    }
+    host_partition_t *p = &partitions[partition_count++];
+    p->partition = (esp_partition_t){
+        .type = type,
+        .subtype = (esp_partition_subtype_t)subtype,
+        .size = size,
+        .erase_size = HOST_PARTITION_SECTOR_SIZE,
+    };
+    strncpy(p->partition.label, label, sizeof(p->partition.label) - 1);
+    p->data = malloc(size);
+    memset(p->data, 0xFF, size);
+    return &p->partition;
+}
+
+void host_partition_tear_next_write(size_t bytes) { tear_after = bytes; }
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label) {
+    for (int i = 0; i < partition_count; i++) {
+        const esp_partition_t *p = &partitions[i].partition;
+        if (p->type == type && (subtype == ESP_PARTITION_SUBTYPE_ANY || p->subtype == subtype) &&
+            (label == NULL || strcmp(p->label, label) == 0)) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size) {
+    const uint8_t *data = data_of(partition, src_offset, size);
+    if (data == NULL) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, data, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size) {
+    uint8_t *data = data_of(partition, dst_offset, size);
+    if (data == NULL) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    bool torn = tear_after < size;
+    size_t n = torn ? tear_after : size;
+    tear_after = SIZE_MAX;
+    for (size_t i = 0; i < n; i++) {
+        data[i] &= ((const uint8_t *)src)[i];
+    }
+    return torn ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size) {
+    uint8_t *data = data_of(partition, offset, size);
+    if (data == NULL || offset % HOST_PARTITION_SECTOR_SIZE != 0 || size % HOST_PARTITION_SECTOR_SIZE != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(data, 0xFF, size);
+    return ESP_OK;
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len) {
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
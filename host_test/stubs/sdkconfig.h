@@ -0,0 +1,4 @@
+#pragma once
+
+// The host build sets the options of each target with target_compile_definitions() in host_test/CMakeLists.txt,
+// options not set there are disabled.
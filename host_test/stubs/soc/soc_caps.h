@@ -0,0 +1,3 @@
+#pragma once
+
+// no event task matrix on the host, frames are timestamped at stack input
@@ -0,0 +1,23 @@
+#pragma once
+
+// The part of libsodium the Roughtime responder uses, on OpenSSL's Ed25519 (crypto_stub.c). The secret key is the
+// seed followed by the public key, as in libsodium.
+
+#include <stddef.h>
+
+#define crypto_sign_SEEDBYTES 32
+#define crypto_sign_PUBLICKEYBYTES 32
+#define crypto_sign_SECRETKEYBYTES 64
+#define crypto_sign_BYTES 64
+
+int sodium_init(void);
+void sodium_memzero(void *buf, size_t len);
+void randombytes_buf(void *buf, size_t len);
+
+int crypto_sign_seed_keypair(unsigned char *pk, unsigned char *sk, const unsigned char *seed);
+int crypto_sign_keypair(unsigned char *pk, unsigned char *sk);
+int crypto_sign_detached(unsigned char *sig, unsigned long long *siglen, const unsigned char *m,
+                         unsigned long long mlen, const unsigned char *sk);
+// 0 if the signature is valid, -1 otherwise
+int crypto_sign_verify_detached(const unsigned char *sig, const unsigned char *m, unsigned long long mlen,
+                                const unsigned char *pk);
@@ -0,0 +1,194 @@
+// Source selection on a virtual clock.
+//   filter:     the clock filter takes the newest of samples with equal delay, e.g. the reference clock's.
+//   slew:       the stored offsets are moved when a slew is complete, not when it starts, so samples taken during
+//               the slew do not cause a second correction.
+//   switchover: a time code receiver, lost for an hour, and two upstream servers with a few ms of bias. Measures
+//               the time until the system peer changes in both directions, the largest phase change of the clock
+//               per second (continuity, no steps) and the offset to true time with each peer.
+//   test_clock_select filter|slew|switchover
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "time_source.h"
+#include "virtual_clock.h"
+
+#define START_US 1700000000000000LL
+#define RADIO_REFID 0x44434600  // "DCF"
+#define RADIO_TIMEOUT_US (10 * 60 * 1000000LL)
+#define RADIO_INTERVAL_S 60
+#define UPSTREAM_POLL_S 64
+#define SELECT_INTERVAL_S 10
+
+static virtual_clock_t vclock;
+
+static uint32_t random_state = 1;
+
+// uniform in [-range, range]
+static int64_t noise(int64_t range) {
+    random_state = random_state * 1103515245 + 12345;
+    return (int64_t)((random_state >> 8) % (2 * range + 1)) - range;
+}
+
+// the true time runs with the monotonic clock, the virtual realtime clock has drift and corrections
+static int64_t true_us(void) { return START_US + vclock.monotonic_us; }
+
+static int64_t clock_error_us(void) { return vclock.realtime_us - true_us(); }
+
+static void report_radio(int64_t error_us) {
+    time_source_report_t report = {
+        .source = TIME_SOURCE_RADIO,
+        .stratum = 0,
+        .refid = RADIO_REFID,
+        .timeout_us = RADIO_TIMEOUT_US,
+        .sample =
+            {
+                .offset_us = -clock_error_us() + error_us,
+                .dispersion_us = 5000,
+                .time_us = vclock.monotonic_us,
+            },
+    };
+    time_source_process(&report);
+}
+
+static void report_upstream(int n, int64_t bias_us) {
+    int64_t delay = 20000 + noise(5000);
+    time_source_report_t report = {
+        .source = TIME_SOURCE_UPSTREAM + n,
+        .stratum = 1,
+        .refid = 0xC0000201 + n,
+        .root_delay_us = 10000,
+        .root_dispersion_us = 5000,
+        .timeout_us = 8LL * UPSTREAM_POLL_S * 1000000,
+        .sample =
+            {
+                .offset_us = -clock_error_us() + bias_us + noise(delay / 20),
+                .delay_us = delay,
+                .dispersion_us = 1000,
+                .time_us = vclock.monotonic_us,
+            },
+    };
+    time_source_process(&report);
+}
+
+static void test_filter(void) {
+    clock_source_t source = {.stratum = 0, .timeout_us = RADIO_TIMEOUT_US};
+    clock_selection_t sel;
+    // more samples than the filter holds, so the newest one is not in slot 0
+    for (int i = 1; i <= CLOCK_FILTER_SIZE + 3; i++) {
+        clock_sample_t sample = {.offset_us = 1000 * i, .dispersion_us = 5000, .time_us = 60000000LL * i};
+        clock_source_add_sample(&source, &sample);
+        CHECK(clock_select(&source, 1, sample.time_us, &sel));
+        CHECK(llabs(sel.offset_us - sample.offset_us) <= 1);  // rounding of the weighted combine
+    }
+    // a lower delay still wins over a newer sample
+    clock_sample_t low = {.offset_us = -500, .delay_us = 100, .dispersion_us = 1000, .time_us = 1000000000};
+    clock_sample_t high = {.offset_us = 700, .delay_us = 200, .dispersion_us = 1000, .time_us = 1001000000};
+    clock_source_t upstream = {.stratum = 1, .timeout_us = RADIO_TIMEOUT_US};
+    clock_source_add_sample(&upstream, &low);
+    clock_source_add_sample(&upstream, &high);
+    CHECK(clock_select(&upstream, 1, high.time_us, &sel));
+    CHECK_EQ(sel.offset_us, low.offset_us);
+    printf("clock_select filter: ok\n");
+}
+
+static void test_slew(void) {
+    // 50 ms behind, the slew at 500 ppm takes 100 s, so the next frame arrives while it is in progress
+    virtual_clock_init(&vclock, START_US - 50000);
+    virtual_clock_install(&vclock);
+    int64_t ahead = 0;
+    for (int s = 0; s <= 1800; s++) {
+        if (s % RADIO_INTERVAL_S == 0) {
+            report_radio(0);
+        } else if (s % SELECT_INTERVAL_S == 0) {
+            time_source_process(NULL);
+        }
+        if (clock_error_us() > ahead) {
+            ahead = clock_error_us();
+        }
+        virtual_clock_advance(&vclock, 1000000);
+    }
+    timebase_corrections_t corrections;
+    timebase_corrections(&corrections);
+    printf("clock_select slew: error %lld us after 30 min, overshoot %lld us, %lu slews, %lld us corrected\n",
+           (long long)clock_error_us(), (long long)ahead, (unsigned long)corrections.slews,
+           (long long)corrections.total_us);
+    CHECK_EQ(corrections.steps, 0);
+    CHECK(llabs(clock_error_us()) < 10);
+    CHECK(ahead < 10);
+    CHECK(llabs(corrections.total_us - 50000) < 10);
+}
+
+static void test_switchover(void) {
+    const int radio_lost_s = 3600, radio_back_s = 7200, end_s = 9000;
+    const int64_t upstream_bias_us[2] = {3000, 4000};
+    virtual_clock_init(&vclock, START_US + 20000);
+    vclock.drift_ppm = 3;
+    virtual_clock_install(&vclock);
+
+    int switchover_s = -1, switchback_s = -1;
+    int64_t max_phase_change = 0, max_radio_error = 0, max_upstream_error = 0, previous_error = clock_error_us();
+    for (int s = 0; s < end_s; s++) {
+        bool radio = s < radio_lost_s || s >= radio_back_s;
+        if (radio && s % RADIO_INTERVAL_S == 0) {
+            report_radio(noise(1000));
+        } else if (s % UPSTREAM_POLL_S < 2) {
+            report_upstream(s % UPSTREAM_POLL_S, upstream_bias_us[s % UPSTREAM_POLL_S]);
+        } else if (s % SELECT_INTERVAL_S == 0) {
+            time_source_process(NULL);
+        }
+
+        time_source_status_t status;
+        time_source_status(&status);
+        if (s >= radio_lost_s && s < radio_back_s && switchover_s < 0 && status.refid != RADIO_REFID) {
+            switchover_s = s - (radio_lost_s - RADIO_INTERVAL_S);
+            CHECK_EQ(status.stratum, 2);
+        }
+        if (s >= radio_back_s && switchback_s < 0 && status.refid == RADIO_REFID) {
+            switchback_s = s - radio_back_s;
+            CHECK_EQ(status.stratum, 1);
+        }
+        // settled: 10 min after the start and after each change of the peer
+        int64_t error = llabs(clock_error_us());
+        if ((s >= 600 && s < radio_lost_s) || s >= radio_back_s + 600) {
+            max_radio_error = error > max_radio_error ? error : max_radio_error;
+        } else if (switchover_s >= 0 && s >= radio_lost_s + switchover_s + 600 && s < radio_back_s) {
+            max_upstream_error = error > max_upstream_error ? error : max_upstream_error;
+        }
+
+        virtual_clock_advance(&vclock, 1000000);
+        int64_t change = llabs(clock_error_us() - previous_error);
+        max_phase_change = change > max_phase_change ? change : max_phase_change;
+        previous_error = clock_error_us();
+    }
+    timebase_corrections_t corrections;
+    timebase_corrections(&corrections);
+    printf("clock_select switchover: to upstream %d s after the last frame, back %d s after the first, "
+           "max phase change %lld us/s, %lu steps, max error %lld us on the receiver, %lld us upstream\n",
+           switchover_s, switchback_s, (long long)max_phase_change, (unsigned long)corrections.steps,
+           (long long)max_radio_error, (long long)max_upstream_error);
+    CHECK(switchover_s > 0 && switchover_s <= RADIO_TIMEOUT_US / 1000000 + SELECT_INTERVAL_S);
+    CHECK(switchback_s >= 0 && switchback_s <= RADIO_INTERVAL_S);
+    // slewed at 500 ppm plus the drift, never stepped
+    CHECK_EQ(corrections.steps, 0);
+    CHECK(max_phase_change <= VIRTUAL_CLOCK_SLEW_PPM + 4);
+    // the combine also weights in the upstream servers, about 1/4 of their bias
+    CHECK(max_radio_error < 3000);
+    CHECK(max_upstream_error < 6000);
+}
+
+int main(int argc, char **argv) {
+    const char *test = argc > 1 ? argv[1] : "";
+    if (strcmp(test, "filter") == 0) {
+        test_filter();
+    } else if (strcmp(test, "slew") == 0) {
+        test_slew();
+    } else if (strcmp(test, "switchover") == 0) {
+        test_switchover();
+    } else {
+        fprintf(stderr, "usage: test_clock_select filter|slew|switchover\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,204 @@
+// NTP receive timestamps taken by the Ethernet input hook, with this test as the driver and the stack.
+// The driver passes request frames to the hook, the stack hands them to a server task after a random delay (lwIP,
+// socket and task wake-up) and the server answers with ntp_server_respond(). The receive timestamp of each
+// response is compared with the time the driver passed the frame on, and with the timestamp the server took
+// itself: the hook must cut the error by at least ten times. Bursts up to the ring length are matched in full,
+// longer bursts are counted as overwritten.
+
+#include <string.h>
+
+#include "esp_eth_driver.h"
+#include "esp_netif.h"
+#include "eth_rx_timestamp.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "ntp_packet.h"
+#include "test_util.h"
+#include "timebase_hires.h"
+#include "udp_server_task.h"
+
+#define RING_LEN CONFIG_EXAMPLE_ETH_RX_NTP_RING_LEN
+#define FRAME_LEN ETH_NTP_FRAME_MIN_LEN
+#define REQUESTS 400
+#define STACK_DELAY_MIN_US 50
+#define STACK_DELAY_MAX_US 1000
+
+time_t dcf77_last_sync(void) { return 1; }
+
+// what the stack hands to the server: the frame and, for the test only, when the driver passed it on
+typedef struct {
+    uint8_t frame[FRAME_LEN];
+    uint64_t arrival_ns;
+} stack_item_t;
+
+static esp_err_t (*hook)(esp_eth_handle_t, uint8_t *, uint32_t, void *);
+static void *hook_priv;
+static QueueHandle_t stack_queue;
+static uint64_t current_arrival_ns;
+static volatile bool server_slow = false;
+
+esp_err_t esp_eth_update_input_path(esp_eth_handle_t hdl,
+                                    esp_err_t (*stack_input)(esp_eth_handle_t hdl, uint8_t *buffer, uint32_t length,
+                                                             void *priv),
+                                    void *priv) {
+    hook = stack_input;
+    hook_priv = priv;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_receive(esp_netif_t *esp_netif, void *buffer, size_t len, void *eb) {
+    stack_item_t item = {.arrival_ns = current_arrival_ns};
+    CHECK_EQ(len, FRAME_LEN);
+    memcpy(item.frame, buffer, FRAME_LEN);
+    CHECK(xQueueSend(stack_queue, &item, portMAX_DELAY) == pdTRUE);
+    return ESP_OK;
+}
+
+// the driver: an untagged IPv4/UDP frame to port 123, the transmit timestamp makes each request unique
+static void driver_receive(uint32_t sequence, bool vlan) {
+    uint8_t frame[FRAME_LEN] = {0};
+    frame[ETH_NTP_FRAME_ETHERTYPE] = vlan ? 0x81 : 0x08;
+    uint8_t *ip = &frame[ETH_NTP_FRAME_IP];
+    ip[0] = 0x45;
+    ip[9] = 17;
+    ip[12] = 192;
+    ip[13] = 0;
+    ip[14] = 2;
+    ip[15] = 1 + sequence % 200;
+    uint8_t *udp = &frame[ETH_NTP_FRAME_UDP];
+    udp[0] = 0xC0 | (sequence >> 8 & 0x3F);
+    udp[1] = sequence & 0xFF;
+    udp[3] = 123;
+    frame[ETH_NTP_FRAME_NTP] = 0x23;
+    ntp_write_timestamp((char *)&frame[ETH_NTP_FRAME_XMT], 0xE9A1B2C300000000ULL + sequence);
+    current_arrival_ns = timebase_hires_realtime_ns();
+    CHECK(hook(NULL, frame, FRAME_LEN, hook_priv) == ESP_OK);
+}
+
+static uint32_t random_state = 1;
+
+static uint32_t next_random(void) {
+    random_state = random_state * 1664525 + 1013904223;
+    return random_state >> 8;
+}
+
+static int64_t server_error_ns[REQUESTS + 4 * RING_LEN];
+static int64_t hook_error_ns[REQUESTS + 4 * RING_LEN];
+static volatile int answered = 0;
+
+static uint64_t read_timestamp(const char *p) {
+    uint64_t t = 0;
+    for (int i = 0; i < 8; i++) {
+        t = t << 8 | (uint8_t)p[i];
+    }
+    return t;
+}
+
+// the server after the stack: recvfrom() returns, the server takes its timestamp and answers
+static void server_task(void *arg) {
+    while (1) {
+        stack_item_t item;
+        xQueueReceive(stack_queue, &item, portMAX_DELAY);
+        uint32_t delay_us = STACK_DELAY_MIN_US + next_random() % (STACK_DELAY_MAX_US - STACK_DELAY_MIN_US);
+        struct timespec d = {.tv_nsec = (server_slow ? 20 : 1) * delay_us * 1000L};
+        nanosleep(&d, NULL);
+        uint64_t receive_time = getCurrentTimeInNTP64BitFormat();
+
+        char packet[NTP_PACKET_SIZE];
+        memcpy(packet, &item.frame[ETH_NTP_FRAME_NTP], NTP_PACKET_SIZE);
+        struct sockaddr_in source = {.sin_family = AF_INET};
+        memcpy(&source.sin_addr.s_addr, &item.frame[ETH_NTP_FRAME_IP + 12], 4);
+        memcpy(&source.sin_port, &item.frame[ETH_NTP_FRAME_UDP], 2);
+        CHECK_EQ(ntp_server_respond(packet, NTP_PACKET_SIZE, &source, receive_time), NTP_PACKET_SIZE);
+
+        int n = answered;
+        server_error_ns[n] = (int64_t)(ntp_timestamp_to_ns(receive_time) - item.arrival_ns);
+        hook_error_ns[n] = (int64_t)(ntp_timestamp_to_ns(read_timestamp(&packet[32])) - item.arrival_ns);
+        answered = n + 1;
+    }
+}
+
+static void wait_answered(int n) {
+    for (int i = 0; i < 10000 && answered < n; i++) {
+        vTaskDelay(1);
+    }
+    CHECK_EQ(answered, n);
+}
+
+static int compare_i64(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// absolute errors sorted, p50, p99 and max in microseconds
+static void summary(const char *name, int64_t *error_ns, int n, double *p50_us, double *p99_us) {
+    for (int i = 0; i < n; i++) {
+        error_ns[i] = llabs(error_ns[i]);
+    }
+    qsort(error_ns, n, sizeof(error_ns[0]), compare_i64);
+    *p50_us = error_ns[n / 2] / 1e3;
+    *p99_us = error_ns[n * 99 / 100] / 1e3;
+    printf("%-18s receive timestamp error p50 %8.1f us  p99 %8.1f us  max %8.1f us\n", name, *p50_us, *p99_us,
+           error_ns[n - 1] / 1e3);
+}
+
+int main(void) {
+    stack_queue = xQueueCreate(2 * RING_LEN, sizeof(stack_item_t));
+    CHECK(eth_rx_timestamp_register(NULL, -1) == ESP_OK);
+    CHECK(eth_rx_timestamp_attach(NULL, NULL) == ESP_OK);
+    CHECK(hook != NULL);
+    CHECK(xTaskCreatePinnedToCore(server_task, "udp_server", 4096, NULL, 5, NULL, 1) == pdPASS);
+
+    // one request at a time, the server is idle when it arrives
+    uint32_t sequence = 0;
+    for (int i = 0; i < REQUESTS; i++) {
+        driver_receive(sequence++, false);
+        wait_answered(i + 1);
+    }
+    eth_rx_ntp_stats_t stats;
+    eth_rx_ntp_stats_get(&stats);
+    CHECK_EQ(stats.matched, REQUESTS);
+    CHECK_EQ(stats.missed, 0);
+    double server_p50, server_p99, hook_p50, hook_p99;
+    summary("server timestamp", server_error_ns, REQUESTS, &server_p50, &server_p99);
+    summary("input hook", hook_error_ns, REQUESTS, &hook_p50, &hook_p99);
+    CHECK(hook_p50 * 10 < server_p50);
+    CHECK(hook_p99 * 10 < server_p99);
+
+    // a burst of the ring length while the server is slow: every request keeps its hook timestamp
+    server_slow = true;
+    answered = 0;
+    for (int i = 0; i < RING_LEN; i++) {
+        driver_receive(sequence++, false);
+    }
+    wait_answered(RING_LEN);
+    eth_rx_ntp_stats_get(&stats);
+    CHECK_EQ(stats.matched, REQUESTS + RING_LEN);
+    CHECK_EQ(stats.overwritten, 0);
+    summary("burst, input hook", hook_error_ns, RING_LEN, &hook_p50, &hook_p99);
+    CHECK(hook_p99 < STACK_DELAY_MIN_US);
+
+    // 8 more than the ring holds: the oldest 8 are overwritten and get the server timestamp
+    answered = 0;
+    for (int i = 0; i < RING_LEN + 8; i++) {
+        driver_receive(sequence++, false);
+    }
+    wait_answered(RING_LEN + 8);
+    eth_rx_ntp_stats_get(&stats);
+    CHECK_EQ(stats.overwritten, 8);
+    CHECK_EQ(stats.missed, 8);
+    CHECK_EQ(stats.matched, REQUESTS + 2 * RING_LEN);
+
+    // a VLAN tagged request is not matched by the hook
+    server_slow = false;
+    answered = 0;
+    driver_receive(sequence++, true);
+    wait_answered(1);
+    eth_rx_ntp_stats_get(&stats);
+    CHECK_EQ(stats.missed, 9);
+    CHECK_EQ(hook_error_ns[0], server_error_ns[0]);
+    printf("eth_rx_timestamp: %lu matched, %lu missed, %lu overwritten with a ring of %d\n",
+           (unsigned long)stats.matched, (unsigned long)stats.missed, (unsigned long)stats.overwritten, RING_LEN);
+    return 0;
+}
@@ -0,0 +1,162 @@
+// The low-latency RX mode of SPI Ethernet modules, with this test as the module, the driver and the stack.
+// The module pulls its INT line low, the ETM latches the 1 MHz GPTimer, and the driver reads the frame after a random
+// delay (SPI transfer, RX task wake-up). The NTP arrival time of the first frame after an INT edge must be the time
+// of the edge, not of the stack input. Later frames of the same burst and frames of a module without a latched INT
+// line keep the stack input time. The INT to stack input latency statistics must match the delays of the test.
+
+#include <string.h>
+
+#include "driver/gpio_etm.h"
+#include "esp_eth_driver.h"
+#include "esp_netif.h"
+#include "eth_rx_timestamp.h"
+#include "test_util.h"
+#include "timebase_hires.h"
+
+#define INT_GPIO 4
+#define FRAMES 300
+#define DELAY_MIN_US 100
+#define DELAY_MAX_US 2000
+#define MAX_EDGE_ERROR_US 20  // timer resolution and the clock reads around the edge, on a busy host
+#define BURST 3
+
+static esp_err_t (*hooks[2])(esp_eth_handle_t, uint8_t *, uint32_t, void *);
+static void *hook_privs[2];
+static uint32_t stack_frames;
+
+esp_err_t esp_eth_update_input_path(esp_eth_handle_t hdl,
+                                    esp_err_t (*stack_input)(esp_eth_handle_t hdl, uint8_t *buffer, uint32_t length,
+                                                             void *priv),
+                                    void *priv) {
+    int port = (int)(intptr_t)hdl;
+    hooks[port] = stack_input;
+    hook_privs[port] = priv;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_receive(esp_netif_t *esp_netif, void *buffer, size_t len, void *eb) {
+    stack_frames++;
+    return ESP_OK;
+}
+
+static uint32_t random_state = 1;
+
+static uint32_t next_random(void) {
+    random_state = random_state * 1664525 + 1013904223;
+    return random_state >> 8;
+}
+
+static void spin_us(int64_t us) {
+    int64_t until = test_clock_ns(CLOCK_MONOTONIC) + us * 1000;
+    while (test_clock_ns(CLOCK_MONOTONIC) < until) {
+    }
+}
+
+// the driver hands an NTP request to the hook, returns when it did
+static uint64_t driver_receive(int port, uint32_t sequence, eth_ntp_frame_key_t *key) {
+    uint8_t frame[ETH_NTP_FRAME_MIN_LEN] = {0};
+    frame[ETH_NTP_FRAME_ETHERTYPE] = 0x08;
+    frame[ETH_NTP_FRAME_IP] = 0x45;
+    frame[ETH_NTP_FRAME_IP + 9] = 17;
+    frame[ETH_NTP_FRAME_IP + 12] = 192;
+    frame[ETH_NTP_FRAME_IP + 14] = 2;
+    frame[ETH_NTP_FRAME_UDP + 3] = 123;
+    memcpy(&frame[ETH_NTP_FRAME_XMT], &sequence, sizeof(sequence));
+    CHECK(eth_ntp_frame_match(frame, sizeof(frame), key));
+    uint64_t input_ns = timebase_hires_realtime_ns();
+    CHECK(hooks[port](NULL, frame, sizeof(frame), hook_privs[port]) == ESP_OK);
+    return input_ns;
+}
+
+// the arrival time the server gets for a request
+static uint64_t arrival_ns(const eth_ntp_frame_key_t *key) {
+    uint64_t time_ns = timebase_hires_realtime_ns();
+    CHECK(eth_rx_ntp_timestamp(key, &time_ns));
+    return time_ns;
+}
+
+int main(void) {
+    CHECK(eth_rx_timestamp_register((esp_eth_handle_t)0, INT_GPIO) == ESP_OK);
+    CHECK(eth_rx_timestamp_register((esp_eth_handle_t)1, -1) == ESP_OK);
+    CHECK(eth_rx_timestamp_attach((esp_eth_handle_t)0, NULL) == ESP_OK);
+    CHECK(eth_rx_timestamp_attach((esp_eth_handle_t)1, NULL) == ESP_OK);
+
+    // one frame per INT edge: arrival at the edge
+    uint32_t sequence = 0;
+    uint64_t delay_sum_us = 0;
+    uint32_t delay_min_us = UINT32_MAX;
+    uint32_t delay_max_us = 0;
+    int64_t worst_error_ns = 0;
+    for (int i = 0; i < FRAMES; i++) {
+        uint64_t edge_ns = timebase_hires_realtime_ns();
+        host_gpio_etm_edge(INT_GPIO, false);
+        uint32_t delay_us = DELAY_MIN_US + next_random() % (DELAY_MAX_US - DELAY_MIN_US);
+        spin_us(delay_us);
+        eth_ntp_frame_key_t key;
+        uint64_t input_ns = driver_receive(0, sequence++, &key);
+        host_gpio_etm_edge(INT_GPIO, true);
+        int64_t error_ns = llabs((int64_t)(arrival_ns(&key) - edge_ns));
+        worst_error_ns = error_ns > worst_error_ns ? error_ns : worst_error_ns;
+        uint32_t actual_us = (input_ns - edge_ns) / 1000;
+        delay_sum_us += actual_us;
+        delay_min_us = actual_us < delay_min_us ? actual_us : delay_min_us;
+        delay_max_us = actual_us > delay_max_us ? actual_us : delay_max_us;
+    }
+    printf("eth_spi_low_latency: arrival at the INT edge within %.1f us after %lu to %lu us of SPI and task delay\n",
+           worst_error_ns / 1e3, (unsigned long)delay_min_us, (unsigned long)delay_max_us);
+    CHECK(worst_error_ns <= MAX_EDGE_ERROR_US * 1000);
+
+    eth_rx_latency_t latency;
+    CHECK(eth_rx_latency_get(0, &latency));
+    CHECK_EQ(latency.frames, FRAMES);
+    CHECK_EQ(latency.captured, FRAMES);
+    CHECK(latency.min_us + MAX_EDGE_ERROR_US >= delay_min_us && latency.min_us <= delay_min_us + MAX_EDGE_ERROR_US);
+    CHECK(latency.max_us + MAX_EDGE_ERROR_US >= delay_max_us && latency.max_us <= delay_max_us + MAX_EDGE_ERROR_US);
+    CHECK(llabs((int64_t)(latency.sum_us / FRAMES) - (int64_t)(delay_sum_us / FRAMES)) <= MAX_EDGE_ERROR_US);
+    uint32_t histogram_sum = 0;
+    for (int b = 0; b < ETH_RX_LATENCY_BUCKETS; b++) {
+        histogram_sum += latency.histogram[b];
+        // bucket b holds 2^(b-1) <= latency < 2^b, nothing outside the delays of the test
+        if ((1u << b) + MAX_EDGE_ERROR_US <= delay_min_us ||
+            (b > 0 && (1u << (b - 1)) > delay_max_us + MAX_EDGE_ERROR_US)) {
+            CHECK_EQ(latency.histogram[b], 0);
+        }
+    }
+    CHECK_EQ(histogram_sum, FRAMES);
+    printf("eth_spi_low_latency: INT to stack input min %lu us avg %lu us max %lu us\n", (unsigned long)latency.min_us,
+           (unsigned long)(latency.sum_us / latency.captured), (unsigned long)latency.max_us);
+
+    // a burst read after one edge: only the first frame arrived at the edge
+    uint64_t edge_ns = timebase_hires_realtime_ns();
+    host_gpio_etm_edge(INT_GPIO, false);
+    spin_us(DELAY_MIN_US);
+    for (int i = 0; i < BURST; i++) {
+        eth_ntp_frame_key_t key;
+        uint64_t input_ns = driver_receive(0, sequence++, &key);
+        uint64_t expected_ns = i == 0 ? edge_ns : input_ns;
+        CHECK(llabs((int64_t)(arrival_ns(&key) - expected_ns)) <= MAX_EDGE_ERROR_US * 1000);
+    }
+    host_gpio_etm_edge(INT_GPIO, true);
+    CHECK(eth_rx_latency_get(0, &latency));
+    CHECK_EQ(latency.frames, FRAMES + BURST);
+    CHECK_EQ(latency.captured, FRAMES + 1);
+
+    // only the falling edge is latched, and a module without INT line keeps the stack input time
+    host_gpio_etm_edge(INT_GPIO, true);
+    spin_us(DELAY_MIN_US);
+    eth_ntp_frame_key_t key;
+    uint64_t input_ns = driver_receive(0, sequence++, &key);
+    CHECK(llabs((int64_t)(arrival_ns(&key) - input_ns)) <= MAX_EDGE_ERROR_US * 1000);
+    host_gpio_etm_edge(INT_GPIO, false);
+    spin_us(DELAY_MIN_US);
+    input_ns = driver_receive(1, sequence++, &key);
+    CHECK(llabs((int64_t)(arrival_ns(&key) - input_ns)) <= MAX_EDGE_ERROR_US * 1000);
+    CHECK(eth_rx_latency_get(0, &latency));
+    CHECK_EQ(latency.captured, FRAMES + 1);
+    CHECK(eth_rx_latency_get(1, &latency));
+    CHECK_EQ(latency.frames, 1);
+    CHECK_EQ(latency.captured, 0);
+    CHECK(!eth_rx_latency_get(2, &latency));
+    CHECK_EQ(stack_frames, FRAMES + BURST + 2);
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Tasks that end with mem_budget_task_exit() leave the report, also when they end before app_main
+// registered them or while a report reads them; the NTP server task ends that way when it cannot bind its port.
+// The stubs abort on pcTaskGetName() or uxTaskGetStackHighWaterMark() of a deleted task. Static RAM is summed per
+// component, in static mode including the task stacks and TCBs.
+
+#include <string.h>
+
+#include "lwip/sockets.h"
+#include "mem_budget.h"
+#include "test_util.h"
+#include "udp_server_task.h"
+
+#define STACK_SIZE 4096
+#define WORKERS 6
+
+time_t dcf77_last_sync(void) { return 0; }
+
+static volatile bool stop = false;
+
+static void running_task(void *arg) {
+    while (!stop) {
+        vTaskDelay(1);
+    }
+    mem_budget_task_exit();
+}
+
+static void failing_task(void *arg) { mem_budget_task_exit(); }
+
+// ends after a few ms, while the main thread reads the report in a loop
+static void worker_task(void *arg) {
+    vTaskDelay(1 + (uintptr_t)arg % 5);
+    mem_budget_task_exit();
+}
+
+static bool listed(const char *name) {
+    mem_budget_task_t report[MEM_BUDGET_MAX_TASKS];
+    int n = mem_budget_read(report, MEM_BUDGET_MAX_TASKS);
+    for (int i = 0; i < n; i++) {
+        CHECK_EQ(report[i].stack_size, STACK_SIZE);
+        CHECK_EQ(report[i].stack_free_min, STACK_SIZE / 2);
+        if (strcmp(report[i].name, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void wait_deleted(TaskHandle_t task) {
+    for (int i = 0; i < 5000 && !host_task_deleted(task); i++) {
+        vTaskDelay(1);
+    }
+    CHECK(host_task_deleted(task));
+}
+
+static uint32_t static_bytes(const char *component) {
+    mem_budget_static_t pools[MEM_BUDGET_MAX_COMPONENTS];
+    int n = mem_budget_read_static(pools, MEM_BUDGET_MAX_COMPONENTS);
+    for (int i = 0; i < n; i++) {
+        if (strcmp(pools[i].component, component) == 0) {
+            return pools[i].bytes;
+        }
+    }
+    return 0;
+}
+
+int main(void) {
+    MEM_BUDGET_CREATE_TASK(running_task, "running", STACK_SIZE, 5, 0);
+    CHECK(listed("running"));
+
+    // ended before it was registered, as a task of higher priority than app_main can
+    TaskHandle_t early = NULL;
+    CHECK(xTaskCreatePinnedToCore(failing_task, "early", STACK_SIZE, NULL, 5, &early, 0) == pdPASS);
+    wait_deleted(early);
+    mem_budget_register_task(early, STACK_SIZE);
+    CHECK(!listed("early"));
+
+    // ends while the report is read
+    for (uintptr_t i = 0; i < WORKERS - 1; i++) {
+        TaskHandle_t worker = NULL;
+        CHECK(xTaskCreatePinnedToCore(worker_task, "worker", STACK_SIZE, (void *)i, 5, &worker, 0) == pdPASS);
+        mem_budget_register_task(worker, STACK_SIZE);
+    }
+    int64_t until = test_clock_ns(CLOCK_MONOTONIC) + 50000000;
+    while (test_clock_ns(CLOCK_MONOTONIC) < until) {
+        listed("worker");
+    }
+    CHECK(!listed("worker"));
+
+    // the NTP server cannot bind port 123: held by this test, or no permission to bind it
+    int holder = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    struct sockaddr_in ntp_addr = {.sin_family = AF_INET, .sin_port = htons(123)};
+    bind(holder, (struct sockaddr *)&ntp_addr, sizeof(ntp_addr));
+    TaskHandle_t server = NULL;
+    CHECK(xTaskCreatePinnedToCore(udp_server_task, "udp_server", STACK_SIZE, NULL, 5, &server, 1) == pdPASS);
+    mem_budget_register_task(server, STACK_SIZE);
+    wait_deleted(server);
+    CHECK(!listed("udp_server"));
+    CHECK(listed("running"));
+    close(holder);
+
+    mem_budget_add_static("pool_a", 100);
+    mem_budget_add_static("pool_b", 50);
+    mem_budget_add_static("pool_a", 24);
+    CHECK_EQ(static_bytes("pool_a"), 124);
+    CHECK_EQ(static_bytes("pool_b"), 50);
+#if CONFIG_MEM_BUDGET_STATIC
+    CHECK_EQ(static_bytes("running"), STACK_SIZE + sizeof(StaticTask_t));
+#else
+    CHECK_EQ(static_bytes("running"), 0);
+#endif
+
+    stop = true;
+    mem_budget_task_t report[MEM_BUDGET_MAX_TASKS];
+    for (int i = 0; i < 5000 && mem_budget_read(report, MEM_BUDGET_MAX_TASKS) > 0; i++) {
+        vTaskDelay(1);
+    }
+    CHECK_EQ(mem_budget_read(report, MEM_BUDGET_MAX_TASKS), 0);
+    printf("mem_budget: deleted tasks left the report, static total of pool_a %lu\n",
+           (unsigned long)static_bytes("pool_a"));
+    return 0;
+}
@@ -0,0 +1,114 @@
+// MD5 against the RFC 1321 vectors, the NTP MAC trailer with MD5 and AES-CMAC keys loaded from NVS against
+// the RFC 4493 vector, rejection of tampered packets, unknown keys and duplicate key ids. The benchmark leaves the
+// server counters alone and does not run when a key id of it is taken.
+
+#include <string.h>
+
+#include "ntp_auth.h"
+#include "ntp_md5.h"
+#include "ntp_packet.h"
+#include "nvs.h"
+#include "test_util.h"
+#include "udp_server_task.h"
+
+time_t dcf77_last_sync(void) { return 1; }
+
+static void from_hex(const char *hex, uint8_t *out) {
+    for (size_t i = 0; hex[2 * i] != '\0'; i++) {
+        sscanf(&hex[2 * i], "%2hhx", &out[i]);
+    }
+}
+
+static void check_hex(const uint8_t *data, const char *hex) {
+    uint8_t expected[64];
+    from_hex(hex, expected);
+    if (memcmp(data, expected, strlen(hex) / 2) != 0) {
+        fprintf(stderr, "expected %s, got ", hex);
+        for (size_t i = 0; i < strlen(hex) / 2; i++) {
+            fprintf(stderr, "%02x", data[i]);
+        }
+        fprintf(stderr, "\n");
+        exit(1);
+    }
+}
+
+static void test_md5(void) {
+    uint8_t digest[16];
+    ntp_md5(NULL, 0, NULL, 0, digest);
+    check_hex(digest, "d41d8cd98f00b204e9800998ecf8427e");
+    ntp_md5((const uint8_t *)"a", 1, (const uint8_t *)"bc", 2, digest);
+    check_hex(digest, "900150983cd24fb0d6963f7d28e17f72");
+    // 80 byte message, the padding needs a second block
+    const char *digits = "12345678901234567890123456789012345678901234567890123456789012345678901234567890";
+    ntp_md5((const uint8_t *)digits, 60, (const uint8_t *)digits + 60, 20, digest);
+    check_hex(digest, "57edf4a22be3c955ac49da2e2107b67a");
+}
+
+static void test_mac_trailer(void) {
+    uint8_t md5_blob[7] = {NTP_AUTH_TYPE_MD5, 'n', 't', 'p', 'k', 'e', 'y'};
+    uint8_t cmac_blob[17] = {NTP_AUTH_TYPE_AES_CMAC};
+    from_hex("2b7e151628aed2a6abf7158809cf4f3c", &cmac_blob[1]);
+    uint8_t bad_blob[5] = {NTP_AUTH_TYPE_AES_CMAC, 1, 2, 3, 4};
+    CHECK_EQ(host_nvs_set_blob(NTP_AUTH_NVS_NAMESPACE, "7", md5_blob, sizeof(md5_blob)), ESP_OK);
+    CHECK_EQ(host_nvs_set_blob(NTP_AUTH_NVS_NAMESPACE, "4493", cmac_blob, sizeof(cmac_blob)), ESP_OK);
+    CHECK_EQ(host_nvs_set_blob(NTP_AUTH_NVS_NAMESPACE, "9", bad_blob, sizeof(bad_blob)), ESP_OK);
+    CHECK_EQ(ntp_auth_load_keys(), ESP_OK);
+
+    // the first 48 byte of the RFC 4493 example message as NTP header
+    uint8_t packet[NTP_PACKET_SIZE + NTP_AUTH_MAC_SIZE];
+    from_hex("6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52ef",
+             packet);
+    uint32_t key_id;
+    CHECK_EQ(ntp_auth_sign(packet, 4493), sizeof(packet));
+    check_hex(&packet[NTP_PACKET_SIZE], "0000118dc47c4d9d64588f67fb9de6fe745d7fbf");
+    CHECK(ntp_auth_verify(packet, sizeof(packet), &key_id));
+    CHECK_EQ(key_id, 4493);
+
+    CHECK_EQ(ntp_auth_sign(packet, 7), sizeof(packet));
+    check_hex(&packet[NTP_PACKET_SIZE], "00000007c40ebac5c525607a0076766f76b3d572");
+    CHECK(ntp_auth_verify(packet, sizeof(packet), &key_id));
+    CHECK_EQ(key_id, 7);
+
+    packet[40] ^= 1;
+    CHECK(!ntp_auth_verify(packet, sizeof(packet), &key_id));
+    packet[40] ^= 1;
+    packet[NTP_PACKET_SIZE + 19] ^= 1;
+    CHECK(!ntp_auth_verify(packet, sizeof(packet), &key_id));
+    // the invalid key was not loaded, unknown keys do not sign
+    CHECK_EQ(ntp_auth_sign(packet, 9), NTP_PACKET_SIZE);
+    packet[NTP_PACKET_SIZE + 3] = 9;
+    CHECK(!ntp_auth_verify(packet, sizeof(packet), &key_id));
+    CHECK(!ntp_auth_verify(packet, NTP_PACKET_SIZE, &key_id));
+    CHECK(!ntp_auth_add_key(7, NTP_AUTH_TYPE_MD5, &md5_blob[1], sizeof(md5_blob) - 1));
+}
+
+static void test_bench(void) {
+    uint32_t served = ntp_server_requests();
+    ntp_auth_bench_t bench;
+    CHECK(ntp_auth_bench(100, &bench));
+    CHECK(bench.unauthenticated_per_s > 0 && bench.md5_per_s > 0 && bench.aes_cmac_per_s > 0);
+    CHECK_EQ(ntp_server_requests(), served);
+
+    // an operator key with the id of a benchmark key stays
+    const uint8_t secret[4] = {1, 2, 3, 4};
+    CHECK(ntp_auth_add_key(0xFFFFFF02, NTP_AUTH_TYPE_MD5, secret, sizeof(secret)));
+    CHECK(!ntp_auth_bench(100, &bench));
+    CHECK_EQ(bench.md5_per_s, 0);
+    uint8_t packet[NTP_PACKET_SIZE + NTP_AUTH_MAC_SIZE] = {0x23};
+    uint32_t key_id;
+    CHECK_EQ(ntp_auth_sign(packet, 0xFFFFFF02), sizeof(packet));
+    uint8_t digest[NTP_MD5_DIGEST_SIZE];
+    ntp_md5(secret, sizeof(secret), packet, NTP_PACKET_SIZE, digest);
+    CHECK(memcmp(&packet[NTP_PACKET_SIZE + 4], digest, sizeof(digest)) == 0);
+    CHECK(ntp_auth_verify(packet, sizeof(packet), &key_id));
+    // the benchmark did not leave its MD5 key behind either
+    CHECK_EQ(ntp_auth_sign(packet, 0xFFFFFF01), NTP_PACKET_SIZE);
+}
+
+int main(void) {
+    test_md5();
+    test_mac_trailer();
+    test_bench();
+    printf("ntp_auth: ok\n");
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Server CPU time per client update, unicast against broadcast, for growing fleets on the loopback interface.
+// Unicast: every client update is one request through recvfrom(), ntp_server_respond() and sendto(). Broadcast:
+// one ntp_broadcast_packet() and sendto() per interval updates the whole fleet. Only the server side is measured
+// (CLOCK_THREAD_CPUTIME_ID), the clients run before and after the measured section.
+
+#include <fcntl.h>
+#include <string.h>
+
+#include "lwip/sockets.h"
+#include "test_util.h"
+#include "udp_server_task.h"
+
+#define BURST 64  // requests in flight, well below the socket buffer
+#define BROADCAST_INTERVALS 2000
+
+static time_t last_sync = 1;
+
+time_t dcf77_last_sync(void) { return last_sync; }
+
+static int udp_socket(struct sockaddr_in *addr) {
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    CHECK(sock >= 0);
+    struct sockaddr_in any = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    CHECK(bind(sock, (struct sockaddr *)&any, sizeof(any)) == 0);
+    socklen_t len = sizeof(*addr);
+    getsockname(sock, (struct sockaddr *)addr, &len);
+    return sock;
+}
+
+// server CPU ns per client update with unicast polling
+static double unicast_ns(int server, const struct sockaddr_in *server_addr, int fleet) {
+    int clients[BURST];
+    for (int i = 0; i < BURST; i++) {
+        struct sockaddr_in addr;
+        clients[i] = udp_socket(&addr);
+    }
+    int64_t cpu = 0;
+    for (int done = 0; done < fleet; done += BURST) {
+        int n = fleet - done < BURST ? fleet - done : BURST;
+        char request[NTP_PACKET_SIZE] = {0x23};  // LI 0, version 4, mode 3
+        for (int i = 0; i < n; i++) {
+            CHECK(sendto(clients[i], request, sizeof(request), 0, (const struct sockaddr *)server_addr,
+                         sizeof(*server_addr)) == NTP_PACKET_SIZE);
+        }
+        int64_t start = test_clock_ns(CLOCK_THREAD_CPUTIME_ID);
+        for (int i = 0; i < n; i++) {
+            char packet[NTP_PACKET_SIZE + 1];
+            struct sockaddr_in source;
+            socklen_t socklen = sizeof(source);
+            int len = recvfrom(server, packet, sizeof(packet), 0, (struct sockaddr *)&source, &socklen);
+            uint64_t receive_time = getCurrentTimeInNTP64BitFormat();
+            size_t response_len = ntp_server_respond(packet, len, &source, receive_time);
+            CHECK(response_len == NTP_PACKET_SIZE);
+            sendto(server, packet, response_len, 0, (struct sockaddr *)&source, sizeof(source));
+        }
+        cpu += test_clock_ns(CLOCK_THREAD_CPUTIME_ID) - start;
+        for (int i = 0; i < n; i++) {
+            char response[NTP_PACKET_SIZE];
+            CHECK(recv(clients[i], response, sizeof(response), 0) == NTP_PACKET_SIZE);
+            CHECK((response[0] & 0x07) == 4);  // mode 4, server
+        }
+    }
+    for (int i = 0; i < BURST; i++) {
+        close(clients[i]);
+    }
+    return (double)cpu / fleet;
+}
+
+// server CPU ns per interval with broadcast, the same for every fleet size
+static double broadcast_ns(int server, const struct sockaddr_in *group) {
+    int64_t cpu = 0;
+    char packet[NTP_PACKET_SIZE];
+    for (int i = 0; i < BROADCAST_INTERVALS; i++) {
+        int64_t start = test_clock_ns(CLOCK_THREAD_CPUTIME_ID);
+        CHECK(ntp_broadcast_packet(packet));
+        ntp_write_timestamp(&packet[40], getCurrentTimeInNTP64BitFormat());
+        sendto(server, packet, NTP_PACKET_SIZE, 0, (const struct sockaddr *)group, sizeof(*group));
+        cpu += test_clock_ns(CLOCK_THREAD_CPUTIME_ID) - start;
+        // the receiving socket stands for the fleet, drained outside the measurement
+        recv(server, packet, sizeof(packet), 0);
+        CHECK((packet[0] & 0x07) == 5);  // mode 5, broadcast
+    }
+    return (double)cpu / BROADCAST_INTERVALS;
+}
+
+int main(void) {
+    struct sockaddr_in server_addr;
+    int server = udp_socket(&server_addr);
+
+    // no broadcast before the clock was synchronized
+    char packet[NTP_PACKET_SIZE];
+    last_sync = 0;
+    CHECK(!ntp_broadcast_packet(packet));
+    last_sync = 1;
+    CHECK(ntp_broadcast_packet(packet));
+    CHECK((packet[0] & 0xC0) == 0);  // LI 0
+
+    double per_interval = broadcast_ns(server, &server_addr);
+    printf("%8s %22s %24s\n", "clients", "unicast ns/update", "broadcast ns/update");
+    const int fleets[] = {1, 10, 100, 1000, 10000};
+    for (size_t i = 0; i < sizeof(fleets) / sizeof(fleets[0]); i++) {
+        double unicast = unicast_ns(server, &server_addr, fleets[i]);
+        double broadcast = per_interval / fleets[i];
+        printf("%8d %22.0f %24.1f\n", fleets[i], unicast, broadcast);
+        // from ten clients on a broadcast must cost less per update than answering each client
+        if (fleets[i] >= 10) {
+            CHECK(broadcast < unicast);
+        }
+    }
+    close(server);
+    return 0;
+}
@@ -0,0 +1,78 @@
+#!/bin/sh
+# Switchover from the time code receiver to local upstream servers and offset continuity. Two chronyd
+# instances (or one ntpd on both addresses) serve the system clock on 10.78.0.1 and 10.78.0.2 in a network
+# namespace, they do not touch the clock of the host. clock_select_runner reports the receiver with a bias of 5 ms
+# for 30 s and is then left with the servers: the system peer must change within the receiver timeout and the
+# clock must be slewed to the servers, at most 500 ppm per second, without a step.
+#   test_ntp_switchover.sh <clock_select_runner>
+runner=$1
+radio_s=30
+bias_us=5000
+max_change_us=${SWITCHOVER_MAX_CHANGE_US:-600}
+max_final_us=${SWITCHOVER_MAX_FINAL_US:-1000}
+
+[ "$(id -u)" = 0 ] || { echo "network namespaces need root"; exit 77; }
+if command -v chronyd >/dev/null 2>&1; then
+    server=chronyd
+    seconds=90
+elif command -v ntpd >/dev/null 2>&1; then
+    server=ntpd
+    seconds=150  # ntpd serves its local clock only after a few polls of it
+else
+    echo "neither chronyd nor ntpd installed"
+    exit 77
+fi
+
+ns=ntpsw$$
+dir=$(mktemp -d)
+cleanup() {
+    for pid in $server_pids; do
+        kill "$pid" 2>/dev/null
+    done
+    ip netns del "$ns" 2>/dev/null
+    rm -rf "$dir"
+}
+trap cleanup EXIT
+
+ip netns add "$ns" || { echo "cannot create a network namespace"; exit 77; }
+ip -n "$ns" link set lo up
+ip -n "$ns" addr add 10.78.0.1/32 dev lo
+ip -n "$ns" addr add 10.78.0.2/32 dev lo
+
+if [ "$server" = chronyd ]; then
+    for n in 1 2; do
+        cat >"$dir/chrony$n.conf" <<EOF
+local stratum 3
+allow all
+bindaddress 10.78.0.$n
+port 123
+cmdport 0
+pidfile $dir/chrony$n.pid
+EOF
+        ip netns exec "$ns" chronyd -x -d -f "$dir/chrony$n.conf" >"$dir/chrony$n.log" 2>&1 &
+        server_pids="$server_pids $!"
+    done
+else
+    cat >"$dir/ntp.conf" <<EOF
+server 127.127.1.0 minpoll 4 maxpoll 4
+fudge 127.127.1.0 stratum 3
+interface ignore wildcard
+interface listen 10.78.0.1
+interface listen 10.78.0.2
+restrict default
+disable ntp
+EOF
+    ip netns exec "$ns" ntpd -n -c "$dir/ntp.conf" >"$dir/ntp.log" 2>&1 &
+    server_pids=$!
+fi
+sleep 1
+
+ip netns exec "$ns" "$runner" "$seconds" "$radio_s" "$bias_us" >"$dir/runner.log" 2>&1
+status=$?
+tail -n 1 "$dir/runner.log"
+[ $status = 0 ] || { cat "$dir/runner.log"; echo "no switchover to the upstream servers"; exit 1; }
+awk -v change="$max_change_us" -v final="$max_final_us" '
+    /^switchover/ {
+        c = $12; f = $16 < 0 ? -$16 : $16
+        exit (c <= change && f <= final) ? 0 : 1
+    }' "$dir/runner.log" || { cat "$dir/runner.log"; exit 1; }
@@ -0,0 +1,97 @@
+// The profiler tracepoints in a host build. An "ISR" thread stamps edges every 50 us and queues them, the
+// task follows each edge with a 200 us decode. The ISR keeps firing during the decode, so the decode stage must only
+// be measured from the task's own wake-up: every decode sample is at least 200 us. An NTP path with back to back
+// tracepoints has stages far below a microsecond, the dump must show them in ns instead of "< 0 us".
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "prof.h"
+#include "test_util.h"
+
+#define EDGES 400
+#define EDGE_INTERVAL_NS 50000
+#define DECODE_NS 200000
+#define DECODE_MIN_BUCKET 18  // 2^17 ns <= 200 us < 2^18 ns
+#define NTP_REQUESTS 10000
+
+typedef struct {
+    uint32_t id;
+    prof_mark_t prof;
+} edge_t;
+
+static QueueHandle_t edge_queue;
+static volatile bool isr_done = false;
+static volatile uint32_t isr_edges = 0;
+
+static void spin_ns(int64_t ns) {
+    int64_t until = test_clock_ns(CLOCK_MONOTONIC) + ns;
+    while (test_clock_ns(CLOCK_MONOTONIC) < until) {
+    }
+}
+
+static void isr_task(void *arg) {
+    for (uint32_t i = 0; i < EDGES; i++) {
+        edge_t edge = {.id = i};
+        PROF_STAMP(edge.prof, PROF_DCF77_ISR);
+        BaseType_t woken = pdFALSE;
+        isr_edges += xQueueSendFromISR(edge_queue, &edge, &woken) == pdTRUE;
+        spin_ns(EDGE_INTERVAL_NS);
+    }
+    isr_done = true;
+    vTaskDelete(NULL);
+}
+
+int main(void) {
+    edge_queue = xQueueCreate(EDGES, sizeof(edge_t));
+    CHECK(xTaskCreatePinnedToCore(isr_task, "isr", 4096, NULL, 10, NULL, 0) == pdPASS);
+    uint32_t received = 0;
+    while (!isr_done || received < isr_edges) {
+        edge_t edge;
+        if (xQueueReceive(edge_queue, &edge, 1) != pdTRUE) {
+            continue;
+        }
+        PROF_RESUME(PROF_PATH_DCF77, PROF_DCF77_WAKE, edge.prof);
+        spin_ns(DECODE_NS);
+        PROF_POINT(PROF_PATH_DCF77, PROF_DCF77_DECODE);
+        received++;
+    }
+
+    for (int i = 0; i < NTP_REQUESTS; i++) {
+        PROF_START(PROF_PATH_NTP, PROF_NTP_RECV);
+        PROF_POINT(PROF_PATH_NTP, PROF_NTP_TIMESTAMP);
+        PROF_POINT(PROF_PATH_NTP, PROF_NTP_BUILD);
+        PROF_POINT(PROF_PATH_NTP, PROF_NTP_SEND);
+    }
+
+    prof_hist_t isr, wake, decode, send;
+    prof_read(PROF_DCF77_ISR, &isr);
+    prof_read(PROF_DCF77_WAKE, &wake);
+    prof_read(PROF_DCF77_DECODE, &decode);
+    prof_read(PROF_NTP_SEND, &send);
+    CHECK_EQ(isr.count, EDGES);
+    CHECK_EQ(wake.count, received);
+    CHECK_EQ(decode.count, received);
+    CHECK_EQ(send.count, NTP_REQUESTS);
+    for (int i = 0; i < DECODE_MIN_BUCKET; i++) {
+        CHECK_EQ(decode.buckets[i], 0);
+    }
+
+    // the dump goes to stdout on a host
+    char dump[4096] = {0};
+    FILE *saved = stdout;
+    stdout = fmemopen(dump, sizeof(dump) - 1, "w");
+    prof_dump();
+    fclose(stdout);
+    stdout = saved;
+    fputs(dump, stdout);
+    CHECK(strstr(dump, "ntp send") != NULL);
+    CHECK(strstr(dump, " ns") != NULL);
+    CHECK(strstr(dump, "< 0 ") == NULL);
+    printf("prof: %lu of %d edges received, decode measured from the task's wake-up only\n", (unsigned long)received,
+           EDGES);
+    return 0;
+}
@@ -0,0 +1,45 @@
+#!/bin/sh
+# ptp4l as software timestamping slave of ptp_runner, over a veth pair between two network namespaces.
+# ptp4l runs with free_running 1, so it only measures and leaves the clock of the host alone. Both ends read the
+# same system clock, the measured offset is the timestamping error of the grandmaster plus the one of ptp4l.
+#   test_ptp4l.sh <ptp_runner>
+runner=$1
+max_offset_ns=${PTP4L_MAX_OFFSET_NS:-1000000}
+
+command -v ptp4l >/dev/null 2>&1 || { echo "ptp4l not installed"; exit 77; }
+[ "$(id -u)" = 0 ] || { echo "network namespaces need root"; exit 77; }
+
+gm=ptpgm$$
+slave=ptpsl$$
+log=$(mktemp)
+cleanup() {
+    kill "$runner_pid" 2>/dev/null
+    ip netns del "$gm" 2>/dev/null
+    ip netns del "$slave" 2>/dev/null
+    rm -f "$log"
+}
+trap cleanup EXIT
+
+ip netns add "$gm" 2>/dev/null && ip netns add "$slave" || { echo "cannot create network namespaces"; exit 77; }
+ip link add vgm$$ netns "$gm" type veth peer name vsl$$ netns "$slave" || exit 77
+ip -n "$gm" addr add 10.77.0.1/24 dev vgm$$
+ip -n "$slave" addr add 10.77.0.2/24 dev vsl$$
+for ns in "$gm" "$slave"; do
+    ip -n "$ns" link set lo up
+done
+ip -n "$gm" link set vgm$$ up
+ip -n "$slave" link set vsl$$ up
+ip -n "$gm" route add 224.0.0.0/4 dev vgm$$
+
+ip netns exec "$gm" "$runner" 40 &
+runner_pid=$!
+ip netns exec "$slave" timeout 30 ptp4l -i vsl$$ -S -s -m --free_running 1 >"$log" 2>&1
+
+grep -q "to SLAVE" "$log" || { cat "$log"; echo "ptp4l did not select the grandmaster"; exit 1; }
+# skip the first samples, ptp4l measures the path delay first
+awk -v max="$max_offset_ns" '
+    /master offset/ { n++; if (n <= 5) next; v = $4 < 0 ? -$4 : $4; if (v > worst) worst = v; count++ }
+    END {
+        printf "ptp4l: %d offsets, worst %d ns\n", count, worst
+        exit (count > 0 && worst <= max) ? 0 : 1
+    }' "$log" || { cat "$log"; exit 1; }
@@ -0,0 +1,138 @@
+// The PTP grandmaster engine seen from a minimal slave. The flags and the clock class follow the
+// synchronization state, the software timestamps come from timebase, and a two-step exchange over a virtual clock
+// gives the slave the expected offset and path delay.
+
+#include <string.h>
+
+#include "ptp_engine.h"
+#include "ptp_sw_timestamp.h"
+#include "test_util.h"
+#include "virtual_clock.h"
+
+#define FLAG_UTC_OFFSET_VALID 0x04
+#define FLAG_PTP_TIMESCALE 0x08
+#define FLAG_TIME_TRACEABLE 0x10
+
+static const uint8_t mac[6] = {0x02, 0x00, 0x5E, 0x10, 0x00, 0x01};
+
+static int64_t get_timestamp_ns(const uint8_t *p) {
+    uint64_t seconds = 0;
+    for (int i = 0; i < 6; i++) {
+        seconds = (seconds << 8) | p[i];
+    }
+    uint32_t ns = 0;
+    for (int i = 6; i < 10; i++) {
+        ns = (ns << 8) | p[i];
+    }
+    return (int64_t)seconds * 1000000000 + ns;
+}
+
+static int64_t timestamp_ns(const ptp_timestamp_t *ts) { return (int64_t)ts->seconds * 1000000000 + ts->nanoseconds; }
+
+static void test_flags_follow_sync_state(void) {
+    ptp_engine_t engine;
+    uint8_t buf[PTP_MAX_MSG_SIZE];
+    ptp_engine_init(&engine, mac, 0);
+
+    // never synchronized: no valid UTC offset, class 248
+    CHECK_EQ(ptp_build_announce(&engine, buf), 64);
+    CHECK_EQ(ptp_message_type(&engine, buf, 64), PTP_MSG_ANNOUNCE);
+    CHECK_EQ(buf[7] & FLAG_UTC_OFFSET_VALID, 0);
+    CHECK_EQ(buf[7] & FLAG_TIME_TRACEABLE, 0);
+    CHECK(buf[7] & FLAG_PTP_TIMESCALE);
+    CHECK_EQ(buf[48], 248);
+
+    engine.synchronized = true;
+    engine.quality.clock_class = 6;
+    ptp_build_sync(&engine, buf);
+    CHECK(buf[7] & FLAG_UTC_OFFSET_VALID);
+    CHECK(buf[7] & FLAG_TIME_TRACEABLE);
+    CHECK_EQ(buf[6] & 0x02, 0x02);  // two-step
+
+    // holdover: the UTC offset stays valid, the time is no longer traceable
+    engine.quality.clock_class = 7;
+    ptp_build_announce(&engine, buf);
+    CHECK(buf[7] & FLAG_UTC_OFFSET_VALID);
+    CHECK_EQ(buf[7] & FLAG_TIME_TRACEABLE, 0);
+    CHECK_EQ(buf[48], 7);
+    CHECK_EQ((buf[44] << 8) | buf[45], 37);
+}
+
+// a slave 250 µs behind the grandmaster with a 40 µs one way delay measures both from t1..t4
+static void test_two_step_exchange(void) {
+    const int64_t delay_ns = 40000;
+    const int64_t slave_offset_ns = -250000;
+
+    virtual_clock_t clock;
+    virtual_clock_init(&clock, 1700000000LL * 1000000);
+    virtual_clock_install(&clock);
+
+    ptp_engine_t engine;
+    ptp_timestamp_backend_t backend;
+    uint8_t sync[PTP_MAX_MSG_SIZE], follow_up[PTP_MAX_MSG_SIZE], delay_resp[PTP_MAX_MSG_SIZE];
+    ptp_engine_init(&engine, mac, 0);
+    engine.synchronized = true;
+    ptp_sw_backend_init(&backend, &engine);
+
+    // the software timestamp is the timebase time on the TAI scale
+    ptp_timestamp_t t1;
+    backend.tx_timestamp(backend.ctx, &t1);
+    CHECK_EQ(timestamp_ns(&t1), (clock.realtime_us + 37 * 1000000LL) * 1000);
+
+    size_t len = ptp_build_sync(&engine, sync);
+    CHECK_EQ(ptp_message_type(&engine, sync, len), PTP_MSG_SYNC);
+    len = ptp_build_follow_up(&engine, follow_up, &t1);
+    CHECK_EQ(ptp_message_type(&engine, follow_up, len), PTP_MSG_FOLLOW_UP);
+    CHECK_EQ(memcmp(&sync[30], &follow_up[30], 2), 0);  // same sequence id
+    virtual_clock_advance(&clock, delay_ns / 1000);
+    int64_t t2 = (clock.realtime_us + 37 * 1000000LL) * 1000 + slave_offset_ns;
+
+    virtual_clock_advance(&clock, 1000);
+    uint8_t delay_req[44] = {PTP_MSG_DELAY_REQ, 2, 0, 44};
+    delay_req[30] = 0x12;
+    delay_req[31] = 0x34;
+    memset(&delay_req[20], 0xAB, 10);
+    int64_t t3 = (clock.realtime_us + 37 * 1000000LL) * 1000 + slave_offset_ns;
+    virtual_clock_advance(&clock, delay_ns / 1000);
+    ptp_timestamp_t receive_time;
+    backend.rx_timestamp(backend.ctx, &receive_time);
+    len = ptp_build_delay_resp(&engine, delay_resp, delay_req, sizeof(delay_req), &receive_time);
+    CHECK_EQ(len, 54);
+    CHECK_EQ(ptp_message_type(&engine, delay_resp, len), PTP_MSG_DELAY_RESP);
+    CHECK_EQ(memcmp(&delay_resp[30], &delay_req[30], 2), 0);
+    CHECK_EQ(memcmp(&delay_resp[44], &delay_req[20], 10), 0);
+
+    int64_t t1_ns = get_timestamp_ns(&follow_up[34]);
+    int64_t t4_ns = get_timestamp_ns(&delay_resp[34]);
+    int64_t offset = ((t2 - t1_ns) - (t4_ns - t3)) / 2;
+    int64_t path_delay = ((t2 - t1_ns) + (t4_ns - t3)) / 2;
+    CHECK_EQ(offset, slave_offset_ns);
+    CHECK_EQ(path_delay, delay_ns);
+
+    // a step of the disciplined clock shows up in the next timestamp
+    timebase_step(-1500);
+    ptp_timestamp_t after_step;
+    backend.tx_timestamp(backend.ctx, &after_step);
+    CHECK_EQ(timestamp_ns(&after_step) - timestamp_ns(&receive_time), -1500 * 1000);
+    timebase_set_backend(NULL);
+}
+
+static void test_rejects_other_domains(void) {
+    ptp_engine_t engine;
+    uint8_t resp[PTP_MAX_MSG_SIZE];
+    ptp_engine_init(&engine, mac, 0);
+    uint8_t delay_req[44] = {PTP_MSG_DELAY_REQ, 2, 0, 44, 1};
+    ptp_timestamp_t t = {0};
+    CHECK_EQ(ptp_message_type(&engine, delay_req, sizeof(delay_req)), -1);
+    CHECK_EQ(ptp_build_delay_resp(&engine, resp, delay_req, sizeof(delay_req), &t), 0);
+    delay_req[4] = 0;
+    CHECK_EQ(ptp_build_delay_resp(&engine, resp, delay_req, 43, &t), 0);
+}
+
+int main(void) {
+    test_flags_follow_sync_state();
+    test_two_step_exchange();
+    test_rejects_other_domains();
+    printf("ptp_engine: ok\n");
+    return 0;
+}
@@ -0,0 +1,145 @@
+// The Roughtime responder task on loopback, checked by roughtime_client.c. No request is answered and no
+// key is delegated before the clock is synchronized; once it is, the online key is delegated without waiting for a
+// request. Responses verify and are never larger than their request, short requests are dropped. After the clock
+// moves forward into the last quarter of the delegation, or back before its start, a new online key is delegated
+// between requests. When the socket fails, the task backs off instead of spinning on recvfrom().
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include "nvs.h"
+#include "roughtime.h"
+#include "roughtime_client.h"
+#include "sodium.h"
+#include "test_util.h"
+#include "timebase.h"
+
+#define DELEGATION_US (CONFIG_ROUGHTIME_DELEGATION_HOURS * 3600LL * 1000000)
+#define RENEW_TIMEOUT_MS 3000  // the idle path checks the delegation every second
+#define TIMEOUT_MS 500
+#define FAILING_MS 2000
+
+static _Atomic time_t last_sync = 0;
+static _Atomic int64_t clock_offset_us = 0;
+
+time_t dcf77_last_sync(void) { return last_sync; }
+
+static int64_t host_monotonic_us(void *ctx) { return test_clock_ns(CLOCK_MONOTONIC) / 1000; }
+
+// the host clock, moved by the test
+static void host_realtime(void *ctx, struct timeval *tv) {
+    int64_t us = test_clock_ns(CLOCK_REALTIME) / 1000 + clock_offset_us;
+    tv->tv_sec = us / 1000000;
+    tv->tv_usec = us % 1000000;
+}
+
+static const timebase_backend_t backend = {.monotonic_us = host_monotonic_us, .realtime = host_realtime};
+
+static uint32_t delegations(void) {
+    roughtime_stats_t stats;
+    roughtime_stats(&stats);
+    return stats.delegations;
+}
+
+static bool wait_delegations(uint32_t count) {
+    for (int ms = 0; ms < RENEW_TIMEOUT_MS; ms += 10) {
+        if (delegations() >= count) {
+            return true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return false;
+}
+
+// the socket of the task, bound to the port
+static int server_socket(void) {
+    for (int fd = 3; fd < 1024; fd++) {
+        struct sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        int type;
+        socklen_t type_len = sizeof(type);
+        if (getsockname(fd, (struct sockaddr *)&addr, &len) == 0 && addr.sin_family == AF_INET &&
+            ntohs(addr.sin_port) == CONFIG_ROUGHTIME_PORT &&
+            getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &type_len) == 0 && type == SOCK_DGRAM) {
+            return fd;
+        }
+    }
+    return -1;
+}
+
+static void check_query(int sock, const uint8_t *pk, roughtime_reply_t *reply) {
+    roughtime_result_t result = roughtime_query(sock, pk, ROUGHTIME_MIN_REQUEST_SIZE, TIMEOUT_MS, reply);
+    if (result != ROUGHTIME_OK) {
+        fprintf(stderr, "roughtime: %s\n", roughtime_result_name(result));
+    }
+    CHECK(result == ROUGHTIME_OK);
+    CHECK(reply->length <= ROUGHTIME_MIN_REQUEST_SIZE);
+}
+
+int main(void) {
+    uint8_t seed[crypto_sign_SEEDBYTES];
+    uint8_t pk[crypto_sign_PUBLICKEYBYTES];
+    uint8_t sk[crypto_sign_SECRETKEYBYTES];
+    randombytes_buf(seed, sizeof(seed));
+    crypto_sign_seed_keypair(pk, sk, seed);
+    CHECK_EQ(host_nvs_set_blob("roughtime", "seed", seed, sizeof(seed)), ESP_OK);
+    timebase_set_backend(&backend);
+    xTaskCreatePinnedToCore(roughtime_task, "roughtime", 8192, NULL, 4, NULL, 1);
+    // a request before the bind would come back as an ICMP error
+    for (int ms = 0; ms < TIMEOUT_MS && server_socket() < 0; ms += 10) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    CHECK(server_socket() >= 0);
+
+    // not synchronized: dropped, and nothing to delegate yet
+    int sock = roughtime_client_socket(CONFIG_ROUGHTIME_PORT);
+    CHECK(sock >= 0);
+    roughtime_reply_t reply;
+    CHECK(roughtime_query(sock, pk, ROUGHTIME_MIN_REQUEST_SIZE, TIMEOUT_MS, &reply) == ROUGHTIME_NO_RESPONSE);
+    roughtime_stats_t stats;
+    roughtime_stats(&stats);
+    CHECK_EQ(stats.dropped, 1);
+    CHECK_EQ(stats.delegations, 0);
+
+    // synchronized: delegated before the next request
+    last_sync = time(NULL);
+    CHECK(wait_delegations(1));
+    check_query(sock, pk, &reply);
+    uint64_t mint = reply.mint_us;
+    check_query(sock, pk, &reply);
+    CHECK_EQ(reply.mint_us, mint);
+    CHECK(roughtime_query(sock, pk, ROUGHTIME_MIN_REQUEST_SIZE / 2, TIMEOUT_MS, &reply) == ROUGHTIME_NO_RESPONSE);
+    CHECK_EQ(delegations(), 1);
+
+    // into the last quarter of the validity, then back before the start of the new key
+    clock_offset_us = DELEGATION_US * 4 / 5;
+    CHECK(wait_delegations(2));
+    check_query(sock, pk, &reply);
+    CHECK(reply.mint_us > mint + DELEGATION_US / 2);
+    clock_offset_us = 0;
+    CHECK(wait_delegations(3));
+    check_query(sock, pk, &reply);
+    CHECK(reply.mint_us < mint + DELEGATION_US / 2);
+
+    // an unconnected TCP socket in its place is always readable and every recvfrom() fails with ENOTCONN
+    int fd = server_socket();
+    CHECK(fd >= 0);
+    int failing = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK(dup2(failing, fd) == fd);
+    int64_t cpu_start = test_clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+    vTaskDelay(pdMS_TO_TICKS(FAILING_MS));
+    int64_t cpu_ns = test_clock_ns(CLOCK_PROCESS_CPUTIME_ID) - cpu_start;
+    printf("roughtime: %lld ms CPU in %d ms with a failing socket\n", (long long)(cpu_ns / 1000000), FAILING_MS);
+    CHECK(cpu_ns < FAILING_MS * 1000000LL / 10);
+
+    roughtime_stats(&stats);
+    printf("roughtime: %lu requests, %lu signatures, %lu dropped, %lu delegations\n", (unsigned long)stats.requests,
+           (unsigned long)stats.signatures, (unsigned long)stats.dropped, (unsigned long)stats.delegations);
+    CHECK_EQ(stats.requests, 4);
+    CHECK_EQ(stats.dropped, 2);
+    CHECK_EQ(stats.signatures, 4 + 3);
+    return 0;
+}
@@ -0,0 +1,40 @@
+#!/bin/sh
+# The reference client in roughtime_client/ (Go standard library only) against roughtime_runner on
+# loopback with 1, 4, 16 and 64 concurrent clients. Every response must verify, and the signatures per request must
+# fall as the load rises. Needs Go, skipped otherwise.
+#   test_roughtime_client.sh <roughtime_runner> <roughtime_client dir>
+runner=$1
+client_dir=$2
+requests=${ROUGHTIME_CLIENT_REQUESTS:-200}
+
+command -v go >/dev/null 2>&1 || { echo "go not installed"; exit 77; }
+
+dir=$(mktemp -d)
+cleanup() {
+    kill "$runner_pid" 2>/dev/null
+    rm -rf "$dir"
+}
+trap cleanup EXIT
+
+(cd "$client_dir" && GOTOOLCHAIN=local go build -o "$dir/client" .) || { echo "go build failed"; exit 1; }
+
+"$runner" >"$dir/runner.log" &
+runner_pid=$!
+for _ in 1 2 3 4 5 6 7 8 9 10; do
+    [ -s "$dir/runner.log" ] && break
+    sleep 0.2
+done
+key=$(head -n 1 "$dir/runner.log")
+[ -n "$key" ] || { echo "no public key from the runner"; exit 1; }
+# the idle path delegates within a second of the start
+sleep 1.5
+
+for clients in 1 4 16 64; do
+    "$dir/client" -key "$key" -clients "$clients" -requests "$requests" | tee -a "$dir/client.log" || exit 1
+done
+awk '
+    { clients = $2 + 0; ratio[clients] = $5 / $3; failures += $7 }
+    END {
+        printf "roughtime_client: signatures per request %.3f with 1 client, %.3f with 64\n", ratio[1], ratio[64]
+        exit (failures == 0 && ratio[1] > 0.9 && ratio[64] < ratio[1] / 4) ? 0 : 1
+    }' "$dir/client.log"
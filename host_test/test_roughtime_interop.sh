@@ -0,0 +1,47 @@
+#!/bin/sh
+# getroughtime of Cloudflare's Roughtime implementation (github.com/cloudflare/roughtime) against roughtime_runner on
+# loopback: a client that shares no code with this repository has to accept every response. The client is
+# $ROUGHTIME_INTEROP_CLIENT if set, otherwise built with go install, which needs the module proxy. Skipped when
+# neither works. The signatures per request are checked by test_roughtime_client.sh.
+#   test_roughtime_interop.sh <roughtime_runner> <port>
+runner=$1
+port=$2
+pings=${ROUGHTIME_INTEROP_PINGS:-5}
+module=github.com/cloudflare/roughtime/cmd/getroughtime@${ROUGHTIME_INTEROP_VERSION:-latest}
+
+dir=$(mktemp -d)
+cleanup() {
+    kill "$runner_pid" 2>/dev/null
+    rm -rf "$dir"
+}
+trap cleanup EXIT
+
+client=$ROUGHTIME_INTEROP_CLIENT
+if [ -z "$client" ]; then
+    command -v go >/dev/null 2>&1 || { echo "go not installed"; exit 77; }
+    GOBIN="$dir" GOTOOLCHAIN=local go install "$module" >"$dir/go.log" 2>&1 ||
+        { cat "$dir/go.log"; echo "cannot build $module"; exit 77; }
+    client=$dir/getroughtime
+fi
+# the responder speaks the original Google protocol, newer clients default to the IETF drafts
+version=
+if "$client" -h 2>&1 | grep -q -- -ping-version; then
+    version="-ping-version Google-Roughtime"
+fi
+
+"$runner" >"$dir/runner.log" &
+runner_pid=$!
+for _ in 1 2 3 4 5 6 7 8 9 10; do
+    [ -s "$dir/runner.log" ] && break
+    sleep 0.2
+done
+key=$(head -n 1 "$dir/runner.log")
+[ -n "$key" ] || { echo "no public key from the runner"; exit 1; }
+# the idle path delegates within a second of the start
+sleep 1.5
+
+for i in $(seq "$pings"); do
+    # shellcheck disable=SC2086
+    "$client" -ping "127.0.0.1:$port" -pubkey "$key" $version || { echo "getroughtime rejected response $i"; exit 1; }
+done
+echo "roughtime_interop: $pings responses accepted by getroughtime"
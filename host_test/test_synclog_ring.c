@@ -0,0 +1,108 @@
+// The synclog ring on an emulated flash partition of 4 sectors (512 entries). Entries written in batches
+// read back in order after a restart, also after the ring has been around. A reset during a write leaves a torn
+// entry: the next start must not write over it (flash can only clear bits), the log continues in the next sector
+// and every entry written afterwards reads back valid.
+
+#include <string.h>
+
+#include "esp_partition.h"
+#include "synclog_ring.h"
+#include "test_util.h"
+
+#define SECTORS 4
+#define CAPACITY (SECTORS * SYNCLOG_ENTRIES_PER_SECTOR)
+#define BATCH 16
+
+static synclog_ring_t ring;
+static const esp_partition_t *partition;
+
+static void append(int count) {
+    synclog_entry_t batch[BATCH];
+    while (count > 0) {
+        int n = count < BATCH ? count : BATCH;
+        for (int i = 0; i < n; i++) {
+            batch[i] = (synclog_entry_t){.seq = ring.next_seq++, .time = 1729468800 + 60 * ring.next_seq};
+            batch[i].crc = synclog_entry_crc(&batch[i]);
+        }
+        synclog_ring_write(&ring, batch, n);
+        count -= n;
+    }
+}
+
+// the newest entries read back as last_seq, last_seq - 1, ..., and not one more
+static void check_newest(uint32_t last_seq, uint32_t count) {
+    for (uint32_t back = 1; back <= count; back++) {
+        synclog_entry_t entry;
+        CHECK(synclog_ring_read(&ring, back, &entry));
+        CHECK_EQ(entry.seq, last_seq + 1 - back);
+    }
+}
+
+static void restart(void) {
+    synclog_ring_t before = ring;
+    synclog_ring_open(&ring, partition);
+    CHECK_EQ(ring.next_seq, before.next_seq);
+    CHECK_EQ(ring.next_slot, before.next_slot);
+    CHECK_EQ(ring.written, before.written);
+}
+
+int main(void) {
+    partition = host_partition_create(ESP_PARTITION_TYPE_DATA, SYNCLOG_PARTITION_SUBTYPE, "synclog",
+                                      SECTORS * SYNCLOG_SECTOR_SIZE);
+    CHECK(partition != NULL);
+    synclog_ring_open(&ring, partition);
+    CHECK_EQ(ring.capacity, CAPACITY);
+    CHECK_EQ(ring.written, 0);
+    synclog_entry_t entry;
+    CHECK(!synclog_ring_read(&ring, 1, &entry));
+
+    // first lap, partly into the third sector
+    append(300);
+    restart();
+    CHECK_EQ(ring.written, 300);
+    check_newest(299, 300);
+    CHECK(!synclog_ring_read(&ring, 301, &entry));
+
+    // around the ring: entering a sector drops its oldest entries
+    append(CAPACITY);
+    restart();
+    CHECK_EQ(ring.next_slot, 300);
+    CHECK_EQ(ring.written, CAPACITY - (SYNCLOG_ENTRIES_PER_SECTOR - 300 % SYNCLOG_ENTRIES_PER_SECTOR));
+    check_newest(CAPACITY + 299, ring.written);
+
+    // a reset in the middle of the 6th entry of a batch: 5 entries and a torn one
+    uint32_t torn_slot = ring.next_slot + 5;
+    host_partition_tear_next_write(5 * SYNCLOG_ENTRY_SIZE + 13);
+    uint32_t seq = ring.next_seq;
+    append(BATCH);
+    synclog_ring_open(&ring, partition);
+    CHECK_EQ(ring.next_seq, seq + 5);
+    CHECK_EQ(ring.next_slot, (torn_slot / SYNCLOG_ENTRIES_PER_SECTOR + 1) * SYNCLOG_ENTRIES_PER_SECTOR % CAPACITY);
+    CHECK(!synclog_ring_read(&ring, ring.next_slot - torn_slot, &entry));
+    CHECK(synclog_ring_read(&ring, ring.next_slot - torn_slot + 1, &entry));
+    CHECK_EQ(entry.seq, seq + 4);
+
+    // written after the restart, across the next sector and once more after a restart
+    append(2 * BATCH);
+    restart();
+    check_newest(ring.next_seq - 1, 2 * BATCH);
+    append(SYNCLOG_ENTRIES_PER_SECTOR);
+    restart();
+    check_newest(ring.next_seq - 1, 2 * BATCH + SYNCLOG_ENTRIES_PER_SECTOR);
+
+    // torn in the last slot of a sector
+    append((SYNCLOG_ENTRIES_PER_SECTOR - ring.next_slot % SYNCLOG_ENTRIES_PER_SECTOR - 1) % SYNCLOG_ENTRIES_PER_SECTOR);
+    CHECK_EQ(ring.next_slot % SYNCLOG_ENTRIES_PER_SECTOR, SYNCLOG_ENTRIES_PER_SECTOR - 1);
+    host_partition_tear_next_write(7);
+    seq = ring.next_seq;
+    append(1);
+    synclog_ring_open(&ring, partition);
+    CHECK_EQ(ring.next_seq, seq);
+    CHECK_EQ(ring.next_slot % SYNCLOG_ENTRIES_PER_SECTOR, 0);
+    append(BATCH);
+    restart();
+    check_newest(ring.next_seq - 1, BATCH);
+    printf("synclog_ring: %lu entries written, %lu in the ring, continued after 2 torn writes\n",
+           (unsigned long)ring.next_seq, (unsigned long)ring.written);
+    return 0;
+}
@@ -0,0 +1,155 @@
+// The high resolution time source on a GPTimer at 20 MHz (CLOCK_MONOTONIC_RAW in the stubs), against a
+// system clock backend that is exact to the ns. Measures read cost, resolution and the announced precision, then
+// follows the system clock through calibrations: the error to it, monotonic reads while it runs 500 ppm fast as
+// during a slew, and steps of 10 ms forward and back. Before timebase_hires_start() the source is the microsecond
+// system clock with precision -19.
+
+#include <stdlib.h>
+
+#include "test_util.h"
+#include "timebase.h"
+#include "timebase_hires.h"
+
+#define TICK_NS (1000000000 / CONFIG_TIMEBASE_HIRES_RESOLUTION_HZ)
+#define READS 1000000
+#define ERROR_STRIDE 16  // every 16th read is kept for the error statistics
+#define SETTLE_MS 2000
+#define TRACK_MS 500
+// the calibration pairs the counter with a microsecond read of the system clock
+#define MAX_ERROR_P99_NS 2000
+#define SLEW_PPM 500
+#define SLEW_SETTLE_MS 4000
+#define MAX_SLEW_ERROR_P99_NS 10000  // the calibration intervals vary by a few % on a busy host
+#define STEP_NS 10000000
+
+// realtime = origin + (raw - raw_origin) * (1 + ppm), rebased on every change so a rate change is continuous. The
+// calibration reads it from the timer thread without a lock: a change writes the unused slot, then publishes it.
+typedef struct {
+    int64_t raw_origin_ns;
+    int64_t origin_ns;
+    double ppm;
+} sys_clock_t;
+
+static sys_clock_t sys_slots[2];
+static _Atomic(const sys_clock_t *) sys = &sys_slots[0];
+
+static int64_t sys_ns_at(const sys_clock_t *c, int64_t raw_ns) {
+    return c->origin_ns + (raw_ns - c->raw_origin_ns) + (int64_t)((raw_ns - c->raw_origin_ns) * c->ppm / 1e6);
+}
+
+static int64_t sys_ns(void) { return sys_ns_at(sys, test_clock_ns(CLOCK_MONOTONIC_RAW)); }
+
+static void sys_change(double ppm, int64_t step_ns) {
+    const sys_clock_t *current = sys;
+    sys_clock_t *next = current == &sys_slots[0] ? &sys_slots[1] : &sys_slots[0];
+    int64_t raw = test_clock_ns(CLOCK_MONOTONIC_RAW);
+    *next = (sys_clock_t){.raw_origin_ns = raw, .origin_ns = sys_ns_at(current, raw) + step_ns, .ppm = ppm};
+    sys = next;
+}
+
+static int64_t sys_monotonic_us(void *ctx) { return test_clock_ns(CLOCK_MONOTONIC_RAW) / 1000; }
+
+static void sys_realtime(void *ctx, struct timeval *tv) {
+    int64_t ns = sys_ns();
+    tv->tv_sec = ns / 1000000000;
+    tv->tv_usec = ns % 1000000000 / 1000;
+}
+
+static const timebase_backend_t backend = {.monotonic_us = sys_monotonic_us, .realtime = sys_realtime};
+
+static int compare_i64(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int64_t errors_ns[READS];
+
+// reads for ms milliseconds: the reads never go back, returns the p99 of the absolute error to the system clock
+static int64_t track(int ms, int64_t *max_ns) {
+    int n = 0;
+    int64_t prev = 0;
+    int64_t until = test_clock_ns(CLOCK_MONOTONIC) + ms * 1000000LL;
+    for (uint32_t i = 0; test_clock_ns(CLOCK_MONOTONIC) < until; i++) {
+        int64_t before = sys_ns();
+        int64_t ns = (int64_t)timebase_hires_realtime_ns();
+        int64_t after = sys_ns();
+        CHECK(ns >= prev);
+        prev = ns;
+        if (i % ERROR_STRIDE == 0 && n < READS) {
+            errors_ns[n++] = ns < before ? before - ns : ns > after ? ns - after : 0;
+        }
+    }
+    qsort(errors_ns, n, sizeof(errors_ns[0]), compare_i64);
+    *max_ns = errors_ns[n - 1];
+    return errors_ns[n * 99 / 100];
+}
+
+static void sleep_ms(int ms) {
+    struct timespec d = {.tv_sec = ms / 1000, .tv_nsec = ms % 1000 * 1000000L};
+    nanosleep(&d, NULL);
+}
+
+int main(void) {
+    sys_change(0, 1729468800LL * 1000000000 - sys_ns());
+    timebase_set_backend(&backend);
+
+    // not started: the system clock in microseconds
+    struct timeval tv;
+    timebase_realtime(&tv);
+    uint64_t ns = timebase_hires_realtime_ns();
+    CHECK_EQ(ns % 1000, 0);
+    CHECK(ns / 1000 - ((uint64_t)tv.tv_sec * 1000000 + tv.tv_usec) < 1000);
+    CHECK_EQ(timebase_hires_precision(), -19);
+
+    timebase_hires_start();
+
+    // read cost and resolution, the precision covers the larger of the two
+    int64_t start = test_clock_ns(CLOCK_MONOTONIC);
+    uint64_t prev = timebase_hires_realtime_ns();
+    uint64_t min_step = UINT64_MAX;
+    for (int i = 0; i < READS; i++) {
+        ns = timebase_hires_realtime_ns();
+        if (ns > prev && ns - prev < min_step) {
+            min_step = ns - prev;
+        }
+        prev = ns;
+    }
+    double read_cost_ns = (double)(test_clock_ns(CLOCK_MONOTONIC) - start) / READS;
+    int8_t precision = timebase_hires_precision();
+    double precision_ns = 1e9 / (double)(1LL << -precision);
+    printf("timebase_hires: read cost %.1f ns, smallest step %llu ns, tick %d ns, precision %d (%.1f ns)\n",
+           read_cost_ns, (unsigned long long)min_step, TICK_NS, precision, precision_ns);
+    CHECK(min_step >= TICK_NS - 1 && min_step < 1000);
+    CHECK(precision_ns >= TICK_NS);
+    CHECK(precision < -19);
+
+    int64_t max_ns;
+    sleep_ms(SETTLE_MS);
+    int64_t p99_ns = track(TRACK_MS, &max_ns);
+    printf("timebase_hires: error to the system clock p99 %lld ns, max %lld ns\n", (long long)p99_ns,
+           (long long)max_ns);
+    CHECK(p99_ns <= MAX_ERROR_P99_NS);
+
+    // a slew: monotonic while the rate changes, the error grows until the next calibration (at most 1.5 s on a busy
+    // host) and is steered out over the following ones
+    sys_change(SLEW_PPM, 0);
+    track(SLEW_SETTLE_MS, &max_ns);
+    printf("timebase_hires: %d ppm fast, error up to %lld ns until calibrated\n", SLEW_PPM, (long long)max_ns);
+    CHECK(max_ns <= SLEW_PPM * 1500);
+    p99_ns = track(TRACK_MS, &max_ns);
+    printf("timebase_hires: %d ppm fast, error p99 %lld ns, max %lld ns\n", SLEW_PPM, (long long)p99_ns,
+           (long long)max_ns);
+    CHECK(p99_ns <= MAX_SLEW_ERROR_P99_NS);
+    sys_change(0, 0);
+
+    // steps forward and back, the next calibration starts over from the system clock
+    for (int sign = 1; sign >= -1; sign -= 2) {
+        sys_change(0, sign * STEP_NS);
+        sleep_ms(SETTLE_MS);
+        p99_ns = track(TRACK_MS, &max_ns);
+        printf("timebase_hires: stepped by %+d ms, error p99 %lld ns, max %lld ns\n", sign * STEP_NS / 1000000,
+               (long long)p99_ns, (long long)max_ns);
+        CHECK(p99_ns <= MAX_ERROR_P99_NS);
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+// The allocation free civil time conversions against glibc every 30 minutes from 2000 to 2099, and the
+// DCF77 and MSF decoding of every minute within 3 minutes of each summer time change from 2000 to 2099 against
+// glibc localtime() with the POSIX rules of CET/CEST and GMT/BST. Frames with a date that does not exist or a wrong
+// weekday must be rejected.
+
+#include <string.h>
+
+#include "civil_time.h"
+#include "test_util.h"
+#include "timecode_formats.h"
+#include "timecode_synth.h"
+
+#define FIRST_YEAR 2000
+#define LAST_YEAR 2099
+
+static void test_civil_time(void) {
+    time_t start = 946684800;  // 2000-01-01
+    time_t end = 4102444800;   // 2100-01-01
+    for (time_t t = start; t < end; t += 1800) {
+        struct tm expected, tm;
+        gmtime_r(&t, &expected);
+        civil_from_unix(t, &tm);
+        if (tm.tm_year != expected.tm_year || tm.tm_mon != expected.tm_mon || tm.tm_mday != expected.tm_mday ||
+            tm.tm_hour != expected.tm_hour || tm.tm_min != expected.tm_min || tm.tm_wday != expected.tm_wday ||
+            tm.tm_yday != expected.tm_yday) {
+            fprintf(stderr, "civil_from_unix(%lld) differs from gmtime\n", (long long)t);
+            exit(1);
+        }
+        CHECK_EQ(civil_to_unix(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec), t);
+        CHECK_EQ(civil_yday_to_unix(tm.tm_year + 1900, tm.tm_yday + 1, tm.tm_hour, tm.tm_min, tm.tm_sec), t);
+    }
+}
+
+// the UTC times of the summer time changes of a year, found with glibc
+static int transitions(int year, time_t out[2]) {
+    int count = 0;
+    struct tm before;
+    time_t t = civil_to_unix(year, 1, 1, 0, 0, 0);
+    localtime_r(&t, &before);
+    for (time_t end = civil_to_unix(year + 1, 1, 1, 0, 0, 0); t < end && count < 2; t += 3600) {
+        struct tm now;
+        localtime_r(&t, &now);
+        if (now.tm_isdst != before.tm_isdst) {
+            out[count++] = t;
+        }
+        before = now;
+    }
+    return count;
+}
+
+static void check_minute(const timecode_synth_t *synth, time_t marker) {
+    const timecode_format_t *fmt = synth->fmt;
+    timecode_frame_t frame;
+    timecode_time_t time;
+    timecode_synth_frame(synth, marker - 60, &frame);
+    if (!timecode_decode(fmt, &frame, &time) || timecode_utc(fmt, &time) != marker) {
+        fprintf(stderr, "%s: minute %lld not decoded\n", fmt->name, (long long)marker);
+        exit(1);
+    }
+    struct tm local;
+    localtime_r(&marker, &local);
+    int wday = local.tm_wday == 0 ? fmt->wday_sunday : local.tm_wday;
+    if (time.field[TC_YEAR] != local.tm_year + 1900 || time.field[TC_MONTH] != local.tm_mon + 1 ||
+        time.field[TC_MDAY] != local.tm_mday || time.field[TC_HOUR] != local.tm_hour ||
+        time.field[TC_MINUTE] != local.tm_min || time.field[TC_WDAY] != wday ||
+        time.field[TC_DST] != local.tm_isdst || time.utc_offset_min * 60 != local.tm_gmtoff) {
+        fprintf(stderr, "%s: minute %lld decoded as %04d-%02d-%02d %02d:%02d wday %d dst %d, localtime differs\n",
+                fmt->name, (long long)marker, time.field[TC_YEAR], time.field[TC_MONTH], time.field[TC_MDAY],
+                time.field[TC_HOUR], time.field[TC_MINUTE], time.field[TC_WDAY], time.field[TC_DST]);
+        exit(1);
+    }
+}
+
+static int test_transitions(const timecode_format_t *fmt, const char *tz) {
+    setenv("TZ", tz, 1);
+    tzset();
+    timecode_synth_t synth;
+    timecode_synth_init(&synth, fmt);
+    int checked = 0;
+    for (int year = FIRST_YEAR; year <= LAST_YEAR; year++) {
+        time_t change[2];
+        CHECK_EQ(transitions(year, change), 2);
+        for (int i = 0; i < 2; i++) {
+            for (time_t marker = change[i] - 180; marker <= change[i] + 180; marker += 60) {
+                check_minute(&synth, marker);
+                checked++;
+            }
+        }
+    }
+    return checked;
+}
+
+static void test_invalid_dates(void) {
+    const timecode_format_t *fmt = &timecode_format_dcf77;
+    timecode_synth_t synth;
+    timecode_synth_init(&synth, fmt);
+    timecode_frame_t frame, bad;
+    timecode_time_t time;
+
+    // 2024-02-29 08:00 UTC is a Thursday
+    timecode_synth_frame(&synth, 1709193600 - 60, &frame);
+    CHECK(timecode_decode(fmt, &frame, &time));
+    CHECK_EQ(time.field[TC_WDAY], 4);
+    bad = frame;
+    timecode_synth_set_field(fmt, &bad, TC_WDAY, 5);
+    CHECK(!timecode_decode(fmt, &bad, &time));
+    // February 29th of a common year, with its weekday
+    bad = frame;
+    timecode_synth_set_field(fmt, &bad, TC_YEAR, 23);
+    timecode_synth_set_field(fmt, &bad, TC_WDAY, 3);
+    CHECK(!timecode_decode(fmt, &bad, &time));
+    bad = frame;
+    timecode_synth_set_field(fmt, &bad, TC_MONTH, 4);
+    timecode_synth_set_field(fmt, &bad, TC_MDAY, 31);
+    CHECK(!timecode_decode(fmt, &bad, &time));
+    // Sunday is 7, not 0
+    timecode_synth_frame(&synth, 1709424000 - 60, &frame);  // 2024-03-03, a Sunday
+    CHECK(timecode_decode(fmt, &frame, &time));
+    CHECK_EQ(time.field[TC_WDAY], 7);
+    timecode_synth_set_field(fmt, &frame, TC_WDAY, 0);
+    CHECK(!timecode_decode(fmt, &frame, &time));
+
+    // day 366 only exists in leap years
+    fmt = &timecode_format_wwvb;
+    timecode_synth_init(&synth, fmt);
+    timecode_synth_frame(&synth, 1735689540, &frame);  // 2024-12-31 23:59 UTC, day 366
+    CHECK(timecode_decode(fmt, &frame, &time));
+    CHECK_EQ(time.field[TC_YDAY], 366);
+    timecode_synth_set_field(fmt, &frame, TC_YEAR, 25);
+    CHECK(!timecode_decode(fmt, &frame, &time));
+
+    // JJY counts the weekday from Sunday = 0
+    fmt = &timecode_format_jjy;
+    timecode_synth_init(&synth, fmt);
+    timecode_synth_frame(&synth, 1709424000, &frame);
+    CHECK(timecode_decode(fmt, &frame, &time));
+    timecode_synth_set_field(fmt, &frame, TC_WDAY, (time.field[TC_WDAY] + 1) % 7);
+    CHECK(!timecode_decode(fmt, &frame, &time));
+}
+
+int main(void) {
+    test_civil_time();
+    int dcf77 = test_transitions(&timecode_format_dcf77, "CET-1CEST,M3.5.0,M10.5.0/3");
+    int msf = test_transitions(&timecode_format_msf, "GMT0BST,M3.5.0/1,M10.5.0");
+    test_invalid_dates();
+    printf("timecode_dst: %d DCF77 and %d MSF minutes around the summer time changes %d-%d\n", dcf77, msf,
+           FIRST_YEAR, LAST_YEAR);
+    return 0;
+}
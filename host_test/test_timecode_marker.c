@@ -0,0 +1,87 @@
+// A glitch in the gap before the DCF77 minute marker: a 100 ms pulse 1.7 to 1.9 s after the second 58 pulse looks
+// like the marker, 100 to 300 ms early, and the frame before it decodes. The real second 0 pulse follows too early to
+// confirm it, so the frame has to be dropped: no minute may be reported with a wrong marker, and the receiver has to
+// decode again from the minute after next.
+
+#include "test_util.h"
+#include "timecode_formats.h"
+#include "timecode_rx.h"
+#include "timecode_synth.h"
+
+#define FIRST_MINUTE 1729990620  // 2024-10-27 00:57 UTC, across the end of summer time
+#define MINUTES 7
+#define GLITCH_MINUTE 3  // the glitch is in the gap at the end of this minute
+#define GLITCH_US 100000
+#define START_US 10000000
+
+typedef struct {
+    timecode_rx_t rx;
+    uint64_t glitch_us;  // start of the glitch pulse, 0 for none or once it was sent
+    uint64_t minute_us[MINUTES + 1];
+    int correct;
+    int wrong;
+    int invalid;
+} run_t;
+
+static void rx_edge(run_t *run, uint64_t time_us, bool active) {
+    timecode_time_t time;
+    uint64_t marker_us;
+    timecode_rx_result_t result = timecode_rx_edge(&run->rx, time_us, active, &time, &marker_us);
+    run->invalid += result == TC_RX_INVALID;
+    if (result != TC_RX_TIME) {
+        return;
+    }
+    // the decoded minute starts at its marker
+    for (int m = 0; m <= MINUTES; m++) {
+        if (marker_us == run->minute_us[m] && timecode_utc(&timecode_format_dcf77, &time) == FIRST_MINUTE + 60 * m) {
+            run->correct++;
+            return;
+        }
+    }
+    run->wrong++;
+}
+
+static void synth_edge(void *ctx, uint64_t time_us, bool active) {
+    run_t *run = ctx;
+    if (run->glitch_us != 0 && time_us >= run->glitch_us) {
+        rx_edge(run, run->glitch_us, true);
+        rx_edge(run, run->glitch_us + GLITCH_US, false);
+        run->glitch_us = 0;
+    }
+    rx_edge(run, time_us, active);
+}
+
+// minutes 0 to MINUTES, the receiver synchronizes at the marker of minute 1 and decodes from minute 2 on
+static void run(uint32_t glitch_after_58_us, run_t *r) {
+    timecode_synth_t synth;
+    timecode_synth_init(&synth, &timecode_format_dcf77);
+    *r = (run_t){0};
+    timecode_rx_init(&r->rx, &timecode_format_dcf77);
+    uint64_t t = START_US;
+    for (int m = 0; m <= MINUTES; m++) {
+        r->minute_us[m] = t;
+        if (glitch_after_58_us != 0 && m == GLITCH_MINUTE) {
+            r->glitch_us = t + 58000000 + glitch_after_58_us;
+        }
+        t += timecode_synth_minute(&synth, FIRST_MINUTE + 60 * (time_t)m, t, synth_edge, r);
+    }
+}
+
+int main(void) {
+    run_t r;
+    run(0, &r);
+    CHECK_EQ(r.correct, MINUTES - 1);
+    CHECK_EQ(r.invalid, 0);
+
+    static const uint32_t glitches_us[] = {1710000, 1750000, 1800000, 1850000, 1890000};
+    for (size_t i = 0; i < sizeof(glitches_us) / sizeof(glitches_us[0]); i++) {
+        run(glitches_us[i], &r);
+        printf("timecode_marker: glitch %.2f s after second 58: %d correct, %d wrong, %d invalid\n",
+               glitches_us[i] / 1e6, r.correct, r.wrong, r.invalid);
+        // the frame ending at the glitch is dropped, the next minute synchronizes again
+        CHECK_EQ(r.wrong, 0);
+        CHECK_EQ(r.invalid, 1);
+        CHECK_EQ(r.correct, MINUTES - 3);
+    }
+    return 0;
+}
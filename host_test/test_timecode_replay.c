@@ -0,0 +1,73 @@
+// Replays a recorded or generated edge corpus (corpus/*.edges, see timecode_gen.c) through the receiver
+// front end and checks every decoded minute against the expected UTC and marker time, in order.
+//   test_timecode_replay <dcf77|msf|wwvb|jjy> <corpus file>
+
+#include <string.h>
+#include <strings.h>
+
+#include "test_util.h"
+#include "timecode_formats.h"
+#include "timecode_rx.h"
+
+static const timecode_format_t *format_by_name(const char *name) {
+    static const timecode_format_t *formats[] = {&timecode_format_dcf77, &timecode_format_msf, &timecode_format_wwvb,
+                                                 &timecode_format_jjy};
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        if (strcasecmp(formats[i]->name, name) == 0) {
+            return formats[i];
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    const timecode_format_t *fmt = argc == 3 ? format_by_name(argv[1]) : NULL;
+    CHECK(fmt != NULL);
+    FILE *corpus = fopen(argv[2], "r");
+    CHECK(corpus != NULL);
+
+    timecode_rx_t rx;
+    timecode_rx_init(&rx, fmt);
+    char line[128];
+    int line_no = 0, decoded = 0;
+    while (fgets(line, sizeof(line), corpus) != NULL) {
+        line_no++;
+        unsigned long long time_us;
+        int level;
+        if (line[0] == '#') {
+            continue;
+        }
+        if (line[0] == '=') {
+            // a decoded minute is consumed together with the edge that ends the pulse after its marker
+            fprintf(stderr, "%s:%d: minute not decoded: %s", argv[2], line_no, line);
+            return 1;
+        }
+        CHECK(sscanf(line, "%llu %d", &time_us, &level) == 2);
+        timecode_time_t time;
+        uint64_t marker_us = 0;
+        timecode_rx_result_t result = timecode_rx_edge(&rx, time_us, level == fmt->active_level, &time, &marker_us);
+        CHECK(result != TC_RX_INVALID);
+        if (result == TC_RX_TIME) {
+            decoded++;
+            // the "=" line that follows the edge
+            long long utc = timecode_utc(fmt, &time);
+            char next[128];
+            CHECK(fgets(next, sizeof(next), corpus) != NULL);
+            line_no++;
+            long long expect_utc;
+            unsigned long long expect_marker;
+            CHECK(sscanf(next, "= %lld %llu", &expect_utc, &expect_marker) == 2);
+            if (utc != expect_utc || marker_us != expect_marker) {
+                fprintf(stderr, "%s:%d: decoded %lld at %llu, expected %lld at %llu\n", argv[2], line_no, utc,
+                        (unsigned long long)marker_us, expect_utc, expect_marker);
+                return 1;
+            }
+        }
+    }
+    fclose(corpus);
+    CHECK(decoded > 0);
+    CHECK_EQ(rx.stats.frames_invalid, 0);
+    CHECK_EQ(rx.stats.invalid_pulses, 0);
+    printf("%s: %d minutes decoded, %lu pulses\n", fmt->name, decoded, (unsigned long)rx.stats.pulses);
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Every station format decoded through the receiver front end across the minute, hour, day, month and year
+// rollovers in UTC and in the local time of the station, the EU summer time changes, February 29th and the 2016 leap
+// second (DCF77). Each case runs 5 minutes before to 5 minutes after the change, once with ideal edges and once
+// with mild impairments (20 ms edge jitter, 300 ppm receiver drift), and every minute must be decoded correctly.
+
+#include "test_util.h"
+#include "timecode_formats.h"
+#include "timecode_impair.h"
+
+#define CASE_MINUTES 10
+
+typedef struct {
+    const char *name;
+    time_t change;  // UTC, a full minute
+    time_t leap_minute;
+} rollover_t;
+
+static const rollover_t cases[] = {
+    {"new year UTC", 1735689600, 0},          // 2025-01-01 00:00 UTC
+    {"new year CET", 1735686000, 0},          // 2024-12-31 23:00 UTC
+    {"new year JST", 1735657200, 0},          // 2024-12-31 15:00 UTC
+    {"February 29th to March UTC", 1709251200, 0},
+    {"February 29th to March CET", 1709247600, 0},
+    {"February 28th to 29th UTC", 1709164800, 0},
+    {"end of June UTC", 1719792000, 0},
+    {"end of June CEST", 1719784800, 0},      // 2024-06-30 22:00 UTC
+    {"summer time start", 1711846800, 0},     // 2024-03-31 01:00 UTC
+    {"summer time end", 1729990800, 0},       // 2024-10-27 01:00 UTC
+    {"leap second", 1483228800, 1483228740},  // 2016-12-31 23:59:60 UTC
+};
+
+static const timecode_format_t *const formats[] = {&timecode_format_dcf77, &timecode_format_msf,
+                                                   &timecode_format_wwvb, &timecode_format_jjy};
+
+static void run_case(const timecode_format_t *fmt, const rollover_t *c, const timecode_impair_config_t *config) {
+    timecode_synth_t synth;
+    timecode_synth_init(&synth, fmt);
+    synth.leap_minute = c->leap_minute;
+    timecode_impair_result_t result;
+    timecode_impair_run(&synth, config, c->change - 60 * CASE_MINUTES / 2, CASE_MINUTES, 0, &result);
+    if (result.correct != CASE_MINUTES || result.wrong != 0 || result.invalid != 0) {
+        fprintf(stderr, "%s %s (jitter %lu us): %d of %d minutes correct, %d wrong, %d invalid\n", fmt->name,
+                c->name, (unsigned long)config->jitter_us, result.correct, CASE_MINUTES, result.wrong,
+                result.invalid);
+        exit(1);
+    }
+}
+
+int main(void) {
+    const timecode_impair_config_t ideal = {0};
+    const timecode_impair_config_t mild = {.jitter_us = 20000, .drift_ppm = 300, .seed = 7};
+    int runs = 0;
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+            // only DCF77 announces leap seconds
+            if (cases[i].leap_minute != 0 && formats[f]->leap_announce_bit == 0) {
+                continue;
+            }
+            run_case(formats[f], &cases[i], &ideal);
+            run_case(formats[f], &cases[i], &mild);
+            runs += 2;
+        }
+    }
+    printf("timecode_rollover: %d runs of %d minutes decoded\n", runs, CASE_MINUTES);
+    return 0;
+}
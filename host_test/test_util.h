@@ -0,0 +1,35 @@
+#pragma once
+
+// Minimal checks for the host tests: a failed CHECK prints the location and ends the test with exit code 1,
+// TEST_SKIP (77) tells ctest that a test could not run here, e.g. because an external tool is missing.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define TEST_SKIP 77
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                        \
+        }                                                                   \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                                         \
+    do {                                                                                                       \
+        long long a_ = (long long)(a), b_ = (long long)(b);                                                    \
+        if (a_ != b_) {                                                                                        \
+            fprintf(stderr, "%s:%d: CHECK_EQ failed: %s == %lld, %s == %lld\n", __FILE__, __LINE__, #a, a_, #b, \
+                    b_);                                                                                       \
+            exit(1);                                                                                           \
+        }                                                                                                      \
+    } while (0)
+
+static inline int64_t test_clock_ns(clockid_t clock) {
+    struct timespec t;
+    clock_gettime(clock, &t);
+    return (int64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
@@ -0,0 +1,95 @@
+// Writes a replay corpus: the receiver edges of consecutive minutes from timecode_synth, with a deterministic
+// timing jitter, and the minutes the decoder must report.
+//   timecode_gen <dcf77|msf|wwvb|jjy> <first minute, Unix time> <minutes> [jitter µs] [leap minute, Unix time]
+// Output lines: "<time µs> <1|0>" for a pulse start or end, "= <UTC> <marker µs>" for a decoded minute after the
+// end of the pulse that follows its marker. The corpus starts two seconds before the first minute, so every format
+// is synchronized at its first marker.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "timecode_formats.h"
+#include "timecode_synth.h"
+
+#define START_US 1000000ULL
+
+typedef struct {
+    uint64_t skip_before_us;
+    uint64_t skip_after_us;
+    uint32_t jitter_us;
+    uint32_t seed;
+    time_t expect_utc;       // decoded minute reported at the end of the pulse after its marker, 0 if none
+    uint64_t marker_us;      // jittered start of its marker pulse
+    int pulse_ends;          // of the minute since the marker
+} gen_t;
+
+static uint32_t next_random(gen_t *gen) {
+    gen->seed = gen->seed * 1664525 + 1013904223;
+    return gen->seed >> 8;
+}
+
+static void write_edge(void *ctx, uint64_t time_us, bool active) {
+    gen_t *gen = ctx;
+    if (time_us < gen->skip_before_us || time_us >= gen->skip_after_us) {
+        return;
+    }
+    if (gen->jitter_us > 0) {
+        time_us += next_random(gen) % (2 * gen->jitter_us + 1);
+        time_us -= gen->jitter_us;
+    }
+    if (active && gen->expect_utc != 0 && gen->pulse_ends == 0) {
+        gen->marker_us = time_us;
+    }
+    printf("%llu %d\n", (unsigned long long)time_us, active);
+    if (!active && gen->expect_utc != 0 && ++gen->pulse_ends == 2) {
+        printf("= %lld %llu\n", (long long)gen->expect_utc, (unsigned long long)gen->marker_us);
+        gen->expect_utc = 0;
+        gen->pulse_ends = 0;
+    }
+}
+
+static const timecode_format_t *format_by_name(const char *name) {
+    static const timecode_format_t *formats[] = {&timecode_format_dcf77, &timecode_format_msf, &timecode_format_wwvb,
+                                                 &timecode_format_jjy};
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        if (strcasecmp(formats[i]->name, name) == 0) {
+            return formats[i];
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    const timecode_format_t *fmt = argc >= 4 ? format_by_name(argv[1]) : NULL;
+    if (fmt == NULL) {
+        fprintf(stderr, "usage: %s <dcf77|msf|wwvb|jjy> <first minute> <minutes> [jitter us] [leap minute]\n",
+                argv[0]);
+        return 2;
+    }
+    time_t minute = strtoll(argv[2], NULL, 10);
+    int minutes = atoi(argv[3]);
+    gen_t gen = {.skip_after_us = UINT64_MAX, .jitter_us = argc > 4 ? atoi(argv[4]) : 0, .seed = 1};
+    timecode_synth_t synth;
+    timecode_synth_init(&synth, fmt);
+    synth.leap_minute = argc > 5 ? strtoll(argv[5], NULL, 10) : 0;
+
+    printf("# %s receiver edges, timecode_gen %s %s %s %s %s\n", fmt->name, argv[1], argv[2], argv[3],
+           argc > 4 ? argv[4] : "0", argc > 5 ? argv[5] : "0");
+    // the end of the minute before, its last two seconds synchronize the receiver
+    uint64_t start_us = START_US;
+    gen.skip_before_us = start_us + 58 * 1000000ULL;
+    start_us += timecode_synth_minute(&synth, minute - 60, start_us, write_edge, &gen);
+    for (int i = 0; i <= minutes; i++) {
+        if (i > 0) {
+            // the frame of the minute before ends with the first pulse of this one, the second confirms it
+            gen.expect_utc = minute;
+        }
+        if (i == minutes) {
+            gen.skip_after_us = start_us + 2000000;
+        }
+        start_us += timecode_synth_minute(&synth, minute, start_us, write_edge, &gen);
+        minute += 60;
+    }
+    return 0;
+}
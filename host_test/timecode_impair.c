@@ -0,0 +1,217 @@
+#include "timecode_impair.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "timecode_rx.h"
+
+#define GLITCH_MIN_US 5000
+#define GLITCH_MAX_US 40000
+// receiver output without carrier: pulses of any width at a few per second
+#define FADE_NOISE_PER_S 3.0
+#define FADE_NOISE_MIN_US 10000
+#define FADE_NOISE_MAX_US 400000
+// a decoded minute is correct if its marker is within the edge jitter plus this of the transmitted one
+#define MARKER_TOLERANCE_US 20000
+#define RUN_START_US 1000000ULL
+
+static uint32_t next_random(timecode_impair_t *impair) {
+    // xorshift32
+    uint32_t x = impair->random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    impair->random = x;
+    return x;
+}
+
+// uniform in [0, 1)
+static double uniform(timecode_impair_t *impair) { return (next_random(impair) >> 8) * (1.0 / (1 << 24)); }
+
+static uint64_t uniform_us(timecode_impair_t *impair, uint32_t min_us, uint32_t max_us) {
+    return min_us + (uint64_t)(uniform(impair) * (max_us - min_us));
+}
+
+// time to the next event of a Poisson process, UINT64_MAX / 2 for rate 0
+static uint64_t exponential_us(timecode_impair_t *impair, double per_s) {
+    if (per_s <= 0) {
+        return UINT64_MAX / 2;
+    }
+    return (uint64_t)(-log(1.0 - uniform(impair)) / per_s * 1e6);
+}
+
+void timecode_impair_init(timecode_impair_t *impair, const timecode_impair_config_t *config,
+                          timecode_synth_edge_fn edge, void *ctx) {
+    *impair = (timecode_impair_t){.config = *config, .edge = edge, .ctx = ctx, .random = config->seed | 1};
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static bool in_fade(const timecode_impair_t *impair, uint64_t from_us, uint64_t to_us) {
+    return from_us < impair->fade_end_us && to_us > impair->fade_start_us;
+}
+
+// adds an interval [start, end) that inverts the signal, clipped to the window
+static int add_toggle(uint64_t *toggles, int n, uint64_t start, uint64_t end, uint64_t window_start,
+                      uint64_t window_end) {
+    start = start > window_start ? start : window_start + 1;
+    end = end < window_end ? end : window_end;
+    if (start >= end || n + 2 > TIMECODE_IMPAIR_MAX_TOGGLES) {
+        return n;
+    }
+    toggles[n] = start;
+    toggles[n + 1] = end;
+    return n + 2;
+}
+
+// emits the output between the end of the last window and the end of a pulse: the jittered pulse unless it is
+// dropped or faded, with glitches and fade noise inverting the signal. Toggles at the same time cancel.
+static void emit_window(timecode_impair_t *impair, uint64_t start_us, uint64_t end_us) {
+    const timecode_impair_config_t *c = &impair->config;
+    uint64_t window_start = impair->last_us;
+    uint64_t window_end = end_us + c->jitter_us + 1;
+    uint64_t toggles[TIMECODE_IMPAIR_MAX_TOGGLES];
+    int n = 0;
+
+    // a fade that starts before the end of this window
+    while (impair->fade_end_us <= window_start) {
+        impair->fade_start_us += exponential_us(impair, c->fades_per_hour / 3600);
+        impair->fade_end_us = impair->fade_start_us + c->fade_s * 1000000ULL;
+        impair->next_fade_noise_us = impair->fade_start_us;
+    }
+
+    if (!in_fade(impair, start_us, end_us) && uniform(impair) >= c->dropout) {
+        uint64_t start = start_us + uniform_us(impair, 0, 2 * c->jitter_us + 1) - c->jitter_us;
+        uint64_t end = end_us + uniform_us(impair, 0, 2 * c->jitter_us + 1) - c->jitter_us;
+        n = add_toggle(toggles, n, start, end > start ? end : start + 1, window_start, window_end);
+    }
+    while (impair->next_glitch_us < window_end) {
+        uint64_t g = impair->next_glitch_us;
+        n = add_toggle(toggles, n, g, g + uniform_us(impair, GLITCH_MIN_US, GLITCH_MAX_US), window_start, window_end);
+        impair->next_glitch_us += exponential_us(impair, c->glitches_per_s);
+    }
+    while (impair->next_fade_noise_us < window_end && impair->next_fade_noise_us < impair->fade_end_us) {
+        uint64_t t = impair->next_fade_noise_us;
+        if (t >= impair->fade_start_us) {
+            n = add_toggle(toggles, n, t, t + uniform_us(impair, FADE_NOISE_MIN_US, FADE_NOISE_MAX_US), window_start,
+                           window_end);
+        }
+        impair->next_fade_noise_us = t + exponential_us(impair, FADE_NOISE_PER_S);
+    }
+    impair->last_us = window_end;
+
+    qsort(toggles, n, sizeof(toggles[0]), compare_u64);
+    bool active = false;
+    for (int i = 0; i < n; i++) {
+        if (i + 1 < n && toggles[i + 1] == toggles[i]) {
+            i++;
+            continue;
+        }
+        active = !active;
+        uint64_t t = toggles[i] - impair->origin_us;
+        impair->edge(impair->ctx, impair->origin_us + t + (uint64_t)(t * c->drift_ppm / 1e6), active);
+    }
+}
+
+void timecode_impair_edge(void *ctx, uint64_t time_us, bool active) {
+    timecode_impair_t *impair = ctx;
+    if (!impair->started) {
+        impair->started = true;
+        impair->origin_us = time_us;
+        impair->last_us = time_us - 1;
+        impair->next_glitch_us = time_us + exponential_us(impair, impair->config.glitches_per_s);
+        impair->fade_start_us = time_us;
+        impair->fade_end_us = time_us;
+        impair->next_fade_noise_us = time_us;
+    }
+    if (active) {
+        impair->pulse_start_us = time_us;
+    } else if (time_us > impair->last_us) {
+        emit_window(impair, impair->pulse_start_us > impair->last_us ? impair->pulse_start_us : impair->last_us + 1,
+                    time_us);
+    }
+}
+
+typedef struct {
+    timecode_impair_t impair;
+    timecode_rx_t rx;
+    uint64_t skip_before_us;
+    uint64_t skip_after_us;
+    uint64_t start_us;          // output time of the first edge
+    const uint64_t *minute_us;  // synthesized start of each minute from first_minute - 60
+    time_t first_minute;
+    int minutes;
+    timecode_impair_result_t *result;
+} run_t;
+
+static void run_rx_edge(void *ctx, uint64_t time_us, bool active) {
+    run_t *run = ctx;
+    timecode_time_t time;
+    uint64_t marker_us;
+    timecode_rx_result_t r = timecode_rx_edge(&run->rx, time_us, active, &time, &marker_us);
+    if (r == TC_RX_INVALID) {
+        run->result->invalid++;
+    }
+    if (r != TC_RX_TIME) {
+        return;
+    }
+    const timecode_impair_config_t *c = &run->impair.config;
+    int64_t index = ((int64_t)timecode_utc(run->rx.fmt, &time) - (run->first_minute - 60)) / 60;
+    bool correct = false;
+    if ((timecode_utc(run->rx.fmt, &time) - run->first_minute) % 60 == 0 && index >= 0 && index <= run->minutes) {
+        uint64_t t = run->minute_us[index] - run->impair.origin_us;
+        int64_t expect = run->impair.origin_us + t + (uint64_t)(t * c->drift_ppm / 1e6);
+        correct = llabs((int64_t)marker_us - expect) <= (int64_t)c->jitter_us + MARKER_TOLERANCE_US;
+    }
+    if (!correct) {
+        run->result->wrong++;
+        return;
+    }
+    if (index >= 2) {
+        run->result->correct++;
+    }
+    if (run->result->first_correct_us < 0) {
+        run->result->first_correct_us = time_us - run->start_us;
+    }
+}
+
+static void run_synth_edge(void *ctx, uint64_t time_us, bool active) {
+    run_t *run = ctx;
+    if (time_us >= run->skip_before_us && time_us < run->skip_after_us) {
+        if (!run->impair.started) {
+            run->start_us = time_us;
+        }
+        timecode_impair_edge(&run->impair, time_us, active);
+    }
+}
+
+void timecode_impair_run(const timecode_synth_t *synth, const timecode_impair_config_t *config, time_t first_minute,
+                         int minutes, uint64_t start_offset_us, timecode_impair_result_t *result) {
+    *result = (timecode_impair_result_t){.minutes = minutes, .first_correct_us = -1};
+    uint64_t *minute_us = malloc((minutes + 2) * sizeof(uint64_t));
+    run_t run = {
+        .skip_before_us = RUN_START_US + start_offset_us,
+        .skip_after_us = UINT64_MAX,
+        .minute_us = minute_us,
+        .first_minute = first_minute,
+        .minutes = minutes + 1,
+        .result = result,
+    };
+    timecode_impair_init(&run.impair, config, run_rx_edge, &run);
+    timecode_rx_init(&run.rx, synth->fmt);
+
+    // the minute before, then the minutes whose frames are counted, then the marker that ends the last frame and
+    // the pulse that confirms it
+    uint64_t t = RUN_START_US;
+    for (int i = 0; i <= minutes + 1; i++) {
+        minute_us[i] = t;
+        if (i == minutes + 1) {
+            run.skip_after_us = t + 2000000;
+        }
+        t += timecode_synth_minute(synth, first_minute + 60 * (i - 1), t, run_synth_edge, &run);
+    }
+    free(minute_us);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+// Receiver impairments for the synthesized time code edges: pulse edge jitter, spurious glitches, missing pulses,
+// fading periods in which only noise comes out of the receiver, and a frequency error of the receiver clock. Sits
+// between timecode_synth_minute() and the decoder as an edge callback, deterministic for a given seed.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "timecode_synth.h"
+
+typedef struct {
+    uint32_t jitter_us;     // each edge moves by a uniform random amount in [-jitter, +jitter]
+    double glitches_per_s;  // spurious 5 to 40 ms pulses, or gaps within a pulse, at random times
+    double dropout;         // probability that a pulse is missing
+    double fades_per_hour;  // start rate of fades, during a fade there is only noise
+    uint32_t fade_s;        // length of a fade
+    double drift_ppm;       // the receiver clock runs fast by this amount
+    uint32_t seed;
+} timecode_impair_config_t;
+
+#define TIMECODE_IMPAIR_MAX_TOGGLES 64
+
+typedef struct {
+    timecode_impair_config_t config;
+    timecode_synth_edge_fn edge;
+    void *ctx;
+    uint32_t random;
+    bool started;
+    uint64_t origin_us;       // first input edge, the drift scales the time since then
+    uint64_t pulse_start_us;  // input start of the pulse in progress
+    uint64_t last_us;         // end of the last output window, all output before it was emitted
+    uint64_t next_glitch_us;
+    uint64_t fade_start_us;  // next or current fade
+    uint64_t fade_end_us;
+    uint64_t next_fade_noise_us;
+} timecode_impair_t;
+
+void timecode_impair_init(timecode_impair_t *impair, const timecode_impair_config_t *config,
+                          timecode_synth_edge_fn edge, void *ctx);
+
+// edge callback for timecode_synth_minute(), ctx is the timecode_impair_t
+void timecode_impair_edge(void *ctx, uint64_t time_us, bool active);
+
+// one receiver run: minutes from first_minute through impairments into timecode_rx
+typedef struct {
+    int minutes;                // minutes transmitted
+    int correct;                // minutes decoded with the right time and marker
+    int wrong;                  // valid frames with a wrong time or marker, the worst case for a server
+    int invalid;                // complete frames rejected by the decoder
+    int64_t first_correct_us;   // from the start of the run to the end of the first correct frame, -1 if none
+} timecode_impair_result_t;
+
+// the run starts start_offset_us into the minute before first_minute, i.e. at a random phase for a cold start
+void timecode_impair_run(const timecode_synth_t *synth, const timecode_impair_config_t *config, time_t first_minute,
+                         int minutes, uint64_t start_offset_us, timecode_impair_result_t *result);
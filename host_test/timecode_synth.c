@@ -0,0 +1,146 @@
+#include "timecode_synth.h"
+
+#include <string.h>
+
+#include "civil_time.h"
+
+// MSF "01": two short pulses, the second one starts here
+#define SPLIT_B_SECOND_PULSE_US 200000
+
+void timecode_synth_init(timecode_synth_t *synth, const timecode_format_t *fmt) {
+    *synth = (timecode_synth_t){.fmt = fmt};
+}
+
+// last Sunday of the month, 01:00 UTC
+static int64_t eu_switch(int32_t year, uint32_t month) {
+    int32_t last = civil_days_from_civil(year, month + 1, 1) - 1;
+    return ((int64_t)last - civil_weekday(last)) * CIVIL_SECONDS_PER_DAY + 3600;
+}
+
+bool timecode_synth_dst(const timecode_format_t *fmt, time_t utc) {
+    if (fmt->dst_offset_min == fmt->std_offset_min) {
+        return false;
+    }
+    struct tm tm;
+    civil_from_unix(utc, &tm);
+    int32_t year = tm.tm_year + 1900;
+    return utc >= eu_switch(year, 3) && utc < eu_switch(year, 10);
+}
+
+static int weekday(const timecode_format_t *fmt, int32_t days) {
+    int wday = civil_weekday(days);
+    return wday == 0 ? fmt->wday_sunday : wday;
+}
+
+static void set_bit(timecode_frame_t *frame, uint8_t channel, uint8_t bit, bool value) {
+    uint64_t *word = channel ? &frame->b : &frame->a;
+    *word = (*word & ~(1ULL << bit)) | ((uint64_t)value << bit);
+}
+
+// BCD weights: the largest weight that still fits, like the decoder adds them up
+static void set_field(const timecode_format_t *fmt, timecode_frame_t *frame, uint8_t field, int value) {
+    uint64_t used = 0;
+    while (value > 0) {
+        int best = -1;
+        for (int i = 0; i < fmt->bit_count; i++) {
+            const timecode_bit_t *bit = &fmt->bits[i];
+            if (bit->field == field && !(used & (1ULL << i)) && bit->weight <= value &&
+                (best < 0 || bit->weight > fmt->bits[best].weight)) {
+                best = i;
+            }
+        }
+        if (best < 0) {
+            return;
+        }
+        used |= 1ULL << best;
+        set_bit(frame, fmt->bits[best].channel, fmt->bits[best].bit, true);
+        value -= fmt->bits[best].weight;
+    }
+}
+
+static void set_parities(const timecode_format_t *fmt, timecode_frame_t *frame) {
+    for (int i = 0; i < fmt->parity_count; i++) {
+        const timecode_parity_t *parity = &fmt->parities[i];
+        uint64_t mask = (2ULL << parity->last) - (1ULL << parity->first);
+        int ones = __builtin_popcountll(frame->a & mask);
+        set_bit(frame, parity->parity_channel, parity->parity_bit, (ones & 1) != parity->odd);
+    }
+}
+
+void timecode_synth_set_field(const timecode_format_t *fmt, timecode_frame_t *frame, timecode_field_t field,
+                              int value) {
+    for (int i = 0; i < fmt->bit_count; i++) {
+        if (fmt->bits[i].field == field) {
+            set_bit(frame, fmt->bits[i].channel, fmt->bits[i].bit, false);
+        }
+    }
+    set_field(fmt, frame, field, value);
+    set_parities(fmt, frame);
+}
+
+static int minute_seconds(const timecode_synth_t *synth, time_t minute_utc) {
+    return synth->fmt->leap_announce_bit != 0 && minute_utc == synth->leap_minute ? 61 : 60;
+}
+
+void timecode_synth_frame(const timecode_synth_t *synth, time_t minute_utc, timecode_frame_t *frame) {
+    const timecode_format_t *fmt = synth->fmt;
+    // Unix time has no leap seconds, the marker after a leap minute is still 60 s later
+    time_t marker_utc = minute_utc + 60;
+    time_t encoded = fmt->minute_offset ? minute_utc : marker_utc;
+    bool dst = timecode_synth_dst(fmt, encoded);
+    int64_t local = encoded + 60 * (dst ? fmt->dst_offset_min : fmt->std_offset_min);
+    struct tm tm;
+    civil_from_unix(local, &tm);
+    int32_t days = civil_days_from_civil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+
+    *frame = (timecode_frame_t){.a = fmt->one_mask, .markers = fmt->marker_mask};
+    set_field(fmt, frame, TC_MINUTE, tm.tm_min);
+    set_field(fmt, frame, TC_HOUR, tm.tm_hour);
+    set_field(fmt, frame, TC_MDAY, tm.tm_mday);
+    set_field(fmt, frame, TC_MONTH, tm.tm_mon + 1);
+    set_field(fmt, frame, TC_YDAY, tm.tm_yday + 1);
+    set_field(fmt, frame, TC_YEAR, tm.tm_year + 1900 - fmt->century);
+    set_field(fmt, frame, TC_WDAY, weekday(fmt, days));
+    set_field(fmt, frame, TC_DST, dst);
+    set_field(fmt, frame, TC_STD, !dst);
+    if (fmt->leap_announce_bit != 0 && synth->leap_minute != 0 && minute_utc > synth->leap_minute - 3600 &&
+        minute_utc <= synth->leap_minute) {
+        set_bit(frame, 0, fmt->leap_announce_bit, true);
+    }
+    set_parities(fmt, frame);
+}
+
+static uint32_t pulse_width(const timecode_format_t *fmt, uint8_t symbol) {
+    for (int i = 0; i < fmt->pulse_class_count; i++) {
+        if (fmt->pulse_classes[i].symbol == symbol) {
+            return (fmt->pulse_classes[i].min_us + fmt->pulse_classes[i].max_us) / 2;
+        }
+    }
+    return 0;
+}
+
+uint64_t timecode_synth_minute(const timecode_synth_t *synth, time_t minute_utc, uint64_t start_us,
+                               timecode_synth_edge_fn edge, void *ctx) {
+    const timecode_format_t *fmt = synth->fmt;
+    int seconds = minute_seconds(synth, minute_utc);
+    timecode_frame_t frame;
+    timecode_synth_frame(synth, minute_utc, &frame);
+    // formats with a minute gap leave out the pulse of the last second
+    int pulses = fmt->marker_run == 0 ? seconds - 1 : seconds;
+    for (int s = 0; s < pulses; s++) {
+        uint64_t t = start_us + s * 1000000ULL;
+        uint8_t symbol = ((frame.markers >> s) & 1) ? TC_SYM_MARKER
+                                                    : ((frame.a >> s) & 1) | (((frame.b >> s) & 1) << 1);
+        if (symbol == TC_SYM_B && (fmt->flags & TC_FLAG_SPLIT_B)) {
+            uint32_t width = pulse_width(fmt, 0);
+            edge(ctx, t, true);
+            edge(ctx, t + width, false);
+            edge(ctx, t + SPLIT_B_SECOND_PULSE_US, true);
+            edge(ctx, t + SPLIT_B_SECOND_PULSE_US + width, false);
+            continue;
+        }
+        edge(ctx, t, true);
+        edge(ctx, t + pulse_width(fmt, symbol), false);
+    }
+    return seconds * 1000000ULL;
+}
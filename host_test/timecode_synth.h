@@ -0,0 +1,38 @@
+#pragma once
+
+// Time code synthesizer for the host tests: encodes UTC minutes into the frames of a station format (the same
+// timecode_format_t tables the decoder uses) and emits the receiver edges of each second. Local time follows the
+// EU summer time rule for formats with a separate DST offset (DCF77, MSF), leap seconds are inserted for formats
+// with a leap second announcement bit (DCF77). The edges are ideal, timecode_impair.h adds the impairments of a
+// real receiver.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "timecode.h"
+
+typedef struct {
+    const timecode_format_t *fmt;
+    time_t leap_minute;  // UTC start of a minute with 61 seconds, 0 for none, announced during the hour before
+} timecode_synth_t;
+
+// edge callback, active is true at the start of a pulse (receiver polarity already applied)
+typedef void (*timecode_synth_edge_fn)(void *ctx, uint64_t time_us, bool active);
+
+void timecode_synth_init(timecode_synth_t *synth, const timecode_format_t *fmt);
+
+// true if the station transmits summer time at this UTC time
+bool timecode_synth_dst(const timecode_format_t *fmt, time_t utc);
+
+// the frame transmitted during the minute starting at minute_utc, it ends with the marker of the next minute
+void timecode_synth_frame(const timecode_synth_t *synth, time_t minute_utc, timecode_frame_t *frame);
+
+// replaces one field of a frame and corrects the parity bits, e.g. to build frames with invalid dates
+void timecode_synth_set_field(const timecode_format_t *fmt, timecode_frame_t *frame, timecode_field_t field,
+                              int value);
+
+// emits the edges of the minute starting at minute_utc, second 0 starts at start_us. Returns the length of the
+// minute in µs, 61 s for the leap minute.
+uint64_t timecode_synth_minute(const timecode_synth_t *synth, time_t minute_utc, uint64_t start_us,
+                               timecode_synth_edge_fn edge, void *ctx);
@@ -0,0 +1,56 @@
+#include "virtual_clock.h"
+
+static int64_t virtual_monotonic_us(void *ctx) { return ((virtual_clock_t *)ctx)->monotonic_us; }
+
+static void virtual_realtime(void *ctx, struct timeval *tv) {
+    const virtual_clock_t *clock = ctx;
+    tv->tv_sec = clock->realtime_us / 1000000;
+    tv->tv_usec = clock->realtime_us % 1000000;
+}
+
+static void virtual_step(void *ctx, int64_t offset_us) {
+    virtual_clock_t *clock = ctx;
+    clock->realtime_us += offset_us;
+    clock->slew_remaining_us = 0;
+}
+
+static void virtual_slew(void *ctx, int64_t offset_us) {
+    // like adjtime() a new slew replaces the one in progress
+    ((virtual_clock_t *)ctx)->slew_remaining_us = offset_us;
+}
+
+static int64_t virtual_slew_remaining_us(void *ctx) { return ((virtual_clock_t *)ctx)->slew_remaining_us; }
+
+void virtual_clock_init(virtual_clock_t *clock, int64_t realtime_us) {
+    *clock = (virtual_clock_t){
+        .monotonic_us = 0,
+        .realtime_us = realtime_us,
+        .backend =
+            {
+                .monotonic_us = virtual_monotonic_us,
+                .realtime = virtual_realtime,
+                .step = virtual_step,
+                .slew = virtual_slew,
+                .slew_remaining_us = virtual_slew_remaining_us,
+                .ctx = clock,
+            },
+    };
+}
+
+void virtual_clock_install(virtual_clock_t *clock) { timebase_set_backend(&clock->backend); }
+
+void virtual_clock_advance(virtual_clock_t *clock, int64_t us) {
+    clock->monotonic_us += us;
+    clock->drift_residual_us += us * clock->drift_ppm / 1e6;
+    int64_t drift = (int64_t)clock->drift_residual_us;
+    clock->drift_residual_us -= drift;
+    int64_t max_slew = us * VIRTUAL_CLOCK_SLEW_PPM / 1000000;
+    int64_t slew = clock->slew_remaining_us;
+    if (slew > max_slew) {
+        slew = max_slew;
+    } else if (slew < -max_slew) {
+        slew = -max_slew;
+    }
+    clock->slew_remaining_us -= slew;
+    clock->realtime_us += us + drift + slew;
+}
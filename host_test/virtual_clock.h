@@ -0,0 +1,27 @@
+#pragma once
+
+// Virtual clock for the host tests: a timebase backend whose time only moves when the test advances it. Slews are
+// applied at 500 ppm like adjtime() on Linux, the oscillator can be given a frequency error.
+
+#include <stdint.h>
+
+#include "timebase.h"
+
+typedef struct {
+    int64_t monotonic_us;
+    int64_t realtime_us;        // UTC in µs since 1970
+    int64_t slew_remaining_us;  // correction not yet applied by the slew
+    double drift_ppm;           // realtime runs fast by this amount
+    double drift_residual_us;
+    timebase_backend_t backend;
+} virtual_clock_t;
+
+#define VIRTUAL_CLOCK_SLEW_PPM 500
+
+void virtual_clock_init(virtual_clock_t *clock, int64_t realtime_us);
+
+// installs the clock as the timebase backend
+void virtual_clock_install(virtual_clock_t *clock);
+
+// moves both clocks forward, the realtime clock with drift and slew applied
+void virtual_clock_advance(virtual_clock_t *clock, int64_t us);
@@ -14,12 +14,21 @@
 #include "esp_log.h"
 #include "esp_netif.h"
 #include "ethernet_init.h"
+#include "eth_rx_timestamp.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "lwip/ip_addr.h"
+#include "mem_budget.h"
+#include "nvs_flash.h"
+#include "prof.h"
+#include "roughtime.h"
 #include "sdkconfig.h"
+#include "synclog.h"
+#include "timebase_hires.h"
 #include "udp_server_task.h"
 #include "dcf77.h"
+#include "ptp_server.h"
+#include "time_source.h"
 
 static const char *TAG = "eth_example";
 
@@ -64,6 +73,18 @@ static void got_ip_event_handler(void *arg, esp_event_base_t event_base, int32_t
 }
 
 void app_main(void) {
+    // NVS holds the NTP authentication keys
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(ret);
+#if CONFIG_TIMEBASE_HIRES
+    // first, it measures its read cost while nothing else is running
+    timebase_hires_start();
+#endif
+
     // Initialize Ethernet driver
     uint8_t eth_port_cnt = 0;
     esp_eth_handle_t *eth_handles;
@@ -86,6 +107,10 @@ void app_main(void) {
         eth_netif_glues = esp_eth_new_netif_glue(eth_handles[0]);
         // Attach Ethernet driver to TCP/IP stack
         ESP_ERROR_CHECK(esp_netif_attach(eth_netif, eth_netif_glues));
+#if CONFIG_EXAMPLE_ETH_RX_TIMESTAMP
+        // after the glue, the hook takes over its input path
+        ESP_ERROR_CHECK(eth_rx_timestamp_attach(eth_handles[0], eth_netif));
+#endif
 
         // static IP start
         //ESP_ERROR_CHECK(esp_netif_dhcpc_stop(eth_netif));
@@ -106,6 +131,29 @@ void app_main(void) {
     // Start Ethernet driver state machine
     ESP_ERROR_CHECK(esp_eth_start(eth_handles[0]));
 
-    xTaskCreatePinnedToCore(dcf77, "dcf77", 4096, NULL, 5, NULL, 0);
-    xTaskCreatePinnedToCore(udp_server_task, "udp_server", 4096, NULL, 5, NULL, 1);
+#if CONFIG_CLOCK_SELECT
+    // before the sources, so their first reports are not lost
+    MEM_BUDGET_CREATE_TASK(time_source_task, "time_source", CONFIG_MEM_BUDGET_TIME_SOURCE_STACK, 6, 0);
+    MEM_BUDGET_CREATE_TASK(ntp_upstream_task, "ntp_upstream", CONFIG_MEM_BUDGET_NTP_UPSTREAM_STACK, 4, 0);
+#endif
+    MEM_BUDGET_CREATE_TASK(dcf77, "dcf77", CONFIG_MEM_BUDGET_DCF77_STACK, 5, 0);
+    MEM_BUDGET_CREATE_TASK(udp_server_task, "udp_server", CONFIG_MEM_BUDGET_NTP_SERVER_STACK, 5, 1);
+#if CONFIG_NTP_SERVER_BROADCAST
+    // higher priority than the unicast server to keep the broadcast period steady
+    MEM_BUDGET_CREATE_TASK(ntp_broadcast_task, "ntp_broadcast", CONFIG_MEM_BUDGET_NTP_BROADCAST_STACK, 6, 1);
+#endif
+#if CONFIG_PTP_GRANDMASTER
+    MEM_BUDGET_CREATE_TASK(ptp_server_task, "ptp_server", CONFIG_MEM_BUDGET_PTP_STACK, 7, 1);
+#endif
+#if CONFIG_ROUGHTIME
+    // below the NTP server, signing a batch must not delay NTP responses
+    MEM_BUDGET_CREATE_TASK(roughtime_task, "roughtime", CONFIG_MEM_BUDGET_ROUGHTIME_STACK, 4, 1);
+#endif
+#if CONFIG_SYNCLOG
+    MEM_BUDGET_CREATE_TASK(synclog_task, "synclog", CONFIG_MEM_BUDGET_SYNCLOG_STACK, 2, 0);
+#endif
+#if CONFIG_PROF
+    prof_start_reporting();
+#endif
+    mem_budget_startup_done();
 }
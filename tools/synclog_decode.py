@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Decode the sync history log (components/synclog) from a partition image.
+
+Read the partition from the device first, e.g.
+    parttool.py read_partition --partition-name synclog --output synclog.bin
+then
+    synclog_decode.py synclog.bin [--csv]
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+from datetime import datetime, timezone
+
+# synclog_format.h
+SECTOR_SIZE = 4096
+ENTRY = struct.Struct('<IIiIHBBBBBBII')
+SEQ_FREE = 0xFFFFFFFF
+FLAGS = ((0x01, 'sync'), (0x02, 'holdover'), (0x04, 'stepped'), (0x08, 'boot'))
+FIELDS = ('seq', 'time', 'offset_us', 'root_dispersion_us', 'requests', 'frames_valid', 'frames_invalid',
+          'pulse_quality', 'flags', 'stratum', 'reserved', 'refid', 'crc')
+
+
+def refid_str(refid, stratum):
+    raw = refid.to_bytes(4, 'big')
+    if stratum <= 1:
+        return raw.rstrip(b'\0').decode('ascii', 'replace')
+    return '.'.join(str(b) for b in raw)
+
+
+def entries(image):
+    for offset in range(0, len(image) - ENTRY.size + 1, ENTRY.size):
+        raw = image[offset:offset + ENTRY.size]
+        entry = dict(zip(FIELDS, ENTRY.unpack(raw)))
+        if entry['seq'] == SEQ_FREE:
+            continue
+        if zlib.crc32(raw[:-4]) != entry['crc']:
+            print(f'# bad CRC at offset {offset:#x}', file=sys.stderr)
+            continue
+        yield entry
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('image', type=argparse.FileType('rb'))
+    parser.add_argument('--csv', action='store_true', help='comma separated output')
+    args = parser.parse_args()
+
+    image = args.image.read()
+    if len(image) % SECTOR_SIZE:
+        print('# image is not a multiple of the sector size', file=sys.stderr)
+    log = sorted(entries(image), key=lambda e: e['seq'])
+
+    columns = ('seq', 'utc', 'offset_us', 'disp_us', 'requests', 'frames', 'quality', 'stratum', 'refid', 'flags')
+    sep = ',' if args.csv else '\t'
+    print(sep.join(columns))
+    last_seq = None
+    for e in log:
+        if last_seq is not None and e['seq'] != last_seq + 1 and not args.csv:
+            print(f'# {e["seq"] - last_seq - 1} entries missing')
+        last_seq = e['seq']
+        utc = datetime.fromtimestamp(e['time'], timezone.utc).strftime('%Y-%m-%d %H:%M:%S')
+        quality = '' if e['pulse_quality'] == 255 else str(e['pulse_quality'])
+        flags = '|'.join(name for bit, name in FLAGS if e['flags'] & bit)
+        print(sep.join(str(v) for v in (e['seq'], utc, e['offset_us'], e['root_dispersion_us'], e['requests'],
+                                        f'{e["frames_valid"]}/{e["frames_invalid"]}', quality, e['stratum'],
+                                        refid_str(e['refid'], e['stratum']), flags)))
+
+    if log and not args.csv:
+        minutes = len(log)
+        synced = sum(1 for e in log if e['flags'] & 0x01 and not e['flags'] & 0x02)
+        print(f'# {minutes} minutes, synchronized {100 * synced / minutes:.1f} %, '
+              f'{sum(e["requests"] for e in log)} requests, {sum(1 for e in log if e["flags"] & 0x08)} boots')
+
+
+if __name__ == '__main__':
+    main()